@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/// Bounds and target for adaptive block batching.
+struct AdaptiveBatchOptions {
+  /// Desired time from admission to commit for an audit.
+  double target_latency_ms = 150.0;
+
+  size_t min_batch     = 1;
+  size_t max_batch     = 5000;
+  int    min_linger_ms = 5;
+  int    max_linger_ms = 1000;
+
+  /// Time constant of the arrival-rate average.
+  double rate_window_ms = 1000.0;
+
+  /// Weight of the newest round-trip sample in the round-time model.
+  double round_alpha = 0.2;
+};
+
+/// Chooses block size and linger time from the observed audit arrival rate
+/// and propose/commit round-trip time.
+///
+/// Round time is modelled as fixed_ms + per_audit_ms * n, fitted by an
+/// exponentially weighted regression over past rounds. The linger is the
+/// largest wait such that linger + round(rate * linger) meets the target;
+/// the batch is what arrives in that time, raised if needed so that the
+/// leader keeps up with arrivals, and capped so one round fits the target.
+class AdaptiveBatcher {
+public:
+  struct Stats {
+    double   arrival_rate_per_s = 0.0;
+    double   round_ms           = 0.0;   // average propose+commit time
+    double   fixed_ms           = 0.0;   // model intercept
+    double   per_audit_ms       = 0.0;   // model slope
+    size_t   batch_size         = 0;     // current choice
+    int      linger_ms          = 0;     // current choice
+    uint64_t rounds             = 0;
+  };
+
+  explicit AdaptiveBatcher(AdaptiveBatchOptions opts = {});
+
+  /// Feed a monotonically increasing count of admitted audits.
+  void ObserveArrivals(uint64_t admitted_total,
+                       std::chrono::steady_clock::time_point now);
+
+  /// Feed the propose+commit time of a block carrying `audits` audits.
+  void ObserveRound(size_t audits, std::chrono::steady_clock::duration elapsed);
+
+  /// Number of pending audits that should trigger (and cap) a block.
+  size_t BatchSize() const;
+
+  /// Longest time to wait for BatchSize() audits before cutting anyway.
+  std::chrono::milliseconds Linger() const;
+
+  Stats GetStats() const;
+
+private:
+  void recomputeLocked();
+
+  mutable std::mutex   mu_;
+  AdaptiveBatchOptions opts_;
+
+  // Arrival rate, audits per ms
+  bool     seen_arrivals_ = false;
+  uint64_t last_total_    = 0;
+  std::chrono::steady_clock::time_point last_at_;
+  double   rate_          = 0.0;
+
+  // Weighted means for the round-time regression
+  uint64_t rounds_ = 0;
+  double   mean_n_  = 0.0;
+  double   mean_t_  = 0.0;
+  double   mean_nn_ = 0.0;
+  double   mean_nt_ = 0.0;
+  double   fixed_ms_     = 0.0;
+  double   per_audit_ms_ = 0.0;
+
+  size_t   batch_     = 1;
+  double   linger_ms_ = 0.0;
+};
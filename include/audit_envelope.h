@@ -0,0 +1,44 @@
+#pragma once
+
+#include "common.pb.h"     // common::FileAudit, common::AuditEnvelope
+#include "merkle_tree.h"   // Digest, MerkleMode
+
+#include <google/protobuf/repeated_field.h>
+#include <string>
+#include <vector>
+
+/// Batch-signed audits. A client signs the hex Merkle root over its
+/// audits' canonical encodings (CanonicalAudit) once, instead of every
+/// audit. The node opening the envelope gives each audit the signature,
+/// the key, the root and the sibling path of its leaf, so an audit stays
+/// verifiable and provable on its own after it is split off into the
+/// mempool, gossip and blocks.
+///
+/// Envelope trees always combine nodes in binary mode, whatever
+/// merkle_mode the chain uses.
+constexpr MerkleMode kEnvelopeMerkleMode = MerkleMode::kBinary;
+
+/// Hex Merkle root over `audits`, the string the client signs; empty if
+/// there are none or one is not valid UTF-8. `leaves` (optional) receives
+/// the leaf digests.
+std::string EnvelopeRoot(
+  const google::protobuf::RepeatedPtrField<common::FileAudit>& audits,
+  std::vector<Digest>* leaves = nullptr);
+
+/// Sibling path of every leaf (leaf level first), odd levels duplicating
+/// their last node as the block Merkle trees do.
+std::vector<std::vector<Digest>> MerklePaths(std::vector<Digest> leaves,
+                                             MerkleMode mode);
+
+/// Split `envelope` into self-contained audits, appended to `out`.
+/// Returns the root the client's signature must cover, or "" if the
+/// envelope is empty or an audit is not valid UTF-8. Does not check the
+/// signature.
+std::string OpenEnvelope(
+  const common::AuditEnvelope& envelope,
+  google::protobuf::RepeatedPtrField<common::FileAudit>* out);
+
+/// True if the audit's envelope_path leads from `payload` (its canonical
+/// encoding) to envelope_root. False for audits not from an envelope.
+bool CheckEnvelopePath(const common::FileAudit& audit,
+                       const std::string& payload);
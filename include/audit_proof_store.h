@@ -0,0 +1,78 @@
+#pragma once
+
+#include "block_chain.pb.h"   // blockchain::Block
+#include "merkle_tree.h"      // Digest, MerkleMode
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Merkle inclusion proofs for committed audits.
+///
+/// Every committed block's tree levels are written once next to its JSON
+/// as "<dir>/block_N.merkle", together with its req_ids, and a
+/// req_id -> (block, leaf) index is kept in memory (rebuilt from those
+/// files on startup). A proof reads one node per level straight from the
+/// stored levels; nothing is rehashed per request.
+class AuditProofStore {
+public:
+  struct Proof {
+    int64_t             block_id   = 0;
+    std::string         block_hash;
+    std::string         merkle_root;
+    uint64_t            leaf_index = 0;
+    Digest              leaf{};
+    std::vector<Digest> siblings;   // leaf level first
+  };
+
+  /// `dir` is the block directory (e.g. "../blocks").
+  AuditProofStore(std::string dir, MerkleMode mode);
+
+  /// Index blocks [0, last_id] from their sidecars, writing any missing or
+  /// stale sidecar from the block's JSON file.
+  void Load(int64_t last_id);
+
+  /// Write the sidecar for a committed block and index its audits.
+  /// `leaves` (canonical-audit digests) are hashed here if null. Returns
+  /// false if the levels can't be written or don't match merkle_root.
+  bool Record(const blockchain::Block& block,
+              const std::vector<Digest>* leaves = nullptr);
+
+  /// Proof for the committed audit `req_id`; false if it isn't indexed or
+  /// its sidecar can't be read.
+  bool GetProof(const std::string& req_id, Proof* out) const;
+
+  /// True if `req_id` is in an indexed (committed) block.
+  bool Contains(const std::string& req_id) const;
+
+  MerkleMode Mode() const { return mode_; }
+
+  /// Number of indexed audits.
+  size_t Size() const;
+
+private:
+  struct BlockInfo {
+    std::string hash;
+    std::string merkle_root;
+    uint64_t    leaf_count    = 0;
+    uint64_t    levels_offset = 0;   // file offset of the leaf level
+  };
+
+  struct LeafRef {
+    int64_t  block_id;
+    uint64_t index;
+  };
+
+  std::string sidecarPath(int64_t block_id) const;
+  bool loadSidecar(int64_t block_id);
+  void indexLocked(int64_t block_id, BlockInfo info,
+                   const std::vector<std::string>& req_ids);
+
+  std::string dir_;
+  MerkleMode  mode_;
+
+  mutable std::mutex                         mu_;
+  std::unordered_map<int64_t, BlockInfo>     blocks_;
+  std::unordered_map<std::string, LeafRef>   index_;
+};
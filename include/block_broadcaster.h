@@ -0,0 +1,147 @@
+#pragma once
+
+#include "block_chain.grpc.pb.h"   // blockchain::Block, BlockChainService
+#include "peer_registry.h"
+
+#include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Sends a leader's ProposeBlock and CommitBlock RPCs to every peer at
+/// once over the gRPC callback API.
+///
+/// Each peer has its own lane that starts calls in the order they were
+/// queued. Up to `window` proposals may be in flight on a lane at once
+/// (pipelined blocks); a commit waits for every earlier call on its lane
+/// to finish, so a peer applies commits in order and after its vote.
+/// Lanes are independent: a slow or dead peer only delays itself. A
+/// proposal that is still queued when its deadline passes counts as a no
+/// vote and is never sent.
+///
+/// With `compact` a proposal carries only the header and the block's
+/// req_ids; a peer rebuilds the block from its mempool and names the
+/// audits it lacks, which are then sent once. A peer that can't rebuild
+/// the block, or doesn't know the compact RPCs, gets the full block. A
+/// peer that voted on a compact proposal is committed with an (id, hash)
+/// ConfirmBlock.
+///
+/// With a PeerRegistry, each call's outcome and round-trip time are
+/// reported to it, so a peer that stops answering proposals is marked
+/// down for the other subsystems too.
+class BlockBroadcaster {
+public:
+  using StubList =
+    std::vector<std::unique_ptr<blockchain::BlockChainService::Stub>>;
+
+  /// Votes on one proposal.
+  class Ballot {
+  public:
+    Ballot(size_t peers, size_t needed,
+           std::chrono::system_clock::time_point deadline)
+      : peers_(peers), needed_(needed), deadline_(deadline) {}
+
+    /// Block until a majority is reached or out of reach (at most until
+    /// shortly after the proposal deadline); true if accepted.
+    bool Wait();
+
+    void Vote(bool yes);
+
+    /// "<yes> yes, <no> no of <peers> peers (quorum <needed>)"
+    std::string Summary();
+
+  private:
+    bool decidedLocked() const {
+      return yes_ >= needed_ || no_ > peers_ - needed_;
+    }
+
+    std::mutex                            mu_;
+    std::condition_variable               cv_;
+    size_t                                peers_;
+    size_t                                needed_;
+    std::chrono::system_clock::time_point deadline_;
+    size_t                                yes_ = 0;
+    size_t                                no_  = 0;
+  };
+
+  BlockBroadcaster(StubList& stubs,
+                   std::chrono::milliseconds propose_timeout,
+                   std::chrono::milliseconds commit_timeout,
+                   size_t window = 1,
+                   bool compact = true,
+                   std::shared_ptr<PeerRegistry> peers = nullptr);
+
+  /// Drops queued calls and waits for the ones in flight.
+  ~BlockBroadcaster();
+
+  BlockBroadcaster(const BlockBroadcaster&)            = delete;
+  BlockBroadcaster& operator=(const BlockBroadcaster&) = delete;
+
+  /// Propose `block` to all peers. Returns true as soon as a majority of
+  /// the cluster (this node included) has voted yes, and false as soon as
+  /// enough peers have voted no, failed or timed out that a majority is
+  /// out of reach. Later votes are still collected.
+  bool Propose(std::shared_ptr<const blockchain::Block> block);
+
+  /// Send the proposal and return its ballot without waiting.
+  std::shared_ptr<Ballot> StartProposal(
+    std::shared_ptr<const blockchain::Block> block);
+
+  /// Queue CommitBlock for `block` and return without waiting. A peer
+  /// only gets the commit if it voted yes on the proposal; the others
+  /// catch up through block sync.
+  void Commit(std::shared_ptr<const blockchain::Block> block);
+
+  /// Peer votes needed for a majority.
+  size_t Quorum() const { return (lanes_.size() + 1) / 2; }
+
+private:
+  struct Op {
+    bool                                     commit = false;
+    std::shared_ptr<const blockchain::Block> block;
+    std::shared_ptr<Ballot>                  ballot;     // proposals
+    std::chrono::system_clock::time_point    deadline;   // proposals
+    std::shared_ptr<const blockchain::CompactBlock> compact;  // proposals
+  };
+
+  struct Lane {
+    size_t                               index;
+    blockchain::BlockChainService::Stub* stub;
+    std::deque<Op>                       ops;
+    size_t                               busy = 0;     // calls in flight
+    bool                                 compact;      // peer has the RPCs
+    // (id, hash) of blocks this peer voted yes on and hasn't been sent
+    std::set<std::pair<int64_t, std::string>> accepted;
+  };
+
+  void pump(Lane& lane);
+  void send(Lane& lane, Op op);
+  void proposeCompact(Lane& lane, Op op,
+                      std::shared_ptr<const blockchain::CompactBlock> msg,
+                      bool filled);
+  void proposeFull(Lane& lane, Op op);
+  void tally(Lane& lane, const Op& op, bool yes, const std::string& why);
+  void commitFull(Lane& lane, Op op);
+  void report(Lane& lane, const grpc::Status& status,
+              std::chrono::steady_clock::time_point started);
+  void finish(Lane& lane);
+
+  std::chrono::milliseconds          propose_timeout_;
+  std::chrono::milliseconds          commit_timeout_;
+  size_t                             window_;
+  bool                               compact_;
+  std::shared_ptr<PeerRegistry>      peers_;
+  std::vector<std::unique_ptr<Lane>> lanes_;
+
+  std::mutex              mu_;
+  std::condition_variable idle_cv_;
+  size_t                  inflight_ = 0;
+  bool                    stopping_ = false;
+};
@@ -2,31 +2,48 @@
 
 #include "common.grpc.pb.h"        // common::FileAudit
 #include "block_chain.grpc.pb.h"   // blockchain::Block, BlockVoteResponse, BlockCommitResponse
+#include "adaptive_batcher.h"
+#include "audit_proof_store.h"
+#include "block_broadcaster.h"
 #include "chain_manager.h"
 #include "leader_config.h"
 #include "mempool_manager.h"
-#include "merkle_tree.h"
 
 #include <grpcpp/grpcpp.h>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
-/// Periodically triggers block proposal when thresholds are met.
+/// Triggers block proposal when thresholds are met: as soon as the mempool
+/// reaches batch_size, or exactly when batch_interval_s elapses. With
+/// adaptive_batching both thresholds come from an AdaptiveBatcher instead.
+///
+/// Each tick drains the backlog as back-to-back blocks of at most
+/// max_block_audits audits and max_block_bytes serialized bytes (and, when
+/// adaptive, the batcher's batch size), cut from the front of the mempool
+/// together with its cached Merkle root. Each block is proposed to all
+/// peers concurrently and accepted on a majority vote; its commits are
+/// sent without holding up the next block.
+///
+/// Up to pipeline_depth blocks are in flight: each is chained to the last
+/// proposed block and its audits are reserved in the mempool. A committer
+/// thread finishes them strictly in order; a rejected block is rolled
+/// back together with every block proposed after it.
 class BlockScheduler {
 public:
-  using StubList =
-    std::vector<std::unique_ptr<blockchain::BlockChainService::Stub>>;
-
   BlockScheduler(
     std::shared_ptr<MempoolManager> mempool,
     ChainManager&                    chain,
-    StubList&                        stubs,
+    std::shared_ptr<PeerRegistry>    peers,
     const LeaderConfig&              cfg,
-    std::function<bool()>            isLeaderFn
+    std::function<bool()>            isLeaderFn,
+    std::shared_ptr<AuditProofStore> proofs
   );
 
   ~BlockScheduler();
@@ -37,16 +54,47 @@ public:
   /// Stops the scheduler (and joins the thread).
   void stop();
 
+  /// Current adaptive batching choices and inputs (zeros when disabled).
+  AdaptiveBatcher::Stats batchStats() const;
+
 private:
+  /// A proposed block waiting for its vote.
+  struct InFlight {
+    std::shared_ptr<blockchain::Block>        block;
+    std::shared_ptr<BlockBroadcaster::Ballot> ballot;
+    std::vector<std::string>                  ids;
+    std::vector<Digest>                       leaves;
+    std::chrono::steady_clock::time_point     started;
+  };
+
   void loop();
-  void createAndBroadcastBlock(std::vector<common::FileAudit> pending);
+  void commitLoop();
+  bool sleepUntil(std::chrono::steady_clock::time_point deadline);
+  bool waitForSlot();
+  bool proposeBlock(MempoolManager::Prefix cut);
+  void commitBlock(InFlight& f);
 
   std::shared_ptr<MempoolManager> mempool_;
   ChainManager&                   chain_;
-  StubList&                       stubs_;
+  std::shared_ptr<PeerRegistry>   peers_;
   const LeaderConfig&             cfg_;
   std::function<bool()>           isLeaderFn_;
+  std::unique_ptr<AdaptiveBatcher> batcher_;   // null unless adaptive
+  std::shared_ptr<AuditProofStore> proofs_;
+  BlockBroadcaster                 broadcaster_;
 
   std::thread                     thr_;
+  std::thread                     committer_;
   std::atomic<bool>               running_{false};
+  std::mutex                      mu_;
+  std::condition_variable         cv_;       // interrupts sleepUntil()
+
+  // Pipeline state, guarded by mu_
+  std::condition_variable         flight_cv_;
+  std::deque<InFlight>            inflight_;     // proposal order
+  int64_t                         tip_id_ = -1;  // last proposed block
+  std::string                     tip_hash_;
+  bool                            committing_  = false;  // popped, not on chain
+  uint64_t                        generation_  = 0;   // bumped on rollback
+  bool                            rolled_back_ = false;
 };
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "server.h"          // FileAuditServiceImpl, BlockChainServiceImpl
+#include "rpc_executor.h"
+
+#include <grpcpp/grpcpp.h>
+#include <memory>
+
+/// Callback-API front ends of the two services. gRPC's threads only
+/// accept calls: each handler body runs on an RpcExecutor, and a full
+/// executor fails the call with RESOURCE_EXHAUSTED at once.
+///
+/// Control-plane calls (heartbeats, elections, block proposals and
+/// commits) and data-plane calls (submissions, gossip, anti-entropy, block
+/// and proof reads) get separate executors, so a burst of slow data calls
+/// cannot delay a heartbeat or a vote. A data call cancelled while queued
+/// (its deadline passed) is finished without running; control calls
+/// always run, as a vote or commit still matters after the caller gave up.
+
+/// SubmitAudit and SubmitAuditEnvelope run on the data-plane executor.
+/// SubmitAuditStream stays synchronous: a stream is long-lived, and its
+/// handler and reader thread block by design, so it keeps a thread of
+/// gRPC's sync pool for its lifetime.
+class FileAuditCallbackService final
+    : public fileaudit::FileAuditService::WithCallbackMethod_SubmitAudit<
+        fileaudit::FileAuditService::WithCallbackMethod_SubmitAuditEnvelope<
+          fileaudit::FileAuditService::Service>> {
+public:
+  FileAuditCallbackService(FileAuditServiceImpl& impl,
+                           std::shared_ptr<RpcExecutor> data);
+
+  grpc::ServerUnaryReactor* SubmitAudit(
+      grpc::CallbackServerContext* context,
+      const common::FileAudit* request,
+      fileaudit::FileAuditResponse* response) override;
+
+  grpc::ServerUnaryReactor* SubmitAuditEnvelope(
+      grpc::CallbackServerContext* context,
+      const common::AuditEnvelope* request,
+      fileaudit::AuditEnvelopeResponse* response) override;
+
+  grpc::Status SubmitAuditStream(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<fileaudit::FileAuditResponse,
+                               common::FileAudit>* stream) override;
+
+private:
+  FileAuditServiceImpl&        impl_;
+  std::shared_ptr<RpcExecutor> data_;
+};
+
+class BlockChainCallbackService final
+    : public blockchain::BlockChainService::CallbackService {
+public:
+  BlockChainCallbackService(BlockChainServiceImpl& impl,
+                            std::shared_ptr<RpcExecutor> control,
+                            std::shared_ptr<RpcExecutor> data);
+
+  // Data plane
+  grpc::ServerUnaryReactor* WhisperAuditRequest(
+      grpc::CallbackServerContext* context,
+      const common::FileAudit* request,
+      blockchain::WhisperResponse* response) override;
+
+  grpc::ServerUnaryReactor* WhisperAuditBatch(
+      grpc::CallbackServerContext* context,
+      const blockchain::WhisperBatch* request,
+      blockchain::WhisperBatchResponse* response) override;
+
+  grpc::ServerUnaryReactor* GetMempoolDigest(
+      grpc::CallbackServerContext* context,
+      const blockchain::MempoolDigestRequest* request,
+      blockchain::MempoolDigest* response) override;
+
+  grpc::ServerUnaryReactor* GetBucketIds(
+      grpc::CallbackServerContext* context,
+      const blockchain::BucketIdsRequest* request,
+      blockchain::BucketIds* response) override;
+
+  grpc::ServerUnaryReactor* FetchAudits(
+      grpc::CallbackServerContext* context,
+      const blockchain::FetchAuditsRequest* request,
+      blockchain::WhisperBatch* response) override;
+
+  grpc::ServerUnaryReactor* GetBlock(
+      grpc::CallbackServerContext* context,
+      const blockchain::GetBlockRequest* request,
+      blockchain::GetBlockResponse* response) override;
+
+  grpc::ServerUnaryReactor* GetAuditProof(
+      grpc::CallbackServerContext* context,
+      const blockchain::GetAuditProofRequest* request,
+      blockchain::GetAuditProofResponse* response) override;
+
+  // Control plane
+  grpc::ServerUnaryReactor* ProposeBlock(
+      grpc::CallbackServerContext* context,
+      const blockchain::Block* request,
+      blockchain::BlockVoteResponse* response) override;
+
+  grpc::ServerUnaryReactor* ProposeCompactBlock(
+      grpc::CallbackServerContext* context,
+      const blockchain::CompactBlock* request,
+      blockchain::BlockVoteResponse* response) override;
+
+  grpc::ServerUnaryReactor* CommitBlock(
+      grpc::CallbackServerContext* context,
+      const blockchain::Block* request,
+      blockchain::BlockCommitResponse* response) override;
+
+  grpc::ServerUnaryReactor* ConfirmBlock(
+      grpc::CallbackServerContext* context,
+      const blockchain::BlockCommitRef* request,
+      blockchain::BlockCommitResponse* response) override;
+
+  grpc::ServerUnaryReactor* SendHeartbeat(
+      grpc::CallbackServerContext* context,
+      const blockchain::HeartbeatRequest* request,
+      blockchain::HeartbeatResponse* response) override;
+
+  grpc::ServerUnaryReactor* TriggerElection(
+      grpc::CallbackServerContext* context,
+      const blockchain::TriggerElectionRequest* request,
+      blockchain::TriggerElectionResponse* response) override;
+
+  grpc::ServerUnaryReactor* NotifyLeadership(
+      grpc::CallbackServerContext* context,
+      const blockchain::NotifyLeadershipRequest* request,
+      blockchain::NotifyLeadershipResponse* response) override;
+
+private:
+  BlockChainServiceImpl&       impl_;
+  std::shared_ptr<RpcExecutor> control_;
+  std::shared_ptr<RpcExecutor> data_;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "common.pb.h"    // common::FileAudit
+#include <string>
+
+/// Canonical audit encoding: the compact, sorted-key JSON that clients sign
+/// and that Merkle leaves and block hashes are computed over,
+///
+///   {"access_type":N,"file_info":{"file_id":"..","file_name":".."},
+///    "req_id":"..","timestamp":N,"user_info":{"user_id":"..","user_name":".."}}
+///
+/// Byte-for-byte identical to nlohmann::ordered_json::dump() of those
+/// fields, but written straight into the caller's buffer with no DOM.
+/// Strings escape '"', '\\', \b \f \n \r \t and other control characters
+/// as \u00xx; all other UTF-8 passes through unchanged.
+
+/// Append the encoding of `audit` to `out`. Returns false (leaving `out`
+/// partially written) if a string field is not valid UTF-8.
+bool AppendCanonicalAudit(const common::FileAudit& audit, std::string* out);
+
+/// The encoding of `audit` as a new string; empty if it has invalid UTF-8.
+std::string CanonicalAudit(const common::FileAudit& audit);
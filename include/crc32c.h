@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// CRC-32C (Castagnoli) of `len` bytes, continuing from `crc`
+/// (pass 0 to start a new checksum).
+uint32_t Crc32c(const void* data, size_t len, uint32_t crc = 0);
@@ -4,6 +4,7 @@
 #include "election_state.h"
 #include "chain_manager.h"
 #include "mempool_manager.h"
+#include "peer_registry.h"
 #include "block_chain.grpc.pb.h"
 #include <grpcpp/grpcpp.h>
 #include <thread>
@@ -12,11 +13,13 @@
 #include <string>
 #include <chrono>
 
-/// Periodically checks heartbeats & triggers elections.
+/// Periodically checks heartbeats & triggers elections. Peers the
+/// PeerRegistry has down are not asked for votes or notified; they learn
+/// the leader from its heartbeats once they are back.
 class ElectionManager {
 public:
   ElectionManager(
-    const std::vector<std::string>& peers,
+    std::shared_ptr<PeerRegistry>   peers,
     const std::string& self_addr,
     std::shared_ptr<HeartbeatTable> hb_table,
     ElectionState&                 state,
@@ -34,8 +37,7 @@ public:
 private:
   void loop();
 
-  std::vector<std::unique_ptr<blockchain::BlockChainService::Stub>> stubs_;
-  std::vector<std::string> peer_addrs_;
+  std::shared_ptr<PeerRegistry> peers_;
   std::string              self_addr_;
   std::shared_ptr<HeartbeatTable> hb_table_;
   ElectionState&           state_;
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "common.pb.h"             // common::FileAudit
+#include "block_chain.grpc.pb.h"   // blockchain::BlockChainService
+#include "peer_registry.h"
+
+#include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct GossipOptions {
+  /// Audits queued per peer; once full the oldest are dropped (the
+  /// leader's compact proposals fill in whatever a follower never got).
+  size_t queue_limit = 10000;
+
+  /// Peers each audit is queued for, picked at random per audit; 0 sends
+  /// every audit to every peer. With a fanout, receivers relay audits new
+  /// to them (epidemic gossip), so a node's gossip traffic grows with the
+  /// fanout rather than the cluster size.
+  size_t fanout      = 0;
+
+  /// Audits coalesced into one WhisperAuditBatch call.
+  size_t max_batch   = 256;
+
+  /// Deadline of one batch call.
+  std::chrono::milliseconds rpc_timeout{1000};
+
+  /// Retry delay after a failed call, doubling up to max_backoff.
+  std::chrono::milliseconds min_backoff{50};
+  std::chrono::milliseconds max_backoff{5000};
+};
+
+/// Whispers admitted audits to peers in the background, so SubmitAudit
+/// only waits for the local mempool.
+///
+/// Each peer has its own bounded queue and sender thread. The sender
+/// drains its queue in batches of up to max_batch audits per
+/// WhisperAuditBatch call, and retries a failed batch with exponential
+/// backoff while new audits keep queueing behind it. A peer without the
+/// batch RPC is sent one WhisperAuditRequest per audit instead.
+///
+/// With a fanout each audit goes to that many random peers instead of all
+/// of them, preferring peers the PeerRegistry has up; anti-entropy
+/// (MempoolReconciler) repairs what the epidemic misses. A sender whose
+/// peer another subsystem marked down starts at max_backoff rather than
+/// timing out on the peer first.
+class GossipDispatcher {
+public:
+  struct PeerStats {
+    std::string addr;
+    size_t      depth    = 0;   // audits queued (including a batch in flight)
+    uint64_t    sent     = 0;   // audits delivered
+    uint64_t    dropped  = 0;   // audits evicted by a full queue
+    uint64_t    failures = 0;   // failed calls (each retried)
+  };
+
+  GossipDispatcher(std::shared_ptr<PeerRegistry> peers,
+                   GossipOptions opts = {});
+
+  /// Stops the senders; audits still queued are not sent.
+  ~GossipDispatcher();
+
+  GossipDispatcher(const GossipDispatcher&)            = delete;
+  GossipDispatcher& operator=(const GossipDispatcher&) = delete;
+
+  /// Launches one sender thread per peer.
+  void start();
+
+  /// Stops the senders (and joins them).
+  void stop();
+
+  /// Queue `audit` for every peer (or `fanout` random ones) and return
+  /// without waiting.
+  void Enqueue(const common::FileAudit& audit);
+
+  /// True with a fanout below the number of peers: receivers should relay.
+  bool Epidemic() const {
+    return opts_.fanout > 0 && opts_.fanout < peers_.size();
+  }
+
+  /// One entry per peer, in constructor order.
+  std::vector<PeerStats> GetStats() const;
+
+private:
+  struct Item {
+    uint64_t                                 seq;
+    std::shared_ptr<const common::FileAudit> audit;
+  };
+
+  struct Peer {
+    size_t           index;               // in the registry
+    std::deque<Item> queue;
+    PeerStats        stats;
+    bool             batch_rpc = true;    // peer serves WhisperAuditBatch
+    bool             dropping  = false;   // drop already logged
+    std::thread      thr;
+  };
+
+  void loop(Peer& p);
+  bool deliver(Peer& p, const std::vector<Item>& batch);
+
+  GossipOptions                      opts_;
+  std::shared_ptr<PeerRegistry>      registry_;
+  std::vector<std::unique_ptr<Peer>> peers_;
+
+  mutable std::mutex      mu_;
+  std::condition_variable cv_;
+  bool                    running_  = false;
+  uint64_t                next_seq_ = 0;
+  std::vector<size_t>     order_;      // peer indices, shuffled per audit
+  std::mt19937_64         rng_{std::random_device{}()};
+};
@@ -3,22 +3,28 @@
 #include "mempool_manager.h"
 #include "chain_manager.h"
 #include "election_state.h"
+#include "verified_audit_cache.h"
+#include "audit_proof_store.h"
+#include "peer_registry.h"
 #include <grpcpp/grpcpp.h>
 #include "block_chain.grpc.pb.h"
 #include <atomic>
 #include <thread>
 #include <chrono>
 
-/// Sends heartbeats periodically to peers.
+/// Sends heartbeats periodically to peers, reporting each one's outcome
+/// and round-trip time to the PeerRegistry.
 class HeartbeatManager {
 public:
   HeartbeatManager(
-    const std::vector<std::string>& peers,
+    std::shared_ptr<PeerRegistry>   peers,
     const std::string&              self_addr,
     ElectionState&                  state,
     std::shared_ptr<MempoolManager> mempool,
     ChainManager&                   chain,
-    std::shared_ptr<HeartbeatTable> table);
+    std::shared_ptr<HeartbeatTable> table,
+    std::shared_ptr<VerifiedAuditCache> audit_cache,
+    std::shared_ptr<AuditProofStore> proofs);
 
   ~HeartbeatManager();
   void start();
@@ -32,13 +38,14 @@ private:
                            int64_t startId,
                            int64_t endId);
 
-  std::vector<std::unique_ptr<blockchain::BlockChainService::Stub>> stubs_;
-  std::vector<std::string> peer_addrs_;
+  std::shared_ptr<PeerRegistry> peers_;
   std::string              self_addr_;
   ElectionState&           state_;
   std::shared_ptr<MempoolManager> mempool_;
   ChainManager&                   chain_;
   std::shared_ptr<HeartbeatTable> table_;
+  std::shared_ptr<VerifiedAuditCache> audit_cache_;
+  std::shared_ptr<AuditProofStore>    proofs_;
 
   std::atomic<bool>        running_{false};
   std::thread              thr_;
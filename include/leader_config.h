@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
-/// Loads leader.json { leader_addr, batch_size, batch_interval_s }.
+/// Loads leader.json { leader_addr, batch_size, batch_interval_s }
+/// plus optional tuning fields (defaults apply when absent).
 class LeaderConfig {
 public:
   /// Throws std::runtime_error on parse error or missing fields.
@@ -17,8 +19,172 @@ public:
   /// Seconds to wait before forcing a block.
   int getBatchIntervalSec() const { return batch_interval_s_; }
 
+  /// Upper bound on one block's serialized size ("max_block_bytes").
+  size_t getMaxBlockBytes() const { return max_block_bytes_; }
+
+  /// Upper bound on audits per block ("max_block_audits").
+  size_t getMaxBlockAudits() const { return max_block_audits_; }
+
+  /// Blocks the leader keeps proposed but not yet committed
+  /// ("pipeline_depth"); 1 = strictly one block at a time.
+  size_t getPipelineDepth() const { return pipeline_depth_; }
+
+  /// Propose blocks by req_id and commit by (id, hash) ("compact_blocks").
+  bool getCompactBlocks() const { return compact_blocks_; }
+
+  /// Distinct client public keys kept parsed ("pubkey_cache_size").
+  size_t getPubkeyCacheSize() const { return pubkey_cache_size_; }
+
+  /// Audits remembered as already signature-checked
+  /// ("verified_audit_cache_size").
+  size_t getVerifiedAuditCacheSize() const { return verified_audit_cache_size_; }
+
+  /// Threads verifying block signatures in parallel, 0 = one per core
+  /// ("crypto_threads").
+  size_t getCryptoThreads() const { return crypto_threads_; }
+
+  /// Merkle interior-node hashing, "hex" (compatible with existing
+  /// chains) or "binary" ("merkle_mode"). Must match across the cluster.
+  const std::string& getMerkleMode() const { return merkle_mode_; }
+
+  /// Mempool on-disk format, "json" or "binary" ("mempool_format").
+  const std::string& getMempoolFormat() const { return mempool_format_; }
+
+  /// Mempool log segment size before rolling ("mempool_segment_bytes").
+  size_t getMempoolSegmentBytes() const { return mempool_segment_bytes_; }
+
+  /// Live-record ratio below which a segment is compacted
+  /// ("mempool_compact_live_ratio").
+  double getMempoolCompactLiveRatio() const { return mempool_compact_live_ratio_; }
+
+  /// Compactor rescan period ("mempool_compact_interval_ms").
+  int getMempoolCompactIntervalMs() const { return mempool_compact_interval_ms_; }
+
+  /// Extra linger for mempool group commits
+  /// ("mempool_group_commit_window_us").
+  int getMempoolGroupCommitWindowUs() const { return mempool_group_commit_window_us_; }
+
+  /// fdatasync each mempool group commit ("mempool_fsync").
+  bool getMempoolFsync() const { return mempool_fsync_; }
+
+  /// Size blocks from arrival rate and round-trip time instead of the
+  /// static batch_size/batch_interval_s ("adaptive_batching").
+  bool getAdaptiveBatching() const { return adaptive_batching_; }
+
+  /// Admission-to-commit latency adaptive batching aims for
+  /// ("target_commit_latency_ms").
+  double getTargetCommitLatencyMs() const { return target_commit_latency_ms_; }
+
+  /// Block size bounds for adaptive batching
+  /// ("adaptive_min_batch", "adaptive_max_batch").
+  size_t getAdaptiveMinBatch() const { return adaptive_min_batch_; }
+  size_t getAdaptiveMaxBatch() const { return adaptive_max_batch_; }
+
+  /// Linger bounds for adaptive batching
+  /// ("adaptive_min_linger_ms", "adaptive_max_linger_ms").
+  int getAdaptiveMinLingerMs() const { return adaptive_min_linger_ms_; }
+  int getAdaptiveMaxLingerMs() const { return adaptive_max_linger_ms_; }
+
+  /// Audits queued per peer for gossip before the oldest are dropped
+  /// ("gossip_queue_limit").
+  size_t getGossipQueueLimit() const { return gossip_queue_limit_; }
+
+  /// Random peers each audit is gossiped to, 0 = all; with a fanout,
+  /// receivers relay new audits ("gossip_fanout").
+  size_t getGossipFanout() const { return gossip_fanout_; }
+
+  /// Audits per WhisperAuditBatch call ("gossip_batch_max").
+  size_t getGossipBatchMax() const { return gossip_batch_max_; }
+
+  /// Deadline of one gossip call ("gossip_timeout_ms").
+  int getGossipTimeoutMs() const { return gossip_timeout_ms_; }
+
+  /// Cap on the retry backoff for an unreachable peer
+  /// ("gossip_max_backoff_ms").
+  int getGossipMaxBackoffMs() const { return gossip_max_backoff_ms_; }
+
+  /// Period of mempool anti-entropy rounds, 0 = off
+  /// ("anti_entropy_interval_ms").
+  int getAntiEntropyIntervalMs() const { return anti_entropy_interval_ms_; }
+
+  /// Keepalive ping interval and ack timeout of peer channels
+  /// ("peer_keepalive_ms", "peer_keepalive_timeout_ms").
+  int getPeerKeepaliveMs() const { return peer_keepalive_ms_; }
+  int getPeerKeepaliveTimeoutMs() const { return peer_keepalive_timeout_ms_; }
+
+  /// Largest message on a peer channel ("peer_max_message_bytes").
+  size_t getPeerMaxMessageBytes() const { return peer_max_message_bytes_; }
+
+  /// Consecutive failed calls before a peer is marked down
+  /// ("peer_down_after_failures").
+  size_t getPeerDownAfterFailures() const { return peer_down_after_failures_; }
+
+  /// Threads and queued-call limit of the control-plane executor
+  /// (heartbeats, elections, proposals, commits)
+  /// ("rpc_control_threads", "rpc_control_queue_limit").
+  size_t getRpcControlThreads() const { return rpc_control_threads_; }
+  size_t getRpcControlQueueLimit() const { return rpc_control_queue_limit_; }
+
+  /// Threads and queued-call limit of the data-plane executor
+  /// (submissions, gossip, anti-entropy, block and proof reads)
+  /// ("rpc_data_threads", "rpc_data_queue_limit").
+  size_t getRpcDataThreads() const { return rpc_data_threads_; }
+  size_t getRpcDataQueueLimit() const { return rpc_data_queue_limit_; }
+
+  /// Cap on gRPC's sync threads, which serve SubmitAuditStream; 0 = no
+  /// cap ("rpc_stream_threads").
+  size_t getRpcStreamThreads() const { return rpc_stream_threads_; }
+
+  /// Period of the node's "[Stats]" log report, 0 = off
+  /// ("stats_interval_ms").
+  int getStatsIntervalMs() const { return stats_interval_ms_; }
+
 private:
   std::string leader_addr_;
   int         batch_size_;
   int         batch_interval_s_;
+
+  // Stay well under gRPC's 4 MiB default receive limit
+  size_t      max_block_bytes_  = 3 * 1024 * 1024;
+  size_t      max_block_audits_ = 10000;
+  size_t      pipeline_depth_   = 1;
+  bool        compact_blocks_   = true;
+  size_t      pubkey_cache_size_ = 4096;
+  size_t      verified_audit_cache_size_ = 262144;
+  size_t      crypto_threads_            = 0;
+  std::string merkle_mode_               = "hex";
+
+  std::string mempool_format_              = "json";
+  size_t      mempool_segment_bytes_       = 4 * 1024 * 1024;
+  double      mempool_compact_live_ratio_  = 0.5;
+  int         mempool_compact_interval_ms_ = 1000;
+  int         mempool_group_commit_window_us_ = 0;
+  bool        mempool_fsync_                  = true;
+
+  bool        adaptive_batching_        = false;
+  double      target_commit_latency_ms_ = 150.0;
+  size_t      adaptive_min_batch_       = 1;
+  size_t      adaptive_max_batch_       = 5000;
+  int         adaptive_min_linger_ms_   = 5;
+  int         adaptive_max_linger_ms_   = 1000;
+
+  size_t      gossip_queue_limit_    = 10000;
+  size_t      gossip_fanout_         = 0;
+  size_t      gossip_batch_max_      = 256;
+  int         gossip_timeout_ms_     = 1000;
+  int         gossip_max_backoff_ms_ = 5000;
+  int         anti_entropy_interval_ms_ = 2000;
+
+  int         peer_keepalive_ms_         = 10000;
+  int         peer_keepalive_timeout_ms_ = 5000;
+  size_t      peer_max_message_bytes_    = 64 * 1024 * 1024;
+  size_t      peer_down_after_failures_  = 2;
+
+  size_t      rpc_control_threads_     = 4;
+  size_t      rpc_control_queue_limit_ = 1024;
+  size_t      rpc_data_threads_        = 16;
+  size_t      rpc_data_queue_limit_    = 4096;
+  size_t      rpc_stream_threads_      = 0;
+
+  int         stats_interval_ms_ = 10000;
 };
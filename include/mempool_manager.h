@@ -1,28 +1,332 @@
 #pragma once
 
-#include "common.pb.h"     
+#include "common.pb.h"
+#include "merkle_accumulator.h"
+#include "worker_pool.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
-#include <google/protobuf/util/json_util.h> 
+#include <google/protobuf/util/json_util.h>
 
-/// Thread-safe manager for the mempool file.
+/// On-disk record encoding for newly written mempool segments.
+enum class MempoolFormat {
+  kJson,     // one MessageToJsonString line per record
+  kBinary,   // [u32 len][u32 crc32c][u8 kind][payload] per record
+};
+
+/// Tuning knobs for the mempool recovery log.
+struct MempoolOptions {
+  /// Encoding for new segments. With kBinary, JSON segments found at
+  /// startup are converted once.
+  MempoolFormat format      = MempoolFormat::kJson;
+
+  /// Roll over to a new segment once the active one reaches this size.
+  size_t segment_bytes      = 4 * 1024 * 1024;
+
+  /// Compact a sealed segment once live/total records drops below this.
+  double compact_live_ratio = 0.5;
+
+  /// How often the background compactor rescans segments.
+  int    compact_interval_ms = 1000;
+
+  /// Extra time the log writer lingers after the first queued record to
+  /// gather a larger group commit (0 = only batch what's already queued).
+  int    group_commit_window_us = 0;
+
+  /// fdatasync each group commit before acknowledging it.
+  bool   fsync = true;
+
+  /// Merkle variant of the pending-audit accumulator (the cluster's
+  /// merkle_mode).
+  MerkleMode merkle_mode = MerkleMode::kHexCompat;
+};
+
+/// Thread-safe in-memory mempool, indexed by req_id.
+///
+/// The recovery log is a series of segment files "<path>.000001", ...
+/// holding audit records and tombstones. It is replayed once on
+/// construction and otherwise only appended to; a background compactor
+/// drops segments whose live ratio falls below the threshold. A legacy
+/// single-file log at `path` is replayed as segment 0.
+///
+/// Each segment is either JSON lines or binary (detected by its header);
+/// a torn tail record in a binary segment is dropped on replay.
+///
+/// All log writes go through one writer thread: concurrent Append and
+/// RemoveBatch callers enqueue records, the writer issues one write plus
+/// one fdatasync per batch, and callers return once their batch is durable.
+///
+/// Each audit's canonical encoding and Merkle leaf are computed once on
+/// admission, and a MerkleAccumulator over the pending audits (in block
+/// order) lets a block cut from the front reuse every cached subtree.
 class MempoolManager {
 public:
-  /// Construct with the file path (e.g. "../mempool.dat").
-  explicit MempoolManager(std::string path);
+  /// A block-sized prefix of the pending audits.
+  struct Prefix {
+    std::vector<common::FileAudit> audits;        // block order
+    std::string                    encoded;       // concatenated canonical audits
+    std::vector<Digest>            leaves;
+    std::string                    merkle_root;
+  };
+
+  /// One bucket of the req_id digest: the XOR of IdHash() over the
+  /// req_ids it holds, and their count.
+  struct IdBucket {
+    uint64_t x     = 0;
+    uint32_t count = 0;
+  };
+
+  /// Buckets in the req_id digest.
+  static constexpr size_t kIdBuckets = 256;
+
+  /// Stable 64-bit hash of a req_id (same on every node); its low bits
+  /// pick the digest bucket.
+  static uint64_t IdHash(const std::string& req_id);
+
+  /// Construct with the log path (e.g. "../mempool.dat"), replay it and
+  /// launch the log writer thread. With a `pool`, BlockMerkleRoot() hashes
+  /// and reduces large blocks that aren't a pending prefix across it.
+  explicit MempoolManager(std::string path, MempoolOptions opts = {},
+                          std::shared_ptr<WorkerPool> pool = nullptr);
+
+  ~MempoolManager();
+
+  /// Enable periodic background compaction.
+  void Start();
+
+  /// Flush queued records and stop the log writer (and join the thread).
+  /// Appends after Stop() fail.
+  void Stop();
+
+  /// Admit one audit and block until it is durable in the log; it becomes
+  /// visible to Size()/Snapshot() at that point. Returns false if req_id
+  /// is already pending, was recently removed by RemoveBatch() (i.e.
+  /// committed; a late whisper or anti-entropy pull must not bring it
+  /// back), the log writer is stopped, or its group commit failed to
+  /// write. `failed` (optional) tells the last two apart from a duplicate.
+  bool Append(const common::FileAudit& audit, bool* failed = nullptr);
+
+  /// Admit several audits and block once until all are durable, so they
+  /// can share a group commit. Audits already pending, repeated or not
+  /// encodable are skipped. Returns how many were admitted; 0 with
+  /// `*failed` set if the writer is stopped or the group commit could not
+  /// be written (none of the audits are admitted then).
+  /// `admitted` (optional) receives the audits that were added.
+  size_t AppendBatch(const std::vector<const common::FileAudit*>& audits,
+                     std::vector<const common::FileAudit*>* admitted = nullptr,
+                     bool* failed = nullptr);
+
+  /// Number of pending audits.
+  size_t Size() const;
+
+  /// Block until at least `n` audits are pending, `deadline` passes or
+  /// Wake() is called. Returns true if the threshold was reached.
+  bool WaitForSize(size_t n, std::chrono::steady_clock::time_point deadline);
+
+  /// Release a WaitForSize() caller early (e.g. on shutdown).
+  void Wake();
+
+  /// Total audits admitted since construction (replayed ones excluded).
+  uint64_t AdmittedCount() const;
+
+  /// True if an audit with this req_id is pending.
+  bool Contains(const std::string& req_id) const;
+
+  /// Copy of every pending audit, ordered by (timestamp, req_id).
+  std::vector<common::FileAudit> Snapshot() const;
 
-  /// Append one audit (writes “req_id,file_id\n”) under lock.
-  void Append(const common::FileAudit& audit);
+  /// Append the pending or reserved audit for each of `ids` to `out`, in
+  /// order. An id held by neither gets an empty placeholder, and its
+  /// position is added to `missing`.
+  void CopyAudits(const google::protobuf::RepeatedPtrField<std::string>& ids,
+                  google::protobuf::RepeatedPtrField<common::FileAudit>* out,
+                  std::vector<int>* missing) const;
 
-  /// Load *all* previously appended audits from disk.
-  /// If the file doesn’t exist or is empty, returns an empty vector.
-  std::vector<common::FileAudit> LoadAll() const;
+  /// Pending audits in block order for as long as `take` accepts them,
+  /// with their cached encodings and Merkle root. If audits remain behind
+  /// the prefix, its length is rounded down to a multiple of a power of
+  /// two (at least 1/16 of it) so the cached subtrees stay aligned once
+  /// the prefix is removed.
+  Prefix CutPrefix(const std::function<bool(const common::FileAudit&)>& take);
 
-  /// Remove every audit whose req_id is in `ids`, rewriting the file.
+  /// CutPrefix() for a block that will be in flight: the audits also
+  /// leave the pending set (Size(), Snapshot(), later cuts) but stay in
+  /// the log and in Contains() until RemoveBatch() commits them or
+  /// Release() hands them back.
+  Prefix ReservePrefix(const std::function<bool(const common::FileAudit&)>& take);
+
+  /// Return reserved audits (of a rolled-back block) to the pending set.
+  void Release(const std::vector<std::string>& ids);
+
+  /// Number of reserved audits.
+  size_t ReservedCount() const;
+
+  /// Digest of every req_id in Contains(), kIdBuckets buckets. Nodes
+  /// holding the same req_ids in a bucket have equal buckets, so peers
+  /// compare digests and list only the buckets that differ.
+  std::vector<IdBucket> IdDigest() const;
+
+  /// The req_ids in Contains() that fall in `buckets`.
+  std::vector<std::string> IdsInBuckets(
+    const std::vector<uint32_t>& buckets) const;
+
+  /// Merkle root of a proposed block, filling `payloads` with each audit's
+  /// canonical encoding ("" if it can't be encoded). Audits identical to
+  /// their pending copy reuse its encoding and leaf; a block that is
+  /// exactly the pending prefix reuses the cached subtrees too.
+  std::string BlockMerkleRoot(
+    const google::protobuf::RepeatedPtrField<common::FileAudit>& audits,
+    std::vector<std::string>* payloads);
+
+  /// Remove every audit (pending or reserved) whose req_id is in `ids` by
+  /// appending tombstones, blocking until they are durable. Cost is
+  /// proportional to `ids`, not to the mempool.
   void RemoveBatch(const std::vector<std::string>& ids);
 
+  /// Run one compaction pass on the writer thread and wait for it.
+  /// Returns the number of segments dropped.
+  size_t Compact();
+
+  /// Number of segment files currently backing the log.
+  size_t SegmentCount() const;
+
+  /// Rewrite a JSON-lines log file `src` as a binary log at `dst`.
+  /// Returns false if `src` can't be read or `dst` can't be written.
+  static bool ConvertJsonToBinary(const std::string& src,
+                                  const std::string& dst);
+
 private:
+  /// Block order: (timestamp, req_id).
+  using OrderKey = std::pair<int64_t, std::string>;
+
+  /// A pending audit with its canonical encoding and Merkle leaf.
+  struct Entry {
+    common::FileAudit audit;
+    std::string       encoded;
+    Digest            leaf{};
+  };
+
+  struct Location {
+    int64_t  timestamp;
+    uint64_t segment;
+  };
+
+  /// A record waiting in the group-commit queue.
+  struct QueuedWrite {
+    bool              tombstone = false;
+    std::string       req_id;
+    uint64_t          target = 0;    // tombstones: segment holding the add
+    Entry             entry;         // adds only
+  };
+
+  /// Shared by the callers waiting on one group commit; set by the writer
+  /// when the commit could not be made durable.
+  struct CommitOutcome {
+    bool failed = false;
+  };
+
+  struct Segment {
+    std::string file;
+    size_t      records = 0;   // adds + tombstones written to the file
+    size_t      bytes   = 0;
+    std::unordered_set<std::string> live;   // req_ids still pending here
+    // Tombstones that must outlive this segment: (req_id, segment of add)
+    std::vector<std::pair<std::string, uint64_t>> tombstones;
+  };
+
+  void replay();
+  void replaySegment(uint64_t seg_id);
+  void applyRecordLocked(uint64_t seg_id, bool tombstone,
+                         common::FileAudit a);
+  bool encodeAdd(const common::FileAudit& audit, std::string* out) const;
+  void encodeTombstone(const std::string& req_id, std::string* out) const;
+  bool insertLocked(Entry entry, uint64_t seg_id);
+  void placeLocked(Entry entry);
+  size_t prefixLengthLocked(
+    const std::function<bool(const common::FileAudit&)>& take) const;
+  Prefix copyPrefixLocked(size_t n);
+  bool eraseLocked(const std::string& req_id, uint64_t* seg_id);
+  uint64_t enqueueLocked(QueuedWrite w, const std::string& bytes);
+  void waitDurable(std::unique_lock<std::mutex>& lk, uint64_t seq);
+  void flushLocked(std::unique_lock<std::mutex>& lk);
+  bool writeSegmentLocked(std::unique_lock<std::mutex>& lk, uint64_t seg_id,
+                          std::string bytes, size_t count);
+  bool writeDurable(uint64_t seg_id, const std::string& bytes);
+  size_t compactLocked(std::unique_lock<std::mutex>& lk);
+  bool compactSegmentLocked(std::unique_lock<std::mutex>& lk,
+                            uint64_t seg_id);
+  bool needsCompactionLocked(uint64_t seg_id) const;
+  std::string segmentFile(uint64_t seg_id) const;
+  void loop();
+
   mutable std::mutex mu_;
   std::string        path_;
+  MempoolOptions     opts_;
+  std::shared_ptr<WorkerPool> pool_;
+
+  std::map<OrderKey, Entry>                 pending_;
+  std::unordered_map<std::string, Location> index_;
+  std::unordered_map<std::string, Entry>    reserved_;   // in-flight blocks
+  std::vector<IdBucket>                     id_digest_ =
+    std::vector<IdBucket>(kIdBuckets);                    // mirrors index_
+
+  // The last req_ids passed to RemoveBatch, refused by Append
+  std::unordered_set<std::string> removed_;
+  std::deque<std::string>         removed_order_;
+
+  // Leaves mirror pending_ once replay is done (acc_live_). RemoveBatch
+  // defers removals from the front and drops them in one EraseFront.
+  MerkleAccumulator acc_;
+  bool              acc_live_       = false;
+  size_t            acc_front_drop_ = 0;
+
+  std::map<uint64_t, Segment> segments_;
+  uint64_t                    active_ = 1;
+
+  // Group-commit queue (guarded by mu_)
+  std::vector<QueuedWrite>        queue_;
+  std::string                     queue_bytes_;
+  std::shared_ptr<CommitOutcome>  queue_outcome_ =
+    std::make_shared<CommitOutcome>();           // of the queued records
+  std::unordered_set<std::string> staged_;      // queued, not yet durable
+  std::unordered_set<std::string> cancelled_;   // staged, then removed
+  std::unordered_map<std::string, uint64_t> cancelled_at_;  // -> segment
+  uint64_t enqueued_seq_ = 0;
+  uint64_t durable_seq_  = 0;
+  uint64_t admitted_     = 0;
+
+  // Compaction requests (guarded by mu_)
+  bool     background_compaction_ = false;
+  bool     compact_hint_          = false;
+  uint64_t compact_requested_     = 0;
+  uint64_t compact_served_        = 0;
+  size_t   last_compacted_        = 0;
+
+  // Writer-thread only
+  int      fd_     = -1;
+  uint64_t fd_seg_ = 0;
+
+  // Pending-size watchers (guarded by mu_)
+  size_t                  size_waiters_   = 0;
+  size_t                  size_watermark_ = SIZE_MAX;
+  bool                    wake_pending_   = false;
+  std::condition_variable size_cv_;
+
+  bool                    stopping_ = false;
+  bool                    exited_   = false;
+  std::condition_variable writer_cv_;    // wakes the log writer
+  std::condition_variable durable_cv_;   // wakes Append/RemoveBatch callers
+  std::thread             thr_;
 };
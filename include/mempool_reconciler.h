@@ -0,0 +1,87 @@
+#pragma once
+
+#include "block_chain.grpc.pb.h"   // blockchain::BlockChainService
+#include "audit_proof_store.h"
+#include "mempool_manager.h"
+#include "peer_registry.h"
+#include "verified_audit_cache.h"
+
+#include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReconcileOptions {
+  /// Time between rounds; each round pulls from one random peer that is
+  /// up (any peer if none is).
+  std::chrono::milliseconds interval{2000};
+
+  /// Audits fetched per round at most; the rest wait for later rounds.
+  size_t max_pull    = 4096;
+
+  /// Audits per FetchAudits call (the server caps it at 1024).
+  size_t fetch_batch = 512;
+
+  /// Deadline of each call in a round.
+  std::chrono::milliseconds rpc_timeout{1000};
+};
+
+/// Anti-entropy for the mempool: repairs audits that gossip lost to
+/// timeouts, full queues, partitions or a random fanout.
+///
+/// Each round asks one random peer for its req_id digest
+/// (MempoolManager::IdDigest), lists the peer's req_ids in the buckets
+/// that differ from ours, and fetches, verifies and admits the audits we
+/// don't hold and haven't committed. Rounds only pull, so a node repairs
+/// itself; every node doing the same makes the mempools converge. A round
+/// costs one fixed-size digest when nothing differs.
+class MempoolReconciler {
+public:
+  struct Stats {
+    uint64_t rounds           = 0;
+    uint64_t failed_rounds    = 0;   // a call failed
+    uint64_t buckets_differed = 0;
+    uint64_t pulled           = 0;   // audits admitted
+    uint64_t rejected         = 0;   // bad signatures
+  };
+
+  MempoolReconciler(std::shared_ptr<PeerRegistry>       peers,
+                    std::shared_ptr<MempoolManager>     mempool,
+                    std::shared_ptr<VerifiedAuditCache> audit_cache,
+                    std::shared_ptr<AuditProofStore>    proofs,
+                    ReconcileOptions                    opts = {});
+
+  ~MempoolReconciler();
+
+  /// Launches the background round thread.
+  void start();
+
+  /// Stops the rounds (and joins the thread).
+  void stop();
+
+  /// Run one round against peer `i` now. Returns the audits admitted.
+  size_t PullFrom(size_t i);
+
+  Stats GetStats() const;
+
+private:
+  void loop();
+
+  std::shared_ptr<PeerRegistry>       peers_;
+  std::shared_ptr<MempoolManager>     mempool_;
+  std::shared_ptr<VerifiedAuditCache> audit_cache_;
+  std::shared_ptr<AuditProofStore>    proofs_;
+  ReconcileOptions                    opts_;
+
+  mutable std::mutex      mu_;
+  std::condition_variable cv_;
+  bool                    running_ = false;
+  Stats                   stats_;
+  std::thread             thr_;
+};
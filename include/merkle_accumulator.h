@@ -0,0 +1,50 @@
+#pragma once
+
+#include "merkle_tree.h"   // Digest, MerkleMode
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Merkle tree over an ordered, mutable sequence of leaves, caching every
+/// aligned subtree (level l, index k covers leaves [k*2^l, (k+1)*2^l)).
+///
+/// Such a node depends only on its own leaves, so it is shared by the tree
+/// of every prefix that contains it. Root(n) only has to hash the right
+/// edge of the prefix tree (at most one partial node per level) on top of
+/// the cache; roots match ComputeMerkleRoot(leaves[0..n), mode).
+///
+/// Inserting or erasing at position p invalidates cached nodes covering
+/// positions >= p; they are recomputed by the next Insert/Root. Dropping a
+/// prefix of P leaves keeps the levels whose width divides P.
+class MerkleAccumulator {
+public:
+  explicit MerkleAccumulator(MerkleMode mode = MerkleMode::kHexCompat);
+
+  /// Replace all leaves and rebuild the cache.
+  void Reset(std::vector<Digest> leaves);
+
+  /// Insert a leaf at position `pos` (<= Size()) and extend the cache.
+  void Insert(size_t pos, const Digest& leaf);
+
+  /// Remove the leaf at `pos`.
+  void Erase(size_t pos);
+
+  /// Remove the first `count` leaves.
+  void EraseFront(size_t count);
+
+  /// Root (hex) over leaves [0, n), "" if n == 0.
+  std::string Root(size_t n);
+
+  size_t Size() const { return levels_.empty() ? 0 : levels_[0].size(); }
+
+  MerkleMode Mode() const { return mode_; }
+
+private:
+  void invalidateFrom(size_t pos);
+  void extend(size_t n);
+
+  MerkleMode mode_;
+  // levels_[0] = leaves; levels_[l] = valid aligned nodes of width 2^l,
+  // always a prefix of that level
+  std::vector<std::vector<Digest>> levels_;
+};
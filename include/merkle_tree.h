@@ -1,16 +1,82 @@
 #pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <google/protobuf/message.h>
 
+/// Raw SHA-256 digest.
+using Digest = std::array<uint8_t, 32>;
+
+/// How interior Merkle nodes combine their children.
+enum class MerkleMode {
+  kHexCompat,  // SHA256(hex(left) + hex(right)): roots of existing chains
+  kBinary,     // SHA256(left || right) over the raw 32-byte digests
+};
+
 
 /// Compute the SHA-256 hash of a byte string, returning a hex digest.
 std::string SHA256Hex(const std::string& data);
 
+/// Same, over a raw byte range.
+std::string SHA256Hex(const void* data, size_t len);
+
 /// Deterministically serialize a protobuf message (like Python’s
 /// SerializeToString(deterministic=True)).
 std::string DeterministicSerialize(const google::protobuf::Message& msg);
 
+/// SHA-256 of a raw byte range.
+Digest SHA256Digest(const void* data, size_t len);
+
+/// Lowercase hex encoding of a digest.
+std::string DigestToHex(const Digest& d);
+
+/// Parse a 64-character hex digest; false if malformed.
+bool HexToDigest(const std::string& hex, Digest* out);
+
+/// Incremental SHA-256 (EVP_DigestUpdate), for input produced piecewise,
+/// such as a block header followed by each canonical audit, without
+/// first gathering it into one buffer.
+class Sha256Stream {
+public:
+  Sha256Stream();
+  ~Sha256Stream();
+  Sha256Stream(const Sha256Stream&)            = delete;
+  Sha256Stream& operator=(const Sha256Stream&) = delete;
+
+  Sha256Stream& Update(const void* data, size_t len);
+  Sha256Stream& Update(const std::string& data) {
+    return Update(data.data(), data.size());
+  }
+
+  /// Digest of everything fed so far; the stream restarts empty.
+  Digest Final();
+
+  /// Same, hex encoded.
+  std::string FinalHex() { return DigestToHex(Final()); }
+
+private:
+  struct evp_md_ctx_st* ctx_;
+};
+
 /// Given a list of leaf hashes (hex strings), build the Merkle tree
 /// (duplicating the last leaf if odd) and return the root (hex).
-std::string ComputeMerkleRoot(const std::vector<std::string>& leaf_hashes);
\ No newline at end of file
+/// Reference implementation; block code uses the digest overload below.
+std::string ComputeMerkleRoot(const std::vector<std::string>& leaf_hashes);
+
+/// Interior node over two children under `mode`.
+Digest MerkleParent(const Digest& left, const Digest& right, MerkleMode mode);
+
+/// Merkle root (hex, "" if no leaves) over leaf digests, duplicating the
+/// last node of odd levels. Levels are reduced in place in one contiguous
+/// buffer. In kHexCompat mode the result equals ComputeMerkleRoot() over
+/// the hex encodings of `leaves`.
+std::string ComputeMerkleRoot(std::vector<Digest> leaves, MerkleMode mode);
+
+/// Check an inclusion proof: fold `leaf` with `siblings` (leaf level
+/// first), taking the node as the left child wherever the matching bit of
+/// `index` is 0, and compare the result with `root_hex`.
+bool VerifyMerkleProof(const Digest& leaf, uint64_t index,
+                       const std::vector<Digest>& siblings, MerkleMode mode,
+                       const std::string& root_hex);
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "merkle_tree.h"   // Digest, MerkleMode
+#include "worker_pool.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Below this many leaves ParallelMerkleRoot() builds on the caller.
+constexpr size_t kParallelMerkleMin = 2048;
+
+/// Merkle root of `leaves`, identical to ComputeMerkleRoot(leaves, mode).
+///
+/// The leaves are split into aligned runs of 2^k; pool workers (and the
+/// caller) each reduce a run to the subtree root k levels up, and the
+/// caller finishes the few levels above. A short last run keeps
+/// duplicating its lone node up to level k, exactly as the serial build
+/// does. Runs serially without a pool or below `serial_below` leaves.
+std::string ParallelMerkleRoot(std::vector<Digest> leaves, MerkleMode mode,
+                               WorkerPool* pool,
+                               size_t serial_below = kParallelMerkleMin);
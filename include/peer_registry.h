@@ -0,0 +1,105 @@
+#pragma once
+
+#include "block_chain.grpc.pb.h"   // blockchain::BlockChainService
+
+#include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct PeerOptions {
+  /// Idle time before a channel pings its peer, and how long the ping may
+  /// go unanswered before the connection is dropped. Dead peers are then
+  /// noticed within seconds rather than at the next call's deadline.
+  std::chrono::milliseconds keepalive_time{10000};
+  std::chrono::milliseconds keepalive_timeout{5000};
+
+  /// Largest message sent or received over a peer channel (and accepted
+  /// by the server, see ConfigureServer()).
+  size_t max_message_bytes = 64 * 1024 * 1024;
+
+  /// Consecutive transport failures before a peer is marked down.
+  size_t down_after_failures = 2;
+};
+
+/// The node's connections to its peers: one channel and stub per peer,
+/// shared by heartbeats, elections, gossip, anti-entropy and block
+/// proposals, so each peer costs one HTTP/2 connection.
+///
+/// Subsystems report call outcomes with Report(); the registry keeps a
+/// smoothed RTT per peer and marks a peer down after repeated transport
+/// failures (or while its channel is in TRANSIENT_FAILURE). A peer marked
+/// down by one subsystem is skipped or backed off by the others right
+/// away, and any successful call marks it up again.
+class PeerRegistry {
+public:
+  using StubList =
+    std::vector<std::unique_ptr<blockchain::BlockChainService::Stub>>;
+
+  struct PeerStats {
+    std::string addr;
+    bool        up        = true;
+    int64_t     rtt_us    = 0;   // smoothed, 0 until measured
+    uint64_t    calls     = 0;   // successful calls reported
+    uint64_t    failures  = 0;   // transport failures reported
+  };
+
+  PeerRegistry(const std::vector<std::string>& peers, PeerOptions opts = {});
+
+  PeerRegistry(const PeerRegistry&)            = delete;
+  PeerRegistry& operator=(const PeerRegistry&) = delete;
+
+  size_t Size() const { return addrs_.size(); }
+  const std::string& Addr(size_t i) const { return addrs_.at(i); }
+  const std::vector<std::string>& Addrs() const { return addrs_; }
+
+  /// Peer i's stub; stubs are thread-safe and live as long as the registry.
+  blockchain::BlockChainService::Stub* Stub(size_t i) const {
+    return stubs_.at(i).get();
+  }
+
+  /// All stubs, in peer order.
+  StubList& Stubs() { return stubs_; }
+
+  /// Record the outcome of a call to peer i that took `rtt`.
+  /// UNAVAILABLE and DEADLINE_EXCEEDED count as failures; any other
+  /// status means the peer answered.
+  void Report(size_t i, const grpc::Status& st,
+              std::chrono::steady_clock::duration rtt);
+
+  void ReportSuccess(size_t i, std::chrono::steady_clock::duration rtt);
+  void ReportFailure(size_t i);
+
+  bool IsUp(size_t i) const;
+
+  /// Smoothed round-trip time of peer i (zero until measured).
+  std::chrono::microseconds Rtt(size_t i) const;
+
+  /// Peer indices, up peers first, each group by ascending RTT.
+  std::vector<size_t> Ordered() const;
+
+  /// Allow the keepalive pings and message sizes these channels use.
+  void ConfigureServer(grpc::ServerBuilder& builder) const;
+
+  std::vector<PeerStats> GetStats() const;
+
+private:
+  struct Health {
+    size_t   streak   = 0;      // consecutive failures
+    bool     down     = false;
+    int64_t  rtt_us   = 0;
+    uint64_t calls    = 0;
+    uint64_t failures = 0;
+  };
+
+  PeerOptions                                opts_;
+  std::vector<std::string>                   addrs_;
+  std::vector<std::shared_ptr<grpc::Channel>> channels_;
+  StubList                                   stubs_;
+
+  mutable std::mutex  mu_;
+  std::vector<Health> health_;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Fixed set of threads draining a bounded FIFO of tasks. The callback
+/// services run their handler bodies here instead of on gRPC's threads, so
+/// a handler that blocks (on an fsync, a lock, a parent block) only holds
+/// a thread of its own executor. Once `queue_limit` tasks are waiting,
+/// Submit() refuses more and the caller fails the RPC instead of queueing
+/// without bound.
+class RpcExecutor {
+public:
+  struct Stats {
+    size_t   threads     = 0;
+    size_t   queued      = 0;   // waiting for a thread
+    size_t   peak_queued = 0;
+    uint64_t completed   = 0;
+    uint64_t rejected    = 0;   // refused by a full queue
+  };
+
+  /// `name` labels log lines and errors; a `queue_limit` of 0 means
+  /// unbounded. At least one thread is started.
+  RpcExecutor(std::string name, size_t threads, size_t queue_limit);
+
+  /// Calls stop().
+  ~RpcExecutor();
+
+  RpcExecutor(const RpcExecutor&)            = delete;
+  RpcExecutor& operator=(const RpcExecutor&) = delete;
+
+  /// Launches the threads.
+  void start();
+
+  /// Runs the tasks already queued, then joins the threads. Submit()
+  /// refuses tasks from here on.
+  void stop();
+
+  /// Queue `task`; false if the queue is full or the executor is stopped.
+  bool Submit(std::function<void()> task);
+
+  const std::string& Name() const { return name_; }
+
+  Stats GetStats() const;
+
+private:
+  void loop();
+
+  std::string name_;
+  size_t      threads_n_;
+  size_t      queue_limit_;
+
+  mutable std::mutex                mu_;
+  std::condition_variable           cv_;
+  std::deque<std::function<void()>> queue_;
+  bool                              running_  = false;
+  bool                              stopped_  = false;
+  bool                              full_logged_ = false;
+  Stats                             stats_;
+  std::vector<std::thread>          threads_;
+};
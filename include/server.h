@@ -7,20 +7,27 @@
 #include "chain_manager.h"
 #include "heartbeat_table.h"
 #include "election_state.h"
+#include "verified_audit_cache.h"
+#include "audit_proof_store.h"
+#include "gossip_dispatcher.h"
 #include <grpcpp/grpcpp.h>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-/// Handles client submissions and gossips them out.
+/// Handles client submissions and hands them to the gossip dispatcher.
+/// node_server serves it through FileAuditCallbackService.
 class FileAuditServiceImpl final
     : public fileaudit::FileAuditService::Service {
 public:
   FileAuditServiceImpl(
-    const std::vector<std::string>& peers,
-    std::shared_ptr<MempoolManager> mempool);
-
-  std::vector<std::unique_ptr<blockchain::BlockChainService::Stub>>& getGossipStubs();
+    std::shared_ptr<MempoolManager> mempool,
+    std::shared_ptr<VerifiedAuditCache> audit_cache,
+    std::shared_ptr<GossipDispatcher> gossip);
 
   // Note: response is in the fileaudit namespace now
   grpc::Status SubmitAudit(
@@ -28,12 +35,30 @@ public:
       const common::FileAudit* request,
       fileaudit::FileAuditResponse* response) override;
 
+  /// Acks each streamed audit once durable. A reader thread keeps pulling
+  /// audits off the stream while the handler verifies and appends those
+  /// already read as one batch; it stops reading when its read-ahead is
+  /// full, so the stream's flow-control window throttles the client.
+  grpc::Status SubmitAuditStream(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<fileaudit::FileAuditResponse,
+                               common::FileAudit>* stream) override;
+
+  /// One signature check for the whole envelope, then its audits, each
+  /// given its envelope proof, are appended as one batch.
+  grpc::Status SubmitAuditEnvelope(
+      grpc::ServerContext* context,
+      const common::AuditEnvelope* request,
+      fileaudit::AuditEnvelopeResponse* response) override;
+
 private:
-  std::vector<std::unique_ptr<blockchain::BlockChainService::Stub>> gossip_stubs_;
   std::shared_ptr<MempoolManager> mempool_;
+  std::shared_ptr<VerifiedAuditCache> audit_cache_;
+  std::shared_ptr<GossipDispatcher>   gossip_;
 };
 
-/// Handles incoming gossip & block proposals.
+/// Handles incoming gossip & block proposals. node_server serves it
+/// through BlockChainCallbackService.
 class BlockChainServiceImpl final : public blockchain::BlockChainService::Service {
 public:
   BlockChainServiceImpl(
@@ -41,28 +66,66 @@ public:
       ChainManager& chain,
       std::shared_ptr<HeartbeatTable> hb_table,
       ElectionState& election_state,
-      std::string self_addr);
+      std::string self_addr,
+      std::shared_ptr<VerifiedAuditCache> audit_cache,
+      std::shared_ptr<AuditProofStore> proofs,
+      std::shared_ptr<GossipDispatcher> gossip);
 
   grpc::Status WhisperAuditRequest(
       grpc::ServerContext* context,
       const common::FileAudit* request,
       blockchain::WhisperResponse* response) override;
 
+  grpc::Status WhisperAuditBatch(
+      grpc::ServerContext* context,
+      const blockchain::WhisperBatch* request,
+      blockchain::WhisperBatchResponse* response) override;
+
+  grpc::Status GetMempoolDigest(
+      grpc::ServerContext* context,
+      const blockchain::MempoolDigestRequest* request,
+      blockchain::MempoolDigest* response) override;
+
+  grpc::Status GetBucketIds(
+      grpc::ServerContext* context,
+      const blockchain::BucketIdsRequest* request,
+      blockchain::BucketIds* response) override;
+
+  grpc::Status FetchAudits(
+      grpc::ServerContext* context,
+      const blockchain::FetchAuditsRequest* request,
+      blockchain::WhisperBatch* response) override;
+
   grpc::Status ProposeBlock(
       grpc::ServerContext* context,
       const blockchain::Block* request,
       blockchain::BlockVoteResponse* response) override;
 
+  grpc::Status ProposeCompactBlock(
+      grpc::ServerContext* context,
+      const blockchain::CompactBlock* request,
+      blockchain::BlockVoteResponse* response) override;
+
   grpc::Status CommitBlock(
       grpc::ServerContext* context,
       const blockchain::Block* request,
       blockchain::BlockCommitResponse* response) override;
 
+  grpc::Status ConfirmBlock(
+      grpc::ServerContext* context,
+      const blockchain::BlockCommitRef* request,
+      blockchain::BlockCommitResponse* response) override;
+
   grpc::Status GetBlock(
       grpc::ServerContext* context,
       const blockchain::GetBlockRequest* request,
       blockchain::GetBlockResponse* response) override;
 
+  grpc::Status GetAuditProof(
+      grpc::ServerContext* context,
+      const blockchain::GetAuditProofRequest* request,
+      blockchain::GetAuditProofResponse* response) override;
+
   grpc::Status SendHeartbeat(
       grpc::ServerContext* context,
       const blockchain::HeartbeatRequest* request,
@@ -84,9 +147,32 @@ public:
   //     blockchain::BlockVoteResponse* response) override;
 
 private:
+  bool awaitParent(const blockchain::Block& blk);
+  void relay(const std::vector<const common::FileAudit*>& audits);
+  void voteOnBlock(const blockchain::Block& blk,
+                   std::shared_ptr<const blockchain::Block> owned,
+                   bool compact,
+                   blockchain::BlockVoteResponse* resp);
+  void applyCommit(const blockchain::Block& blk,
+                   blockchain::BlockCommitResponse* resp);
+
   std::shared_ptr<MempoolManager> mempool_;
   ChainManager&                   chain_;
   std::shared_ptr<HeartbeatTable> hb_table_;
   ElectionState&                  state_;
   std::string                     self_addr_;
+  std::shared_ptr<VerifiedAuditCache> audit_cache_;
+  std::shared_ptr<AuditProofStore>    proofs_;
+  std::shared_ptr<GossipDispatcher>   gossip_;
+
+  // Blocks voted yes whose commit hasn't arrived, by hash: a pipelined
+  // leader proposes a block's child before committing the block, and
+  // ConfirmBlock commits the copy kept here
+  struct VotedBlock {
+    int64_t                                  id;
+    std::shared_ptr<const blockchain::Block> block;
+  };
+  std::mutex                                  voted_mu_;
+  std::condition_variable                     voted_cv_;
+  std::unordered_map<std::string, VotedBlock> voted_;
 };
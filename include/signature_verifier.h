@@ -0,0 +1,53 @@
+#pragma once
+
+#include <openssl/evp.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// Base64-decode into a byte vector (empty on malformed input).
+std::vector<unsigned char> Base64Decode(const std::string& b64);
+
+/// Verifies client RSA/SHA-256 signatures over audit payloads.
+///
+/// Parsed public keys are kept in a bounded LRU keyed by the SHA-256 of
+/// the PEM bytes, so each distinct client key is decoded once. Safe to
+/// share between service threads; each thread reuses its own EVP_MD_CTX.
+class SignatureVerifier {
+public:
+  struct Stats {
+    uint64_t hits      = 0;
+    uint64_t misses    = 0;
+    uint64_t evictions = 0;
+    size_t   size      = 0;
+  };
+
+  explicit SignatureVerifier(size_t capacity = 4096);
+
+  /// True if `signature_b64` is a valid signature of `data` under the PEM
+  /// public key `pubkey_pem`.
+  bool Verify(const std::string& data,
+              const std::string& signature_b64,
+              const std::string& pubkey_pem);
+
+  Stats GetStats() const;
+
+private:
+  using KeyPtr = std::shared_ptr<EVP_PKEY>;
+  using Entry  = std::pair<std::string, KeyPtr>;   // (PEM digest, key)
+
+  /// Cached or freshly parsed key; null if the PEM doesn't parse.
+  KeyPtr lookup(const std::string& pubkey_pem);
+
+  mutable std::mutex mu_;
+  size_t             capacity_;
+  std::list<Entry>   lru_;                         // front = most recent
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  Stats              stats_;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "gossip_dispatcher.h"
+#include "mempool_manager.h"
+#include "mempool_reconciler.h"
+#include "peer_registry.h"
+#include "rpc_executor.h"
+#include "signature_verifier.h"
+#include "verified_audit_cache.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// The subsystems whose counters are reported; null ones are left out.
+struct StatsSources {
+  std::shared_ptr<MempoolManager>     mempool;
+  std::shared_ptr<PeerRegistry>       peers;
+  std::shared_ptr<GossipDispatcher>   gossip;
+  std::shared_ptr<SignatureVerifier>  verifier;
+  std::shared_ptr<VerifiedAuditCache> audit_cache;
+  std::shared_ptr<RpcExecutor>        control;
+  std::shared_ptr<RpcExecutor>        data;
+  const MempoolReconciler*            reconciler = nullptr;
+};
+
+/// Logs the node's counters every interval: mempool size, per-peer
+/// health and gossip queues, signature cache hit rates, RPC executor
+/// queues and anti-entropy rounds.
+class StatsReporter {
+public:
+  StatsReporter(StatsSources sources, std::chrono::milliseconds interval);
+
+  ~StatsReporter();
+
+  StatsReporter(const StatsReporter&)            = delete;
+  StatsReporter& operator=(const StatsReporter&) = delete;
+
+  /// Launches the reporting thread (not with a zero interval).
+  void start();
+
+  /// Stops the reporting thread (and joins it).
+  void stop();
+
+  /// One report, one "[Stats] ..." line per subsystem or peer.
+  std::string Report() const;
+
+private:
+  void loop();
+
+  StatsSources              sources_;
+  std::chrono::milliseconds interval_;
+
+  std::mutex              mu_;
+  std::condition_variable cv_;
+  bool                    running_ = false;
+  std::thread             thr_;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "common.pb.h"             // common::FileAudit
+#include "signature_verifier.h"
+#include "worker_pool.h"
+#include <google/protobuf/repeated_field.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Remembers audits whose signature this node has already checked, so an
+/// audit seen in SubmitAudit/WhisperAuditRequest isn't verified again in
+/// ProposeBlock, CommitBlock or block sync.
+///
+/// Entries are keyed by (req_id, digest of signature + public key, digest
+/// of the canonical payload): any change to the signed content, the
+/// signature or the key it claims misses the cache. Bounded LRU; only
+/// successful verifications are cached.
+///
+/// An audit from an AuditEnvelope is checked by its Merkle path to the
+/// envelope root, and the root's signature is cached too, so the audits
+/// of one envelope cost a single RSA verify however they arrive.
+///
+/// With a WorkerPool, VerifyBatch() spreads a block's audits over the pool
+/// (each worker keeps its own OpenSSL contexts).
+class VerifiedAuditCache {
+public:
+  struct Stats {
+    uint64_t hits      = 0;
+    uint64_t misses    = 0;   // RSA signature checks performed
+    uint64_t failures  = 0;   // of which invalid
+    uint64_t evictions = 0;
+    size_t   size      = 0;
+  };
+
+  VerifiedAuditCache(std::shared_ptr<SignatureVerifier> verifier,
+                     size_t capacity = 262144,
+                     std::shared_ptr<WorkerPool> pool = nullptr);
+
+  /// True if the audit's signature over its canonical payload is valid.
+  bool Verify(const common::FileAudit& audit);
+
+  /// Same, with the canonical payload already computed by the caller.
+  bool Verify(const common::FileAudit& audit, const std::string& payload);
+
+  /// True if `signature` is the client's signature of an envelope's hex
+  /// Merkle root under `public_key`.
+  bool VerifyEnvelope(const std::string& root,
+                      const std::string& signature,
+                      const std::string& public_key);
+
+  /// Verify every audit, in parallel when a pool is attached, stopping at
+  /// the first invalid one. `payloads` (optional) holds their canonical
+  /// payloads. Returns the index of an invalid audit, or audits.size().
+  size_t VerifyBatch(
+    const google::protobuf::RepeatedPtrField<common::FileAudit>& audits,
+    const std::vector<std::string>* payloads = nullptr);
+
+  /// The audits with a valid signature, in order; the req_ids of the rest
+  /// go to `rejected` (optional). A batch without bad audits costs one
+  /// VerifyBatch().
+  std::vector<const common::FileAudit*> ValidAudits(
+    const google::protobuf::RepeatedPtrField<common::FileAudit>& audits,
+    std::vector<std::string>* rejected = nullptr);
+
+  Stats GetStats() const;
+
+private:
+  std::string cacheKey(const common::FileAudit& audit,
+                       const std::string& payload) const;
+  bool lookup(const std::string& key);
+  void insert(std::string key);
+
+  std::shared_ptr<SignatureVerifier> verifier_;
+  std::shared_ptr<WorkerPool>        pool_;
+
+  mutable std::mutex     mu_;
+  size_t                 capacity_;
+  std::list<std::string> lru_;                     // front = most recent
+  std::unordered_map<std::string, std::list<std::string>::iterator> index_;
+  Stats                  stats_;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Fixed set of threads for CPU-bound data-parallel work (signature checks,
+/// hashing). Several callers may run jobs at once; each job is split into
+/// index chunks that idle workers and the calling thread claim in turn.
+class WorkerPool {
+public:
+  /// Launch `threads` workers (0 = one per hardware thread, minus the
+  /// caller, which always helps with its own job).
+  explicit WorkerPool(size_t threads = 0);
+
+  /// Stops and joins the workers.
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&)            = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  /// Run fn(i) for every i in [0, n) and wait for completion. Stops handing
+  /// out indices once any call returns false. Returns the index of a
+  /// failed call, or n if all succeeded.
+  size_t ParallelAll(size_t n, const std::function<bool(size_t)>& fn,
+                     size_t grain = 1);
+
+  /// Run fn(i) for every i in [0, n) and wait for completion.
+  void ParallelFor(size_t n, const std::function<void(size_t)>& fn,
+                   size_t grain = 1);
+
+  /// Number of worker threads (not counting callers).
+  size_t Size() const { return threads_.size(); }
+
+private:
+  struct Job {
+    const std::function<bool(size_t)>* fn;
+    size_t              n;
+    size_t              grain;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failed;
+    size_t              active = 0;   // workers inside run(), guarded by mu_
+  };
+
+  static void run(Job& job);
+  void loop();
+
+  std::mutex                       mu_;
+  std::condition_variable          work_cv_;   // wakes workers
+  std::condition_variable          done_cv_;   // wakes waiting callers
+  std::deque<std::shared_ptr<Job>> jobs_;
+  bool                             stopping_ = false;
+  std::vector<std::thread>         threads_;
+};
@@ -0,0 +1,125 @@
+// src/adaptive_batcher.cpp
+
+#include "adaptive_batcher.h"
+#include <algorithm>
+#include <cmath>
+
+AdaptiveBatcher::AdaptiveBatcher(AdaptiveBatchOptions opts)
+  : opts_(opts)
+{
+  opts_.min_batch     = std::max<size_t>(opts_.min_batch, 1);
+  opts_.max_batch     = std::max(opts_.max_batch, opts_.min_batch);
+  opts_.min_linger_ms = std::max(opts_.min_linger_ms, 0);
+  opts_.max_linger_ms = std::max(opts_.max_linger_ms, opts_.min_linger_ms);
+  std::lock_guard<std::mutex> lk(mu_);
+  recomputeLocked();
+}
+
+void AdaptiveBatcher::ObserveArrivals(
+    uint64_t admitted_total,
+    std::chrono::steady_clock::time_point now
+) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (!seen_arrivals_) {
+    seen_arrivals_ = true;
+    last_total_    = admitted_total;
+    last_at_       = now;
+    return;
+  }
+  double dt = std::chrono::duration<double, std::milli>(now - last_at_).count();
+  if (dt <= 0.0) return;
+  if (admitted_total < last_total_) last_total_ = admitted_total;
+
+  // Time-weighted average: irregular sampling intervals count in proportion
+  double sample = static_cast<double>(admitted_total - last_total_) / dt;
+  double w      = 1.0 - std::exp(-dt / opts_.rate_window_ms);
+  rate_ += w * (sample - rate_);
+
+  last_total_ = admitted_total;
+  last_at_    = now;
+  recomputeLocked();
+}
+
+void AdaptiveBatcher::ObserveRound(
+    size_t audits,
+    std::chrono::steady_clock::duration elapsed
+) {
+  std::lock_guard<std::mutex> lk(mu_);
+  double n = static_cast<double>(audits);
+  double t = std::chrono::duration<double, std::milli>(elapsed).count();
+
+  if (rounds_ == 0) {
+    mean_n_ = n;  mean_t_ = t;  mean_nn_ = n * n;  mean_nt_ = n * t;
+  } else {
+    double a = opts_.round_alpha;
+    mean_n_  += a * (n     - mean_n_);
+    mean_t_  += a * (t     - mean_t_);
+    mean_nn_ += a * (n * n - mean_nn_);
+    mean_nt_ += a * (n * t - mean_nt_);
+  }
+  ++rounds_;
+
+  double var = mean_nn_ - mean_n_ * mean_n_;
+  if (var > 1e-6 * std::max(1.0, mean_nn_)) {
+    per_audit_ms_ = std::max(0.0, (mean_nt_ - mean_n_ * mean_t_) / var);
+    fixed_ms_     = std::max(0.0, mean_t_ - per_audit_ms_ * mean_n_);
+  } else {
+    // Every round had the same size; charge it all to the audits, which
+    // errs towards smaller blocks
+    per_audit_ms_ = mean_n_ > 0.0 ? mean_t_ / mean_n_ : 0.0;
+    fixed_ms_     = 0.0;
+  }
+  recomputeLocked();
+}
+
+void AdaptiveBatcher::recomputeLocked() {
+  const double lambda = rate_;   // audits per ms
+  const double budget = std::max(opts_.target_latency_ms - fixed_ms_,
+                                 static_cast<double>(opts_.min_linger_ms));
+
+  // linger + fixed + per_audit * (lambda * linger) == target
+  double linger = budget / (1.0 + per_audit_ms_ * lambda);
+  double n      = lambda * linger;
+
+  // One round on its own must fit the budget
+  if (per_audit_ms_ > 0.0) n = std::min(n, budget / per_audit_ms_);
+
+  // But never cut blocks smaller than what arrives during a round, or the
+  // backlog grows without bound
+  double load = lambda * per_audit_ms_;
+  double keep_up = load < 1.0
+    ? lambda * fixed_ms_ / (1.0 - load)
+    : static_cast<double>(opts_.max_batch);
+  n = std::max(n, keep_up);
+
+  n = std::clamp(std::ceil(n),
+                 static_cast<double>(opts_.min_batch),
+                 static_cast<double>(opts_.max_batch));
+  batch_     = static_cast<size_t>(n);
+  linger_ms_ = std::clamp(linger,
+                          static_cast<double>(opts_.min_linger_ms),
+                          static_cast<double>(opts_.max_linger_ms));
+}
+
+size_t AdaptiveBatcher::BatchSize() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return batch_;
+}
+
+std::chrono::milliseconds AdaptiveBatcher::Linger() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return std::chrono::milliseconds(static_cast<int64_t>(linger_ms_));
+}
+
+AdaptiveBatcher::Stats AdaptiveBatcher::GetStats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  Stats s;
+  s.arrival_rate_per_s = rate_ * 1000.0;
+  s.round_ms           = mean_t_;
+  s.fixed_ms           = fixed_ms_;
+  s.per_audit_ms       = per_audit_ms_;
+  s.batch_size         = batch_;
+  s.linger_ms          = static_cast<int>(linger_ms_);
+  s.rounds             = rounds_;
+  return s;
+}
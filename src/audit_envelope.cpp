@@ -0,0 +1,89 @@
+// src/audit_envelope.cpp
+
+#include "audit_envelope.h"
+#include "canonical_audit.h"
+#include <algorithm>
+
+std::string EnvelopeRoot(
+    const google::protobuf::RepeatedPtrField<common::FileAudit>& audits,
+    std::vector<Digest>* leaves) {
+  std::vector<Digest> own;
+  auto& out = leaves ? *leaves : own;
+  out.clear();
+  out.reserve(audits.size());
+  std::string payload;
+  for (auto& a : audits) {
+    payload.clear();
+    if (!AppendCanonicalAudit(a, &payload)) return "";
+    out.push_back(SHA256Digest(payload.data(), payload.size()));
+  }
+  if (out.empty()) return "";
+  return ComputeMerkleRoot(out, kEnvelopeMerkleMode);
+}
+
+std::vector<std::vector<Digest>> MerklePaths(std::vector<Digest> level,
+                                             MerkleMode mode) {
+  std::vector<std::vector<Digest>> paths(level.size());
+  // pos[i]: the node on leaf i's path at the current level
+  std::vector<size_t> pos(level.size());
+  for (size_t i = 0; i < pos.size(); ++i) pos[i] = i;
+
+  while (level.size() > 1) {
+    for (size_t i = 0; i < paths.size(); ++i) {
+      size_t sib = pos[i] ^ 1;
+      paths[i].push_back(level[sib < level.size() ? sib : pos[i]]);
+      pos[i] /= 2;
+    }
+    std::vector<Digest> up((level.size() + 1) / 2);
+    for (size_t j = 0; j < up.size(); ++j) {
+      const Digest& left = level[2 * j];
+      up[j] = MerkleParent(left,
+                           2 * j + 1 < level.size() ? level[2 * j + 1] : left,
+                           mode);
+    }
+    level = std::move(up);
+  }
+  return paths;
+}
+
+std::string OpenEnvelope(
+    const common::AuditEnvelope& envelope,
+    google::protobuf::RepeatedPtrField<common::FileAudit>* out) {
+  std::vector<Digest> leaves;
+  std::string root = EnvelopeRoot(envelope.audits(), &leaves);
+  if (root.empty()) return "";
+
+  auto paths = MerklePaths(std::move(leaves), kEnvelopeMerkleMode);
+  out->Reserve(out->size() + envelope.audits_size());
+  for (int i = 0; i < envelope.audits_size(); ++i) {
+    auto* a = out->Add();
+    *a = envelope.audits(i);
+    a->set_signature(envelope.signature());
+    a->set_public_key(envelope.public_key());
+    a->set_envelope_root(root);
+    a->set_envelope_index(static_cast<uint32_t>(i));
+    a->clear_envelope_path();
+    for (auto& d : paths[i]) {
+      a->add_envelope_path(reinterpret_cast<const char*>(d.data()), d.size());
+    }
+  }
+  return root;
+}
+
+bool CheckEnvelopePath(const common::FileAudit& audit,
+                       const std::string& payload) {
+  if (audit.envelope_root().empty() || audit.envelope_path_size() > 32) {
+    return false;
+  }
+  std::vector<Digest> siblings(audit.envelope_path_size());
+  for (int i = 0; i < audit.envelope_path_size(); ++i) {
+    const auto& s = audit.envelope_path(i);
+    if (s.size() != siblings[i].size()) return false;
+    std::copy(s.begin(), s.end(), siblings[i].begin());
+  }
+  // The index must address a leaf of a tree this deep
+  if (uint64_t(audit.envelope_index()) >> siblings.size() != 0) return false;
+  Digest leaf = SHA256Digest(payload.data(), payload.size());
+  return VerifyMerkleProof(leaf, audit.envelope_index(), siblings,
+                           kEnvelopeMerkleMode, audit.envelope_root());
+}
@@ -0,0 +1,256 @@
+// src/audit_proof_store.cpp
+
+#include "audit_proof_store.h"
+#include "canonical_audit.h"
+#include <google/protobuf/util/json_util.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// Sidecar layout: magic, u8 mode, u64 leaf count, hash, merkle_root,
+// leaf_count req_ids (strings are u32 length + bytes), then every level's
+// digests from the leaves up; a level of c nodes has (c + 1) / 2 parents.
+static constexpr char kSidecarMagic[8] = {'A','V','M','R','K','L','0','1'};
+
+static void PutU32(uint32_t v, std::string* out) {
+  for (int i = 0; i < 4; ++i) out->push_back(static_cast<char>(v >> (8 * i)));
+}
+
+static void PutU64(uint64_t v, std::string* out) {
+  for (int i = 0; i < 8; ++i) out->push_back(static_cast<char>(v >> (8 * i)));
+}
+
+static void PutString(const std::string& s, std::string* out) {
+  PutU32(static_cast<uint32_t>(s.size()), out);
+  out->append(s);
+}
+
+static bool ReadU64(std::istream& in, uint64_t* v) {
+  unsigned char b[8];
+  if (!in.read(reinterpret_cast<char*>(b), sizeof(b))) return false;
+  *v = 0;
+  for (int i = 7; i >= 0; --i) *v = (*v << 8) | b[i];
+  return true;
+}
+
+static bool ReadString(std::istream& in, std::string* s) {
+  unsigned char b[4];
+  if (!in.read(reinterpret_cast<char*>(b), sizeof(b))) return false;
+  uint32_t len = b[0] | b[1] << 8 | b[2] << 16 | uint32_t{b[3]} << 24;
+  if (len > (1u << 20)) return false;
+  s->resize(len);
+  return static_cast<bool>(in.read(&(*s)[0], len));
+}
+
+static uint64_t TotalNodes(uint64_t leaf_count) {
+  uint64_t total = leaf_count;
+  for (uint64_t c = leaf_count; c > 1; c = (c + 1) / 2) total += (c + 1) / 2;
+  return total;
+}
+
+AuditProofStore::AuditProofStore(std::string dir, MerkleMode mode)
+  : dir_(std::move(dir))
+  , mode_(mode)
+{}
+
+std::string AuditProofStore::sidecarPath(int64_t block_id) const {
+  return dir_ + "/block_" + std::to_string(block_id) + ".merkle";
+}
+
+size_t AuditProofStore::Size() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return index_.size();
+}
+
+void AuditProofStore::indexLocked(int64_t block_id, BlockInfo info,
+                                  const std::vector<std::string>& req_ids) {
+  for (uint64_t i = 0; i < req_ids.size(); ++i) {
+    index_[req_ids[i]] = LeafRef{block_id, i};
+  }
+  blocks_[block_id] = std::move(info);
+}
+
+bool AuditProofStore::Record(const blockchain::Block& block,
+                             const std::vector<Digest>* leaves) {
+  size_t n = static_cast<size_t>(block.audits_size());
+  if (n == 0) return true;
+
+  // All levels in one buffer, leaves first
+  std::vector<Digest> nodes;
+  nodes.reserve(TotalNodes(n));
+  if (leaves && leaves->size() == n) {
+    nodes = *leaves;
+  } else {
+    std::string payload;
+    for (auto& a : block.audits()) {
+      payload.clear();
+      if (!AppendCanonicalAudit(a, &payload)) payload.clear();
+      nodes.push_back(SHA256Digest(payload.data(), payload.size()));
+    }
+  }
+  size_t start = 0;
+  for (size_t c = n; c > 1; c = (c + 1) / 2) {
+    for (size_t i = 0; 2*i < c; ++i) {
+      size_t l = start + 2*i;
+      size_t r = 2*i + 1 < c ? l + 1 : l;
+      Digest parent = MerkleParent(nodes[l], nodes[r], mode_);
+      nodes.push_back(parent);
+    }
+    start += c;
+  }
+  if (DigestToHex(nodes.back()) != block.merkle_root()) {
+    std::cerr << "[AuditProofStore] block " << block.id()
+              << " levels don't match its merkle_root, not indexed\n";
+    return false;
+  }
+
+  std::vector<std::string> req_ids;
+  req_ids.reserve(n);
+  std::string buf(kSidecarMagic, sizeof(kSidecarMagic));
+  buf.push_back(static_cast<char>(mode_));
+  PutU64(n, &buf);
+  PutString(block.hash(), &buf);
+  PutString(block.merkle_root(), &buf);
+  for (auto& a : block.audits()) {
+    PutString(a.req_id(), &buf);
+    req_ids.push_back(a.req_id());
+  }
+  BlockInfo info{block.hash(), block.merkle_root(), n, buf.size()};
+  buf.append(reinterpret_cast<const char*>(nodes.data()),
+             nodes.size() * sizeof(Digest));
+
+  // Write aside and rename, so readers never see a partial file
+  std::error_code ec;
+  fs::create_directories(dir_, ec);
+  std::string path = sidecarPath(block.id());
+  std::string tmp  = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write(buf.data(), buf.size())) {
+      std::cerr << "[AuditProofStore] failed to write " << tmp << "\n";
+      return false;
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::cerr << "[AuditProofStore] failed to rename " << tmp << "\n";
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lk(mu_);
+  indexLocked(block.id(), std::move(info), req_ids);
+  return true;
+}
+
+bool AuditProofStore::loadSidecar(int64_t block_id) {
+  std::ifstream in(sidecarPath(block_id), std::ios::binary);
+  if (!in) return false;
+
+  char magic[sizeof(kSidecarMagic)];
+  char mode = 0;
+  if (!in.read(magic, sizeof(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), kSidecarMagic) ||
+      !in.get(mode) || mode != static_cast<char>(mode_)) {
+    return false;
+  }
+
+  BlockInfo info;
+  if (!ReadU64(in, &info.leaf_count) || !ReadString(in, &info.hash) ||
+      !ReadString(in, &info.merkle_root)) {
+    return false;
+  }
+  // Each leaf takes at least a req_id length and its digest, so a torn or
+  // corrupt count can't make us allocate more than the file could hold
+  uint64_t pos = static_cast<uint64_t>(in.tellg());
+  in.seekg(0, std::ios::end);
+  uint64_t size = static_cast<uint64_t>(in.tellg());
+  if (info.leaf_count > (size - pos) / (4 + sizeof(Digest))) return false;
+  in.seekg(static_cast<std::streamoff>(pos));
+
+  std::vector<std::string> req_ids(info.leaf_count);
+  for (auto& id : req_ids) {
+    if (!ReadString(in, &id)) return false;
+  }
+  info.levels_offset = static_cast<uint64_t>(in.tellg());
+  if (size != info.levels_offset + TotalNodes(info.leaf_count) * sizeof(Digest))
+    return false;
+
+  std::lock_guard<std::mutex> lk(mu_);
+  indexLocked(block_id, std::move(info), req_ids);
+  return true;
+}
+
+void AuditProofStore::Load(int64_t last_id) {
+  size_t rebuilt = 0;
+  for (int64_t id = 0; id <= last_id; ++id) {
+    if (loadSidecar(id)) continue;
+
+    // Missing, torn or written for another merkle_mode: rebuild it
+    std::ifstream in(dir_ + "/block_" + std::to_string(id) + ".json");
+    if (!in) {
+      std::cerr << "[AuditProofStore] no block file for block " << id << "\n";
+      continue;
+    }
+    std::stringstream json;
+    json << in.rdbuf();
+    blockchain::Block blk;
+    if (!google::protobuf::util::JsonStringToMessage(json.str(), &blk).ok()) {
+      std::cerr << "[AuditProofStore] can't parse block " << id << "\n";
+      continue;
+    }
+    if (Record(blk)) ++rebuilt;
+  }
+  std::cout << "[AuditProofStore] indexed " << Size() << " audits in "
+            << (last_id + 1) << " blocks (" << rebuilt
+            << " sidecars rebuilt)\n";
+}
+
+bool AuditProofStore::Contains(const std::string& req_id) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return index_.count(req_id) != 0;
+}
+
+bool AuditProofStore::GetProof(const std::string& req_id, Proof* out) const {
+  LeafRef   ref;
+  BlockInfo info;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = index_.find(req_id);
+    if (it == index_.end()) return false;
+    auto blk = blocks_.find(it->second.block_id);
+    if (blk == blocks_.end()) return false;
+    ref  = it->second;
+    info = blk->second;
+  }
+
+  std::ifstream in(sidecarPath(ref.block_id), std::ios::binary);
+  if (!in) return false;
+  auto readNode = [&](uint64_t node, Digest* d) {
+    in.seekg(static_cast<std::streamoff>(info.levels_offset + node * sizeof(Digest)));
+    return static_cast<bool>(
+      in.read(reinterpret_cast<char*>(d->data()), sizeof(Digest)));
+  };
+
+  out->block_id    = ref.block_id;
+  out->block_hash  = info.hash;
+  out->merkle_root = info.merkle_root;
+  out->leaf_index  = ref.index;
+  out->siblings.clear();
+  if (!readNode(ref.index, &out->leaf)) return false;
+
+  // One sibling per level; a duplicated last node is its own sibling
+  uint64_t start = 0;
+  uint64_t i     = ref.index;
+  for (uint64_t c = info.leaf_count; c > 1; c = (c + 1) / 2) {
+    uint64_t sib = (i ^ 1) < c ? (i ^ 1) : i;
+    Digest d;
+    if (!readNode(start + sib, &d)) return false;
+    out->siblings.push_back(d);
+    start += c;
+    i >>= 1;
+  }
+  return true;
+}
@@ -0,0 +1,349 @@
+// src/block_broadcaster.cpp
+
+#include "block_broadcaster.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+
+// Time allowed past a proposal's deadline for its RPC callbacks to land
+static constexpr auto kDeadlineGraceMs = 50;
+
+void BlockBroadcaster::Ballot::Vote(bool yes) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    ++(yes ? yes_ : no_);
+  }
+  cv_.notify_all();
+}
+
+bool BlockBroadcaster::Ballot::Wait() {
+  std::unique_lock<std::mutex> lk(mu_);
+  cv_.wait_until(lk, deadline_ + std::chrono::milliseconds(kDeadlineGraceMs),
+                 [&]{ return decidedLocked(); });
+  return yes_ >= needed_;
+}
+
+std::string BlockBroadcaster::Ballot::Summary() {
+  std::lock_guard<std::mutex> lk(mu_);
+  return std::to_string(yes_) + " yes, " + std::to_string(no_) + " no of " +
+         std::to_string(peers_) + " peers (quorum " +
+         std::to_string(needed_) + ")";
+}
+
+BlockBroadcaster::BlockBroadcaster(StubList& stubs,
+                                   std::chrono::milliseconds propose_timeout,
+                                   std::chrono::milliseconds commit_timeout,
+                                   size_t window,
+                                   bool compact,
+                                   std::shared_ptr<PeerRegistry> peers)
+  : propose_timeout_(propose_timeout)
+  , commit_timeout_(commit_timeout)
+  , window_(std::max<size_t>(window, 1))
+  , compact_(compact)
+  , peers_(std::move(peers))
+{
+  for (size_t i = 0; i < stubs.size(); ++i) {
+    auto lane     = std::make_unique<Lane>();
+    lane->index   = i;
+    lane->stub    = stubs[i].get();
+    lane->compact = compact;
+    lanes_.push_back(std::move(lane));
+  }
+}
+
+BlockBroadcaster::~BlockBroadcaster() {
+  std::vector<Op> dropped;
+  std::unique_lock<std::mutex> lk(mu_);
+  stopping_ = true;
+  for (auto& lane : lanes_) {
+    for (auto& op : lane->ops) dropped.push_back(std::move(op));
+    lane->ops.clear();
+  }
+  idle_cv_.wait(lk, [&]{ return inflight_ == 0; });
+  lk.unlock();
+  for (auto& op : dropped) {
+    if (op.ballot) op.ballot->Vote(false);
+  }
+}
+
+bool BlockBroadcaster::Propose(std::shared_ptr<const blockchain::Block> block) {
+  auto ballot   = StartProposal(block);
+  bool accepted = ballot->Wait();
+  std::cout << "[Broadcast] block " << block->id()
+            << (accepted ? " accepted: " : " rejected: ")
+            << ballot->Summary() << "\n";
+  return accepted;
+}
+
+std::shared_ptr<BlockBroadcaster::Ballot> BlockBroadcaster::StartProposal(
+    std::shared_ptr<const blockchain::Block> block) {
+  auto deadline = std::chrono::system_clock::now() + propose_timeout_;
+  auto ballot   = std::make_shared<Ballot>(lanes_.size(), Quorum(), deadline);
+
+  // One header + req_id list shared by every lane
+  std::shared_ptr<const blockchain::CompactBlock> compact;
+  if (compact_) {
+    auto cb = std::make_shared<blockchain::CompactBlock>();
+    cb->set_id(block->id());
+    cb->set_hash(block->hash());
+    cb->set_previous_hash(block->previous_hash());
+    cb->set_merkle_root(block->merkle_root());
+    cb->mutable_req_ids()->Reserve(block->audits_size());
+    for (auto& a : block->audits()) cb->add_req_ids(a.req_id());
+    compact = std::move(cb);
+  }
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (stopping_) {
+      for (size_t i = 0; i < lanes_.size(); ++i) ballot->Vote(false);
+      return ballot;
+    }
+    for (auto& lane : lanes_) {
+      lane->ops.push_back(Op{false, block, ballot, deadline, compact});
+    }
+  }
+  for (auto& lane : lanes_) pump(*lane);
+  return ballot;
+}
+
+void BlockBroadcaster::Commit(std::shared_ptr<const blockchain::Block> block) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (stopping_) return;
+    for (auto& lane : lanes_) {
+      lane->ops.push_back(Op{true, block, nullptr, {}, nullptr});
+    }
+  }
+  for (auto& lane : lanes_) pump(*lane);
+}
+
+// Start the lane's queued calls as far as its window allows; a commit
+// only starts once everything before it on the lane has finished
+void BlockBroadcaster::pump(Lane& lane) {
+  std::vector<std::shared_ptr<Ballot>> expired;
+  std::vector<Op> ready;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    while (!lane.ops.empty()) {
+      Op& next = lane.ops.front();
+      if (next.commit ? lane.busy > 0 : lane.busy >= window_) break;
+      Op op = std::move(next);
+      lane.ops.pop_front();
+      if (op.commit) {
+        // Only peers that accepted this block can apply it in order
+        auto key = std::make_pair(op.block->id(), op.block->hash());
+        bool yes = lane.accepted.count(key) != 0;
+        lane.accepted.erase(lane.accepted.begin(),
+                            lane.accepted.upper_bound({key.first, ""}));
+        lane.accepted.erase(key);
+        if (!yes) continue;
+      } else if (std::chrono::system_clock::now() >= op.deadline) {
+        expired.push_back(std::move(op.ballot));
+        continue;
+      }
+      ++lane.busy;
+      ++inflight_;
+      ready.push_back(std::move(op));
+    }
+  }
+  for (auto& b : expired) b->Vote(false);
+  for (auto& op : ready) send(lane, std::move(op));
+}
+
+void BlockBroadcaster::send(Lane& lane, Op op) {
+  bool compact;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    compact = lane.compact;
+  }
+  if (!op.commit) {
+    if (compact && op.compact) {
+      auto msg = op.compact;
+      proposeCompact(lane, std::move(op), std::move(msg), false);
+    } else {
+      proposeFull(lane, std::move(op));
+    }
+    return;
+  }
+  if (!compact) {
+    commitFull(lane, std::move(op));
+    return;
+  }
+
+  struct Call {
+    grpc::ClientContext             ctx;
+    blockchain::BlockCommitRef      ref;
+    blockchain::BlockCommitResponse resp;
+    Op                              op;
+    std::chrono::steady_clock::time_point started;
+  };
+  auto call = std::make_shared<Call>();
+  call->op  = std::move(op);
+  call->started = std::chrono::steady_clock::now();
+  call->ref.set_id(call->op.block->id());
+  call->ref.set_hash(call->op.block->hash());
+  call->ctx.set_deadline(std::chrono::system_clock::now() + commit_timeout_);
+  lane.stub->async()->ConfirmBlock(
+    &call->ctx, &call->ref, &call->resp,
+    [this, &lane, call](grpc::Status status) {
+      report(lane, status, call->started);
+      bool unimplemented = status.error_code() == grpc::StatusCode::UNIMPLEMENTED;
+      if (unimplemented) {
+        std::lock_guard<std::mutex> lk(mu_);
+        lane.compact = false;
+      }
+      // A peer that lost its copy of the block gets the whole thing
+      if (unimplemented ||
+          (status.ok() && call->resp.status() == "unknown_block")) {
+        commitFull(lane, std::move(call->op));
+        return;
+      }
+      if (!status.ok() || call->resp.status() != "success") {
+        std::cerr << "[Broadcast] commit of block " << call->op.block->id()
+                  << " to peer " << lane.index << " failed: "
+                  << (status.ok() ? call->resp.error_message()
+                                  : status.error_message())
+                  << "\n";
+      }
+      finish(lane);
+    });
+}
+
+// Propose by req_id. `filled` marks the retry that carries the audits the
+// peer said it was missing; anything short of a vote after that, or a
+// peer that can't rebuild the block, falls back to the full block.
+void BlockBroadcaster::proposeCompact(
+    Lane& lane, Op op, std::shared_ptr<const blockchain::CompactBlock> msg,
+    bool filled) {
+  struct Call {
+    grpc::ClientContext                             ctx;
+    std::shared_ptr<const blockchain::CompactBlock> msg;
+    blockchain::BlockVoteResponse                   vote;
+    Op                                              op;
+    std::chrono::steady_clock::time_point           started;
+  };
+  auto call = std::make_shared<Call>();
+  call->msg = std::move(msg);
+  call->op  = std::move(op);
+  call->started = std::chrono::steady_clock::now();
+  call->ctx.set_deadline(call->op.deadline);
+  lane.stub->async()->ProposeCompactBlock(
+    &call->ctx, call->msg.get(), &call->vote,
+    [this, &lane, call, filled](grpc::Status status) {
+      report(lane, status, call->started);
+      if (status.error_code() == grpc::StatusCode::UNIMPLEMENTED) {
+        {
+          std::lock_guard<std::mutex> lk(mu_);
+          lane.compact = false;
+        }
+        std::cerr << "[Broadcast] peer " << lane.index
+                  << " has no compact blocks; sending full blocks\n";
+        proposeFull(lane, std::move(call->op));
+        return;
+      }
+      const auto& st = call->vote.status();
+      if (status.ok() && st == "missing" && !filled) {
+        std::unordered_set<std::string> want(
+          call->vote.missing_req_ids().begin(),
+          call->vote.missing_req_ids().end());
+        auto fill = std::make_shared<blockchain::CompactBlock>(*call->msg);
+        for (auto& a : call->op.block->audits()) {
+          if (want.count(a.req_id())) *fill->add_audits() = a;
+        }
+        proposeCompact(lane, std::move(call->op), std::move(fill), true);
+        return;
+      }
+      if (status.ok() && (st == "missing" || st == "full_required")) {
+        std::cerr << "[Broadcast] peer " << lane.index
+                  << " could not rebuild block " << call->op.block->id()
+                  << " (" << (call->vote.error_message().empty()
+                              ? st : call->vote.error_message())
+                  << "); sending it in full\n";
+        proposeFull(lane, std::move(call->op));
+        return;
+      }
+      tally(lane, call->op, status.ok() && call->vote.vote(),
+            status.ok() ? call->vote.error_message() : status.error_message());
+    });
+}
+
+void BlockBroadcaster::proposeFull(Lane& lane, Op op) {
+  struct Call {
+    grpc::ClientContext           ctx;
+    blockchain::BlockVoteResponse vote;
+    Op                            op;
+    std::chrono::steady_clock::time_point started;
+  };
+  auto call = std::make_shared<Call>();
+  call->op  = std::move(op);
+  call->started = std::chrono::steady_clock::now();
+  call->ctx.set_deadline(call->op.deadline);
+  lane.stub->async()->ProposeBlock(
+    &call->ctx, call->op.block.get(), &call->vote,
+    [this, &lane, call](grpc::Status status) {
+      report(lane, status, call->started);
+      tally(lane, call->op, status.ok() && call->vote.vote(),
+            status.ok() ? call->vote.error_message() : status.error_message());
+    });
+}
+
+void BlockBroadcaster::tally(Lane& lane, const Op& op, bool yes,
+                             const std::string& why) {
+  if (!yes) {
+    std::cerr << "[Broadcast] block " << op.block->id()
+              << " rejected by peer " << lane.index << ": " << why << "\n";
+  }
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (yes) lane.accepted.emplace(op.block->id(), op.block->hash());
+  }
+  op.ballot->Vote(yes);
+  finish(lane);
+}
+
+void BlockBroadcaster::commitFull(Lane& lane, Op op) {
+  struct Call {
+    grpc::ClientContext             ctx;
+    blockchain::BlockCommitResponse resp;
+    Op                              op;
+    std::chrono::steady_clock::time_point started;
+  };
+  auto call = std::make_shared<Call>();
+  call->op  = std::move(op);
+  call->started = std::chrono::steady_clock::now();
+  call->ctx.set_deadline(std::chrono::system_clock::now() + commit_timeout_);
+  lane.stub->async()->CommitBlock(
+    &call->ctx, call->op.block.get(), &call->resp,
+    [this, &lane, call](grpc::Status status) {
+      report(lane, status, call->started);
+      if (!status.ok() || call->resp.status() != "success") {
+        std::cerr << "[Broadcast] commit of block " << call->op.block->id()
+                  << " to peer " << lane.index << " failed: "
+                  << (status.ok() ? call->resp.error_message()
+                                  : status.error_message())
+                  << "\n";
+      }
+      finish(lane);
+    });
+}
+
+void BlockBroadcaster::report(Lane& lane, const grpc::Status& status,
+                              std::chrono::steady_clock::time_point started) {
+  if (peers_) {
+    peers_->Report(lane.index, status,
+                   std::chrono::steady_clock::now() - started);
+  }
+}
+
+// Still counted in flight while starting the next call, so the
+// destructor can't return underneath it
+void BlockBroadcaster::finish(Lane& lane) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    --lane.busy;
+  }
+  pump(lane);
+  std::lock_guard<std::mutex> lk(mu_);
+  --inflight_;
+  idle_cv_.notify_all();
+}
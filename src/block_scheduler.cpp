@@ -1,32 +1,78 @@
 // src/block_scheduler.cpp
 
 #include "block_scheduler.h"
-#include "merkle_tree.h"                    // SHA256Hex, ComputeMerkleRoot
-#include <nlohmann/json.hpp>                // ordered_json
+#include "merkle_tree.h"                    // Sha256Stream
+#include <google/protobuf/io/coded_stream.h>
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
-#include <algorithm>
 #include <iostream>
 
 namespace fs = std::filesystem;
-using ordered_json = nlohmann::ordered_json;
 
-static constexpr auto kPeerRpcTimeoutMs = 200;
+static constexpr auto kPeerRpcTimeoutMs   = 200;
+static constexpr auto kCommitRpcTimeoutMs = 2000;
+static constexpr auto kRetryBackoffMs     = 2000;
+static constexpr auto kLeaderPollMs       = 2000;
+
+// Upper bound on a Block's id, hash, previous_hash and merkle_root fields
+static constexpr size_t kBlockHeaderBytes = 256;
+
+// Admits audits into one block while it stays within max_audits and
+// max_bytes. A single oversized audit still gets a block of its own.
+struct BlockBudget {
+  size_t max_audits;
+  size_t max_bytes;
+  size_t audits = 0;
+  size_t bytes  = kBlockHeaderBytes;
+
+  bool operator()(const common::FileAudit& a) {
+    using google::protobuf::io::CodedOutputStream;
+    if (audits >= max_audits) return false;
+    size_t len = a.ByteSizeLong();
+    // repeated FileAudit audits = 4: one tag byte + length prefix + body
+    size_t rec = 1 + CodedOutputStream::VarintSize64(len) + len;
+    if (audits > 0 && bytes + rec > max_bytes) return false;
+    if (audits == 0 && bytes + rec > max_bytes) {
+      std::cerr << "[Scheduler] audit " << a.req_id()
+                << " alone exceeds max_block_bytes\n";
+    }
+    bytes += rec;
+    ++audits;
+    return true;
+  }
+};
 
 BlockScheduler::BlockScheduler(
     std::shared_ptr<MempoolManager> mempool,
     ChainManager&                    chain,
-    StubList&                        stubs,
+    std::shared_ptr<PeerRegistry>    peers,
     const LeaderConfig&              cfg,
-    std::function<bool()>            isLeaderFn
+    std::function<bool()>            isLeaderFn,
+    std::shared_ptr<AuditProofStore> proofs
 )
   : mempool_(std::move(mempool))
   , chain_(chain)
-  , stubs_(stubs)
+  , peers_(std::move(peers))
   , cfg_(cfg)
   , isLeaderFn_(std::move(isLeaderFn))
-{}
+  , proofs_(std::move(proofs))
+  , broadcaster_(peers_->Stubs(),
+                 std::chrono::milliseconds(kPeerRpcTimeoutMs),
+                 std::chrono::milliseconds(kCommitRpcTimeoutMs),
+                 cfg_.getPipelineDepth(), cfg_.getCompactBlocks(), peers_)
+{
+  if (cfg_.getAdaptiveBatching()) {
+    AdaptiveBatchOptions opts;
+    opts.target_latency_ms = cfg_.getTargetCommitLatencyMs();
+    opts.min_batch         = cfg_.getAdaptiveMinBatch();
+    opts.max_batch         = cfg_.getAdaptiveMaxBatch();
+    opts.min_linger_ms     = cfg_.getAdaptiveMinLingerMs();
+    opts.max_linger_ms     = cfg_.getAdaptiveMaxLingerMs();
+    batcher_ = std::make_unique<AdaptiveBatcher>(opts);
+  }
+}
 
 BlockScheduler::~BlockScheduler() {
   stop();
@@ -34,165 +80,271 @@ BlockScheduler::~BlockScheduler() {
 
 void BlockScheduler::start() {
   if (running_.exchange(true)) return;  // already running
-  thr_ = std::thread(&BlockScheduler::loop, this);
+  thr_       = std::thread(&BlockScheduler::loop, this);
+  committer_ = std::thread(&BlockScheduler::commitLoop, this);
 }
 
 void BlockScheduler::stop() {
-  running_ = false;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  flight_cv_.notify_all();
+  mempool_->Wake();
   if (thr_.joinable()) thr_.join();
+  // The committer settles whatever is still in flight, then exits
+  if (committer_.joinable()) committer_.join();
+}
+
+AdaptiveBatcher::Stats BlockScheduler::batchStats() const {
+  return batcher_ ? batcher_->GetStats() : AdaptiveBatcher::Stats{};
+}
+
+// Sleep until `deadline` unless stopped; returns false once stopped.
+bool BlockScheduler::sleepUntil(std::chrono::steady_clock::time_point deadline) {
+  std::unique_lock<std::mutex> lk(mu_);
+  cv_.wait_until(lk, deadline, [&]{ return !running_; });
+  return running_;
 }
 
 void BlockScheduler::loop() {
   using namespace std::chrono;
+  auto cycle_start = steady_clock::now();
+
   while (running_) {
-    auto t0 = steady_clock::now();
-
-    // Wait until enough audits or timeout
-    while (running_) {
-      auto audits = mempool_->LoadAll();
-      if ((int)audits.size() >= cfg_.getBatchSize()) break;
-      if (steady_clock::now() - t0 
-          >= seconds(cfg_.getBatchIntervalSec()))
-        break;
-      std::this_thread::sleep_for(milliseconds(100));
+    size_t                 batch  = static_cast<size_t>(cfg_.getBatchSize());
+    steady_clock::duration linger = seconds(cfg_.getBatchIntervalSec());
+    if (batcher_) {
+      batcher_->ObserveArrivals(mempool_->AdmittedCount(), steady_clock::now());
+      batch  = batcher_->BatchSize();
+      linger = batcher_->Linger();
     }
+    auto deadline = cycle_start + linger;
+
+    // Sleep until the mempool signals a full batch or the linger elapses
+    bool full = mempool_->WaitForSize(batch, deadline);
     if (!running_) break;
+    if (!full && steady_clock::now() < deadline) continue;  // woken early
+    cycle_start = steady_clock::now();
+
+    if (!isLeaderFn_()) {
+      std::cout << "[Scheduler] not leader, skipping\n";
+      // A full mempool would wake us immediately; poll leadership instead
+      if (!sleepUntil(steady_clock::now() + milliseconds(kLeaderPollMs)))
+        break;
+      cycle_start = steady_clock::now();
+      continue;
+    }
 
-    auto pending = mempool_->LoadAll();
+    size_t pending = mempool_->Size();
     std::cout << "[Scheduler] woke up: " 
-              << pending.size() << " audits pending\n";
+              << pending << " audits pending\n";
 
-    if (pending.empty()) {
+    if (pending == 0) {
       std::cout << "[Scheduler] no audits pending, skipping block creation\n";
       continue;
     }
 
-    if (isLeaderFn_()) {
+    // Drain the backlog as back-to-back blocks bounded by count and bytes,
+    // each cut from the front of the mempool with its Merkle root
+    size_t max_audits = cfg_.getMaxBlockAudits();
+    if (batcher_) max_audits = std::min(max_audits, batch);
+    size_t drained = 0;
+    size_t blocks  = 0;
+    bool   failed  = false;
+    while (drained < pending && running_) {
+      if (!waitForSlot()) {
+        failed = true;
+        break;
+      }
+      BlockBudget budget{std::min(max_audits, pending - drained),
+                         cfg_.getMaxBlockBytes()};
+      auto cut = mempool_->ReservePrefix(std::ref(budget));
+      size_t n = cut.audits.size();
+      if (n == 0) break;
+
+      // Audits already on the chain (e.g. left pending by a missed commit)
+      // are pruned, not proposed again
+      std::vector<std::string> committed, rest;
+      for (auto& a : cut.audits) {
+        (proofs_->Contains(a.req_id()) ? committed : rest).push_back(a.req_id());
+      }
+      if (!committed.empty()) {
+        std::cerr << "[Scheduler] dropping " << committed.size()
+                  << " already committed audit(s) from the mempool\n";
+        mempool_->RemoveBatch(committed);
+        mempool_->Release(rest);
+        drained += committed.size();
+        continue;
+      }
+
       std::cout << "[Scheduler] I am leader, creating block\n";
-      createAndBroadcastBlock(std::move(pending));
-    } else {
-      std::cout << "[Scheduler] not leader, skipping\n";
+      if (!proposeBlock(std::move(cut))) {
+        failed = true;
+        break;
+      }
+      ++blocks;
+      drained += n;
+      if (drained < pending && !isLeaderFn_()) break;
+    }
+    if (blocks > 1) {
+      std::cout << "[Scheduler] drained " << drained << " audits in "
+                << blocks << " blocks\n";
+    }
+
+    if (failed) {
+      // Back off before retrying after a rollback
+      if (!sleepUntil(steady_clock::now() + milliseconds(kRetryBackoffMs)))
+        break;
+      cycle_start = steady_clock::now();
+      continue;
+    }
+    if (batcher_ && blocks > 0) {
+      auto st = batcher_->GetStats();
+      std::cout << "[Scheduler] adaptive: rate=" << st.arrival_rate_per_s
+                << "/s round=" << st.round_ms << "ms (" << st.fixed_ms
+                << "ms + " << st.per_audit_ms << "ms/audit) -> batch="
+                << st.batch_size << " linger=" << st.linger_ms << "ms\n";
     }
-    std::this_thread::sleep_for(milliseconds(2000));
   }
 }
 
-void BlockScheduler::createAndBroadcastBlock(
-    std::vector<common::FileAudit> pending
-) {
-  // 1) Sort pending by (timestamp, req_id)
-   std::sort(pending.begin(), pending.end(),
-     [](auto& a, auto& b){
-       if (a.timestamp() != b.timestamp())
-         return a.timestamp() < b.timestamp();
-       return a.req_id() < b.req_id();
-     }
-   );
-
-  // 2) Build Merkle root
-  std::vector<std::string> leaf_hashes;
-  leaf_hashes.reserve(pending.size());
-  for (auto& a : pending) {
-    ordered_json j;
-    j["access_type"] = a.access_type();
-    j["file_info"]   = {
-      {"file_id",   a.file_info().file_id()},
-      {"file_name", a.file_info().file_name()}
-    };
-    j["req_id"]      = a.req_id();
-    j["timestamp"]   = a.timestamp();
-    j["user_info"]   = {
-      {"user_id",   a.user_info().user_id()},
-      {"user_name", a.user_info().user_name()}
-    };
-    leaf_hashes.push_back(SHA256Hex(j.dump()));
-   }
-  
-  auto merkle = ComputeMerkleRoot(leaf_hashes);
-
-  // 3) Fill Block proto
-  blockchain::Block block;
-  int64_t id = chain_.getLastID() + 1;
+// Wait for room in the pipeline. Returns false when stopped, or once
+// (and only once) after a rollback so the caller backs off.
+bool BlockScheduler::waitForSlot() {
+  std::unique_lock<std::mutex> lk(mu_);
+  flight_cv_.wait(lk, [&]{
+    return inflight_.size() < cfg_.getPipelineDepth() || rolled_back_ ||
+           !running_;
+  });
+  if (rolled_back_) {
+    rolled_back_ = false;
+    return false;
+  }
+  return running_;
+}
+
+bool BlockScheduler::proposeBlock(MempoolManager::Prefix cut) {
+  // 1-2) ReservePrefix() yields the audits in (timestamp, req_id) order
+  //      with the canonical encodings and Merkle root cached by the mempool
+  auto& pending = cut.audits;
+  const std::string& merkle = cut.merkle_root;
+
+  InFlight f;
+  f.ids.reserve(pending.size());
+  for (auto& a : pending) f.ids.push_back(a.req_id());
+
+  // 3) Fill Block proto, chained to the last proposed block (the chain
+  //    head when nothing is in flight or being committed)
+  uint64_t generation;
+  int64_t  id;
+  f.block = std::make_shared<blockchain::Block>();
+  blockchain::Block& block = *f.block;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (inflight_.empty() && !committing_) {
+      tip_id_   = chain_.getLastID();
+      tip_hash_ = chain_.getLastHash();
+    }
+    generation = generation_;
+    id = tip_id_ + 1;
+    block.set_previous_hash(tip_hash_);
+  }
   block.set_id(id);
-  block.set_previous_hash(chain_.getLastHash());
   block.set_merkle_root(merkle);
 
   for (auto& a : pending) {
-    *block.add_audits() = a;
+    *block.add_audits() = std::move(a);
   }
 
-  // 4) Compute block_hash by concatenating:
-//    id + previous_hash + merkle_root + JSON(audit1)+JSON(audit2)+…
-  std::string audits_concat;
-  audits_concat.reserve(pending.size() * 128);  // pre-reserve for efficiency
-  for (auto& a : pending) {
-    ordered_json j2;
-    j2["access_type"] = a.access_type();
-    j2["file_info"]   = {
-      {"file_id",   a.file_info().file_id()},
-      {"file_name", a.file_info().file_name()}
-    };
-    j2["req_id"]      = a.req_id();
-    j2["timestamp"]   = a.timestamp();
-    j2["user_info"]   = {
-      {"user_id",   a.user_info().user_id()},
-      {"user_name", a.user_info().user_name()}
-    };
-    // exactly the same compact, sorted JSON string your Python code uses:
-    audits_concat += j2.dump();
-  }
-  // build exactly: "<id><previous_hash><merkle_root><audits_json…>"
-  std::string header = std::to_string(id)
-                    + block.previous_hash()
-                    + merkle
-                    + audits_concat;
-  block.set_hash(SHA256Hex(header));
-
-
-  // 6) Send ProposeBlock to all peers
-  bool all_yes = true;
-  int i = 0;
-  for (auto &stub : stubs_)
+  // 4) Compute block_hash over
+  //    id + previous_hash + merkle_root + JSON(audit1)+JSON(audit2)+…
+  //    streamed piece by piece rather than copied into one header string
+  Sha256Stream hasher;
+  hasher.Update(std::to_string(id))
+        .Update(block.previous_hash())
+        .Update(merkle)
+        .Update(cut.encoded);
+  block.set_hash(hasher.FinalHex());
+
+  // 5) Queue it for the committer unless its parent was rolled back
+  //    meanwhile
   {
-    grpc::ClientContext ctx;
-    // enforce a deadline on this RPC
-    ctx.set_deadline(
-      std::chrono::system_clock::now() +
-      std::chrono::milliseconds(kPeerRpcTimeoutMs)
-    );
-    blockchain::BlockVoteResponse vote_resp;
-    auto status = stub->ProposeBlock(&ctx, block, &vote_resp);
-    if (!vote_resp.vote()) {
-      all_yes = false;
-      std::cerr << "[Scheduler] proposal rejected: "
-                << (status.ok() ? vote_resp.error_message() : status.error_message())
-                << "\n";
-
-      break;
-    } else {
-      std::cout << "[Scheduler] proposal accepted by " << i << "\n";
+    std::lock_guard<std::mutex> lk(mu_);
+    if (generation != generation_) {
+      mempool_->Release(f.ids);
+      rolled_back_ = false;   // the caller backs off now
+      return false;
     }
+    tip_id_   = id;
+    tip_hash_ = block.hash();
+
+    // 6) Propose to all peers at once; a majority of the cluster decides
+    f.ballot  = broadcaster_.StartProposal(f.block);
+    f.leaves  = std::move(cut.leaves);
+    f.started = std::chrono::steady_clock::now();
+    inflight_.push_back(std::move(f));
   }
-  if (!all_yes) return;
-
-  //CommitBlock RPC
-  for (auto& stub : stubs_) {
-    grpc::ClientContext ctx;
-    // enforce a deadline on this RPC too
-    ctx.set_deadline(
-       std::chrono::system_clock::now() +
-      std::chrono::milliseconds(kPeerRpcTimeoutMs)
-    );
-    blockchain::BlockCommitResponse commit_resp;
-    auto status = stub->CommitBlock(&ctx, block, &commit_resp);
-    if (!status.ok() || commit_resp.status() != "success") {
-      std::cerr << "[Scheduler] commit failed: "
-                << (status.ok()
-                    ? commit_resp.error_message()
-                    : status.error_message())
-                << "\n";
+  flight_cv_.notify_all();
+  return true;
+}
+
+// Settle in-flight blocks in proposal order: commit each accepted one,
+// and roll back a rejected one together with everything proposed after it
+void BlockScheduler::commitLoop() {
+  std::unique_lock<std::mutex> lk(mu_);
+  while (true) {
+    flight_cv_.wait(lk, [&]{ return !inflight_.empty() || !running_; });
+    if (inflight_.empty()) break;
+
+    auto ballot = inflight_.front().ballot;
+    auto block  = inflight_.front().block;
+    lk.unlock();
+    bool accepted = ballot->Wait();
+    std::cout << "[Scheduler] block " << block->id()
+              << (accepted ? " accepted: " : " rejected: ")
+              << ballot->Summary() << "\n";
+    // Votes for a child of a block that was never committed don't count
+    accepted = accepted && block->previous_hash() == chain_.getLastHash();
+    lk.lock();
+
+    if (accepted) {
+      // Until the chain has it, tip_ (not the chain head) is the block
+      // new proposals chain to
+      InFlight f = std::move(inflight_.front());
+      inflight_.pop_front();
+      committing_ = true;
+      lk.unlock();
+      commitBlock(f);
+      lk.lock();
+      committing_ = false;
+    } else {
+      std::deque<InFlight> dropped;
+      dropped.swap(inflight_);
+      ++generation_;
+      rolled_back_ = true;
+      lk.unlock();
+      size_t audits = 0;
+      for (auto& f : dropped) {
+        mempool_->Release(f.ids);
+        audits += f.ids.size();
+      }
+      std::cerr << "[Scheduler] rolled back " << dropped.size()
+                << " in-flight block(s) from " << block->id() << " ("
+                << audits << " audits returned to the mempool)\n";
+      lk.lock();
     }
+    flight_cv_.notify_all();
   }
+}
+
+void BlockScheduler::commitBlock(InFlight& f) {
+  const blockchain::Block& block = *f.block;
+  int64_t id = block.id();
+
+  // Peers that voted yes get the commit; stragglers don't hold us up
+  broadcaster_.Commit(f.block);
 
   // 7) Locally commit: update chain.json + prune mempool
   {
@@ -204,10 +356,7 @@ void BlockScheduler::createAndBroadcastBlock(
     };
     chain_.append(meta);
   }
-  std::vector<std::string> ids;
-  ids.reserve(pending.size());
-  for (auto& a : pending) ids.push_back(a.req_id());
-  mempool_->RemoveBatch(ids);
+  mempool_->RemoveBatch(f.ids);
 
   // 8) Dump full block JSON to file
   fs::create_directories("../blocks");
@@ -222,6 +371,13 @@ void BlockScheduler::createAndBroadcastBlock(
               << id << ".json\n";
   }
 
+  // 9) Store the tree levels for inclusion proofs
+  proofs_->Record(block, &f.leaves);
+
+  if (batcher_) {
+    batcher_->ObserveRound(f.ids.size(),
+                           std::chrono::steady_clock::now() - f.started);
+  }
   std::cout << "[Scheduler] committed block " << id
-            << " (" << pending.size() << " audits)\n";
+            << " (" << f.ids.size() << " audits)\n";
 }
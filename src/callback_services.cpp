@@ -0,0 +1,219 @@
+// src/callback_services.cpp
+
+#include "callback_services.h"
+
+namespace {
+
+enum class Plane { kControl, kData };
+
+// Queue `body` (a synchronous handler) on `exec` and finish the call with
+// the status it returns. The unary bodies never touch their
+// grpc::ServerContext, so they are called with none.
+template <class Body>
+grpc::ServerUnaryReactor* Dispatch(grpc::CallbackServerContext* ctx,
+                                   RpcExecutor& exec, Plane plane,
+                                   Body body) {
+  auto* reactor = ctx->DefaultReactor();
+  bool queued = exec.Submit([ctx, reactor, plane, body]() {
+    if (plane == Plane::kData && ctx->IsCancelled()) {
+      reactor->Finish(grpc::Status::CANCELLED);
+      return;
+    }
+    reactor->Finish(body());
+  });
+  if (!queued) {
+    reactor->Finish(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                 exec.Name() + " queue full"));
+  }
+  return reactor;
+}
+
+} // namespace
+
+// --- FileAuditCallbackService ---
+
+FileAuditCallbackService::FileAuditCallbackService(
+    FileAuditServiceImpl& impl,
+    std::shared_ptr<RpcExecutor> data)
+  : impl_(impl)
+  , data_(std::move(data))
+{}
+
+grpc::ServerUnaryReactor* FileAuditCallbackService::SubmitAudit(
+    grpc::CallbackServerContext* ctx,
+    const common::FileAudit* req,
+    fileaudit::FileAuditResponse* resp)
+{
+  return Dispatch(ctx, *data_, Plane::kData, [this, req, resp] {
+    return impl_.SubmitAudit(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* FileAuditCallbackService::SubmitAuditEnvelope(
+    grpc::CallbackServerContext* ctx,
+    const common::AuditEnvelope* req,
+    fileaudit::AuditEnvelopeResponse* resp)
+{
+  return Dispatch(ctx, *data_, Plane::kData, [this, req, resp] {
+    return impl_.SubmitAuditEnvelope(nullptr, req, resp);
+  });
+}
+
+grpc::Status FileAuditCallbackService::SubmitAuditStream(
+    grpc::ServerContext* ctx,
+    grpc::ServerReaderWriter<fileaudit::FileAuditResponse,
+                             common::FileAudit>* stream)
+{
+  return impl_.SubmitAuditStream(ctx, stream);
+}
+
+// --- BlockChainCallbackService ---
+
+BlockChainCallbackService::BlockChainCallbackService(
+    BlockChainServiceImpl& impl,
+    std::shared_ptr<RpcExecutor> control,
+    std::shared_ptr<RpcExecutor> data)
+  : impl_(impl)
+  , control_(std::move(control))
+  , data_(std::move(data))
+{}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::WhisperAuditRequest(
+    grpc::CallbackServerContext* ctx,
+    const common::FileAudit* req,
+    blockchain::WhisperResponse* resp)
+{
+  return Dispatch(ctx, *data_, Plane::kData, [this, req, resp] {
+    return impl_.WhisperAuditRequest(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::WhisperAuditBatch(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::WhisperBatch* req,
+    blockchain::WhisperBatchResponse* resp)
+{
+  return Dispatch(ctx, *data_, Plane::kData, [this, req, resp] {
+    return impl_.WhisperAuditBatch(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::GetMempoolDigest(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::MempoolDigestRequest* req,
+    blockchain::MempoolDigest* resp)
+{
+  return Dispatch(ctx, *data_, Plane::kData, [this, req, resp] {
+    return impl_.GetMempoolDigest(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::GetBucketIds(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::BucketIdsRequest* req,
+    blockchain::BucketIds* resp)
+{
+  return Dispatch(ctx, *data_, Plane::kData, [this, req, resp] {
+    return impl_.GetBucketIds(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::FetchAudits(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::FetchAuditsRequest* req,
+    blockchain::WhisperBatch* resp)
+{
+  return Dispatch(ctx, *data_, Plane::kData, [this, req, resp] {
+    return impl_.FetchAudits(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::GetBlock(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::GetBlockRequest* req,
+    blockchain::GetBlockResponse* resp)
+{
+  return Dispatch(ctx, *data_, Plane::kData, [this, req, resp] {
+    return impl_.GetBlock(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::GetAuditProof(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::GetAuditProofRequest* req,
+    blockchain::GetAuditProofResponse* resp)
+{
+  return Dispatch(ctx, *data_, Plane::kData, [this, req, resp] {
+    return impl_.GetAuditProof(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::ProposeBlock(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::Block* req,
+    blockchain::BlockVoteResponse* resp)
+{
+  return Dispatch(ctx, *control_, Plane::kControl, [this, req, resp] {
+    return impl_.ProposeBlock(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::ProposeCompactBlock(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::CompactBlock* req,
+    blockchain::BlockVoteResponse* resp)
+{
+  return Dispatch(ctx, *control_, Plane::kControl, [this, req, resp] {
+    return impl_.ProposeCompactBlock(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::CommitBlock(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::Block* req,
+    blockchain::BlockCommitResponse* resp)
+{
+  return Dispatch(ctx, *control_, Plane::kControl, [this, req, resp] {
+    return impl_.CommitBlock(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::ConfirmBlock(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::BlockCommitRef* req,
+    blockchain::BlockCommitResponse* resp)
+{
+  return Dispatch(ctx, *control_, Plane::kControl, [this, req, resp] {
+    return impl_.ConfirmBlock(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::SendHeartbeat(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::HeartbeatRequest* req,
+    blockchain::HeartbeatResponse* resp)
+{
+  return Dispatch(ctx, *control_, Plane::kControl, [this, req, resp] {
+    return impl_.SendHeartbeat(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::TriggerElection(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::TriggerElectionRequest* req,
+    blockchain::TriggerElectionResponse* resp)
+{
+  return Dispatch(ctx, *control_, Plane::kControl, [this, req, resp] {
+    return impl_.TriggerElection(nullptr, req, resp);
+  });
+}
+
+grpc::ServerUnaryReactor* BlockChainCallbackService::NotifyLeadership(
+    grpc::CallbackServerContext* ctx,
+    const blockchain::NotifyLeadershipRequest* req,
+    blockchain::NotifyLeadershipResponse* resp)
+{
+  return Dispatch(ctx, *control_, Plane::kControl, [this, req, resp] {
+    return impl_.NotifyLeadership(nullptr, req, resp);
+  });
+}
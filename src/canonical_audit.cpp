@@ -0,0 +1,100 @@
+// src/canonical_audit.cpp
+
+#include "canonical_audit.h"
+#include <charconv>
+#include <cstdint>
+
+// Length of the well-formed UTF-8 sequence starting at s[i] (lead byte
+// >= 0x80), or 0 if it is malformed, overlong, a surrogate or > U+10FFFF.
+static size_t Utf8SequenceLength(const std::string& s, size_t i) {
+  auto at = [&](size_t k) -> unsigned {
+    return i + k < s.size() ? static_cast<unsigned char>(s[i + k]) : 0u;
+  };
+  auto cont = [](unsigned b, unsigned lo = 0x80, unsigned hi = 0xBF) {
+    return b >= lo && b <= hi;
+  };
+  unsigned c = at(0);
+  if (c >= 0xC2 && c <= 0xDF) return cont(at(1)) ? 2 : 0;
+  if (c == 0xE0) return cont(at(1), 0xA0) && cont(at(2)) ? 3 : 0;
+  if (c == 0xED) return cont(at(1), 0x80, 0x9F) && cont(at(2)) ? 3 : 0;
+  if (c >= 0xE1 && c <= 0xEF) return cont(at(1)) && cont(at(2)) ? 3 : 0;
+  if (c == 0xF0) return cont(at(1), 0x90) && cont(at(2)) && cont(at(3)) ? 4 : 0;
+  if (c == 0xF4) return cont(at(1), 0x80, 0x8F) && cont(at(2)) && cont(at(3)) ? 4 : 0;
+  if (c >= 0xF1 && c <= 0xF3) return cont(at(1)) && cont(at(2)) && cont(at(3)) ? 4 : 0;
+  return 0;
+}
+
+// Append `s` as a JSON string literal, escaping like nlohmann's dump().
+static bool AppendString(const std::string& s, std::string* out) {
+  static const char kHex[] = "0123456789abcdef";
+  out->push_back('"');
+  size_t run = 0;   // start of the pending unescaped run
+  size_t i   = 0;
+  while (i < s.size()) {
+    unsigned char c = static_cast<unsigned char>(s[i]);
+    if (c >= 0x80) {
+      size_t len = Utf8SequenceLength(s, i);
+      if (len == 0) return false;
+      i += len;
+      continue;
+    }
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      ++i;
+      continue;
+    }
+    out->append(s, run, i - run);
+    switch (c) {
+      case '"':  out->append("\\\""); break;
+      case '\\': out->append("\\\\"); break;
+      case '\b': out->append("\\b");  break;
+      case '\f': out->append("\\f");  break;
+      case '\n': out->append("\\n");  break;
+      case '\r': out->append("\\r");  break;
+      case '\t': out->append("\\t");  break;
+      default: {
+        char esc[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+        out->append(esc, sizeof(esc));
+      }
+    }
+    run = ++i;
+  }
+  out->append(s, run, s.size() - run);
+  out->push_back('"');
+  return true;
+}
+
+static void AppendInt(int64_t v, std::string* out) {
+  char buf[24];
+  auto res = std::to_chars(buf, buf + sizeof(buf), v);
+  out->append(buf, res.ptr - buf);
+}
+
+bool AppendCanonicalAudit(const common::FileAudit& a, std::string* out) {
+  const auto& f = a.file_info();
+  const auto& u = a.user_info();
+  out->reserve(out->size() + 112 + f.file_id().size() + f.file_name().size()
+               + a.req_id().size() + u.user_id().size() + u.user_name().size());
+
+  out->append("{\"access_type\":");
+  AppendInt(a.access_type(), out);
+  out->append(",\"file_info\":{\"file_id\":");
+  if (!AppendString(f.file_id(), out)) return false;
+  out->append(",\"file_name\":");
+  if (!AppendString(f.file_name(), out)) return false;
+  out->append("},\"req_id\":");
+  if (!AppendString(a.req_id(), out)) return false;
+  out->append(",\"timestamp\":");
+  AppendInt(a.timestamp(), out);
+  out->append(",\"user_info\":{\"user_id\":");
+  if (!AppendString(u.user_id(), out)) return false;
+  out->append(",\"user_name\":");
+  if (!AppendString(u.user_name(), out)) return false;
+  out->append("}}");
+  return true;
+}
+
+std::string CanonicalAudit(const common::FileAudit& audit) {
+  std::string out;
+  if (!AppendCanonicalAudit(audit, &out)) out.clear();
+  return out;
+}
@@ -1,22 +1,26 @@
 // src/client.cpp
 
 #include "file_audit.grpc.pb.h"    // fileaudit::FileAuditService, FileAuditResponse
+#include "block_chain.grpc.pb.h"   // blockchain::BlockChainService, GetAuditProof
 #include "common.grpc.pb.h"        // common::FileAudit
+#include "canonical_audit.h"       // CanonicalAudit
+#include "audit_envelope.h"        // EnvelopeRoot
+#include "merkle_tree.h"           // VerifyMerkleProof, Sha256Stream
 #include <grpcpp/grpcpp.h>
+#include <google/protobuf/util/json_util.h>
 
 #include <openssl/pem.h>
 #include <openssl/evp.h>
 #include <openssl/bio.h>
 #include <openssl/buffer.h>
 
-#include <nlohmann/json.hpp>       // for ordered_json
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <cstdlib>
+#include <thread>
 #include <vector>
 
-using ordered_json = nlohmann::ordered_json;
-
 // Base64‐encode a byte buffer
 static std::string Base64Encode(const unsigned char* buf, size_t len) {
   BIO* b64 = BIO_new(BIO_f_base64());
@@ -38,11 +42,8 @@ static std::string Slurp(const std::string& path) {
   return {std::istreambuf_iterator<char>(in), {}};
 }
 
-// Sign data with SHA256+RSA using a PEM private key
-static std::vector<unsigned char> SignData(
-    const std::string& data,
-    const std::string& privkey_pem_path) 
-{
+// Load a PEM private key, exiting on failure
+static EVP_PKEY* LoadPrivateKey(const std::string& privkey_pem_path) {
   auto pem = Slurp(privkey_pem_path);
   BIO* bio = BIO_new_mem_buf(pem.data(), (int)pem.size());
   EVP_PKEY* pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
@@ -51,7 +52,13 @@ static std::vector<unsigned char> SignData(
     std::cerr << "ERROR loading private key\n";
     exit(1);
   }
+  return pkey;
+}
 
+// Sign data with SHA256+RSA
+static std::vector<unsigned char> SignData(const std::string& data,
+                                           EVP_PKEY* pkey)
+{
   EVP_MD_CTX* ctx = EVP_MD_CTX_new();
   EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, pkey);
   EVP_DigestSignUpdate(ctx, data.data(), data.size());
@@ -62,15 +69,17 @@ static std::vector<unsigned char> SignData(
   sig.resize(sig_len);
 
   EVP_MD_CTX_free(ctx);
-  EVP_PKEY_free(pkey);
   return sig;
 }
 
-int main(int argc, char** argv) {
-  // 1) Build your audit
+// A signed audit of a READ by alice
+static common::FileAudit MakeAudit(const std::string& req_id,
+                                   const std::string& file_id,
+                                   EVP_PKEY* pkey,
+                                   const std::string& pubkey_pem) {
   common::FileAudit req;
-  req.set_req_id("smoke1");
-  req.mutable_file_info()->set_file_id("file123");
+  req.set_req_id(req_id);
+  req.mutable_file_info()->set_file_id(file_id);
   req.mutable_file_info()->set_file_name("important.docx");
   req.mutable_user_info()->set_user_id("user42");
   req.mutable_user_info()->set_user_name("alice");
@@ -80,32 +89,234 @@ int main(int argc, char** argv) {
                ).count();
   req.set_timestamp(ts);
 
-  // 2) Canonical JSON with sorted keys
-  ordered_json j;
-  j["access_type"]       = req.access_type();
-  j["file_info"]         = {{"file_id", req.file_info().file_id()},
-                            {"file_name", req.file_info().file_name()}};
-  j["req_id"]            = req.req_id();
-  j["timestamp"]         = req.timestamp();
-  j["user_info"]         = {{"user_id", req.user_info().user_id()},
-                            {"user_name", req.user_info().user_name()}};
-
-  std::string payload = j.dump(); 
-  std::cout << "[client] payload = " << payload << "\n";
-
-  // 3) Sign
-  auto sig = SignData(payload, "../keys/client_private.pem");
+  auto sig = SignData(CanonicalAudit(req), pkey);
   req.set_signature(Base64Encode(sig.data(), sig.size()));
+  req.set_public_key(pubkey_pem);
+  return req;
+}
+
+// Canonical encoding's digest: the audit's Merkle leaf
+static Digest AuditLeaf(const common::FileAudit& audit) {
+  std::string payload;
+  if (!AppendCanonicalAudit(audit, &payload)) payload.clear();
+  return SHA256Digest(payload.data(), payload.size());
+}
+
+// Prove that the audit saved in `audit_path` was committed. The leaf is
+// hashed here from our own copy of the audit, and the sibling path from
+// `addr` must fold it into the Merkle root of the block as served by a
+// second node, `trusted_addr`, whose header hash is recomputed too.
+// Nothing but the sibling path is taken from `addr` on trust.
+static int ProveAudit(const std::string& addr, const std::string& audit_path,
+                      const std::string& trusted_addr) {
+  common::FileAudit audit;
+  std::string json = Slurp(audit_path);
+  if (json.empty() ||
+      !google::protobuf::util::JsonStringToMessage(json, &audit).ok()) {
+    std::cerr << "ERROR: can't read an audit from " << audit_path << "\n";
+    return 1;
+  }
+  const std::string& req_id = audit.req_id();
+
+  grpc::ClientContext ctx;
+  blockchain::GetAuditProofRequest  req;
+  blockchain::GetAuditProofResponse resp;
+  req.set_req_id(req_id);
+  auto stub = blockchain::BlockChainService::NewStub(
+      grpc::CreateChannel(addr, grpc::InsecureChannelCredentials()));
+  grpc::Status status = stub->GetAuditProof(&ctx, req, &resp);
+  if (!status.ok()) {
+    std::cerr << "RPC failed: " << status.error_message() << "\n";
+    return 1;
+  }
+  if (resp.status() != "success") {
+    std::cerr << "No proof: " << resp.error_message() << "\n";
+    return 1;
+  }
+
+  // The block header, from the second node
+  grpc::ClientContext block_ctx;
+  blockchain::GetBlockRequest  block_req;
+  blockchain::GetBlockResponse block_resp;
+  block_req.set_id(resp.block_id());
+  auto trusted = blockchain::BlockChainService::NewStub(
+      grpc::CreateChannel(trusted_addr, grpc::InsecureChannelCredentials()));
+  status = trusted->GetBlock(&block_ctx, block_req, &block_resp);
+  if (!status.ok() || block_resp.status() != "success") {
+    std::cerr << "No block " << resp.block_id() << " from " << trusted_addr
+              << ": " << (status.ok() ? block_resp.error_message()
+                                      : status.error_message()) << "\n";
+    return 1;
+  }
+  const auto& blk = block_resp.block();
+  Sha256Stream hasher;
+  hasher.Update(std::to_string(blk.id()))
+        .Update(blk.previous_hash())
+        .Update(blk.merkle_root());
+  std::string payload;
+  for (auto& a : blk.audits()) {
+    payload.clear();
+    AppendCanonicalAudit(a, &payload);
+    hasher.Update(payload);
+  }
+  bool header_ok = hasher.FinalHex() == blk.hash() &&
+                   blk.hash() == resp.block_hash();
+
+  Digest leaf = AuditLeaf(audit);
+  std::vector<Digest> siblings(resp.siblings_size());
+  bool parsed = true;
+  for (int i = 0; i < resp.siblings_size(); ++i) {
+    parsed = parsed && HexToDigest(resp.siblings(i), &siblings[i]);
+  }
+  MerkleMode mode = resp.merkle_mode() == "binary" ? MerkleMode::kBinary
+                                                   : MerkleMode::kHexCompat;
+  bool path_ok = parsed && resp.leaf_index() >= 0 &&
+                 VerifyMerkleProof(leaf,
+                                   static_cast<uint64_t>(resp.leaf_index()),
+                                   siblings, mode, blk.merkle_root());
+  bool ok = header_ok && path_ok;
+
+  std::cout << "[client] req_id=" << req_id
+            << " block=" << resp.block_id()
+            << " leaf=" << resp.leaf_index()
+            << " path=" << resp.siblings_size() << " nodes\n"
+            << "[client] block_hash=" << blk.hash() << " (from "
+            << trusted_addr << ", " << (header_ok ? "matches" : "MISMATCH")
+            << ")\n"
+            << "[client] leaf_hash=" << DigestToHex(leaf) << "\n"
+            << "[client] merkle_root=" << blk.merkle_root() << "\n"
+            << "[client] proof " << (ok ? "VALID" : "INVALID") << "\n";
+  return ok ? 0 : 2;
+}
+
+// Push `count` audits over one SubmitAuditStream and count the acks. The
+// writer blocks whenever the stream window is full.
+static int StreamAudits(const std::string& addr, int count,
+                        const std::string& prefix) {
+  EVP_PKEY* pkey = LoadPrivateKey("../keys/client_private.pem");
+  std::string pubkey = Slurp("../keys/client_public.pem");
+
+  auto channel = grpc::CreateChannel(
+      addr, grpc::InsecureChannelCredentials());
+  auto stub = fileaudit::FileAuditService::NewStub(channel);
+
+  grpc::ClientContext ctx;
+  auto stream = stub->SubmitAuditStream(&ctx);
+  auto t0 = std::chrono::steady_clock::now();
+
+  std::thread writer([&] {
+    for (int i = 0; i < count; ++i) {
+      auto id = prefix + std::to_string(i);
+      if (!stream->Write(MakeAudit(id, "file-" + id, pkey, pubkey))) break;
+    }
+    stream->WritesDone();
+  });
+
+  int ok = 0, failed = 0;
+  fileaudit::FileAuditResponse resp;
+  while (stream->Read(&resp)) {
+    if (resp.status() == "success") {
+      ++ok;
+    } else {
+      ++failed;
+      std::cerr << "[client] req_id=" << resp.req_id() << " "
+                << resp.status() << ": " << resp.error_message() << "\n";
+    }
+  }
+  writer.join();
+  grpc::Status status = stream->Finish();
+  EVP_PKEY_free(pkey);
 
-  // 4) Attach public key
-  req.set_public_key(Slurp("../keys/client_public.pem"));
+  double secs = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - t0).count();
+  std::cout << "[client] streamed " << count << " audits: " << ok
+            << " ok, " << failed << " failed in " << secs << " s ("
+            << (secs > 0 ? (ok + failed) / secs : 0) << "/s)\n";
+  if (!status.ok()) {
+    std::cerr << "RPC failed: " << status.error_message() << "\n";
+    return 1;
+  }
+  return ok + failed == count && failed == 0 ? 0 : 2;
+}
+
+// Sign `count` audits with one signature over their envelope root and
+// submit them in one SubmitAuditEnvelope call
+static int SubmitEnvelope(const std::string& addr, int count,
+                          const std::string& prefix) {
+  common::AuditEnvelope env;
+  int64_t ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()
+               ).count();
+  for (int i = 0; i < count; ++i) {
+    auto* a = env.add_audits();
+    a->set_req_id(prefix + std::to_string(i));
+    a->mutable_file_info()->set_file_id("file-" + a->req_id());
+    a->mutable_file_info()->set_file_name("important.docx");
+    a->mutable_user_info()->set_user_id("user42");
+    a->mutable_user_info()->set_user_name("alice");
+    a->set_access_type(common::READ);
+    a->set_timestamp(ts);
+  }
+  std::string root = EnvelopeRoot(env.audits());
+  if (root.empty()) {
+    std::cerr << "ERROR: empty envelope\n";
+    return 1;
+  }
+  EVP_PKEY* pkey = LoadPrivateKey("../keys/client_private.pem");
+  auto sig = SignData(root, pkey);
+  EVP_PKEY_free(pkey);
+  env.set_signature(Base64Encode(sig.data(), sig.size()));
+  env.set_public_key(Slurp("../keys/client_public.pem"));
+
+  auto channel = grpc::CreateChannel(
+      addr, grpc::InsecureChannelCredentials());
+  auto stub = fileaudit::FileAuditService::NewStub(channel);
+  grpc::ClientContext ctx;
+  fileaudit::AuditEnvelopeResponse resp;
+  grpc::Status status = stub->SubmitAuditEnvelope(&ctx, env, &resp);
+  if (!status.ok()) {
+    std::cerr << "RPC failed: " << status.error_message() << "\n";
+    return 1;
+  }
+  std::cout << "[client] envelope root=" << root << " audits=" << count
+            << " added=" << resp.added() << " status=" << resp.status()
+            << "\n";
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  // ./client <addr> --prove <audit.json> <trusted_addr>: verify an
+  //   audit's inclusion
+  if (argc > 4 && std::string(argv[2]) == "--prove") {
+    return ProveAudit(argv[1], argv[3], argv[4]);
+  }
+
+  // ./client <addr> --stream <count> [req_id prefix]: bulk ingestion
+  if (argc > 3 && std::string(argv[2]) == "--stream") {
+    return StreamAudits(argv[1], std::atoi(argv[3]),
+                        argc > 4 ? argv[4] : "stream-");
+  }
+
+  // ./client <addr> --envelope <count> [req_id prefix]: one signature
+  if (argc > 3 && std::string(argv[2]) == "--envelope") {
+    return SubmitEnvelope(argv[1], std::atoi(argv[3]),
+                          argc > 4 ? argv[4] : "env-");
+  }
+
+  // 1) Build and sign your audit (canonical JSON with sorted keys) and
+  //    attach the public key
+  EVP_PKEY* pkey = LoadPrivateKey("../keys/client_private.pem");
+  common::FileAudit req = MakeAudit("smoke1", "file123", pkey,
+                                    Slurp("../keys/client_public.pem"));
+  EVP_PKEY_free(pkey);
+  std::cout << "[client] payload = " << CanonicalAudit(req) << "\n";
 
   std::string addr = "0.0.0.0:50051";
   if (argc > 1) {
     addr = argv[1];
   }
 
-  // 5) Send
+  // 2) Send
   auto channel = grpc::CreateChannel(
       addr, grpc::InsecureChannelCredentials());
   auto stub = fileaudit::FileAuditService::NewStub(channel);
@@ -120,5 +331,12 @@ int main(int argc, char** argv) {
   }
   std::cout << "Got response: req_id=" << resp.req_id()
             << ", status="  << resp.status()  << "\n";
+
+  // 3) Keep our copy of the audit: --prove hashes its leaf from it
+  std::string json;
+  google::protobuf::util::MessageToJsonString(req, &json);
+  std::string path = req.req_id() + ".json";
+  std::ofstream(path) << json;
+  std::cout << "[client] saved audit to " << path << "\n";
   return 0;
 }
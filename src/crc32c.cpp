@@ -0,0 +1,46 @@
+#include "crc32c.h"
+#include <array>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#if !defined(__SSE4_2__)
+namespace {
+
+// Reflected Castagnoli polynomial
+constexpr uint32_t kPoly = 0x82F63B78u;
+
+std::array<uint32_t, 256> MakeTable() {
+  std::array<uint32_t, 256> t{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; ++k)
+      c = (c & 1) ? (c >> 1) ^ kPoly : (c >> 1);
+    t[i] = c;
+  }
+  return t;
+}
+
+}  // namespace
+#endif
+
+uint32_t Crc32c(const void* data, size_t len, uint32_t crc) {
+  auto p = static_cast<const unsigned char*>(data);
+  crc = ~crc;
+#if defined(__SSE4_2__)
+  // Hardware CRC32 instruction when the build targets SSE4.2
+  while (len >= 8) {
+    uint64_t v;
+    __builtin_memcpy(&v, p, 8);
+    crc = static_cast<uint32_t>(_mm_crc32_u64(crc, v));
+    p += 8;
+    len -= 8;
+  }
+  while (len--) crc = _mm_crc32_u8(crc, *p++);
+#else
+  static const std::array<uint32_t, 256> table = MakeTable();
+  while (len--) crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+#endif
+  return ~crc;
+}
@@ -2,26 +2,20 @@
 #include <iostream>
 
 ElectionManager::ElectionManager(
-    const std::vector<std::string>& peers,
+    std::shared_ptr<PeerRegistry> peers,
     const std::string& self_addr,
     std::shared_ptr<HeartbeatTable> hb_table,
     ElectionState& state,
     std::shared_ptr<MempoolManager> mempool,
     ChainManager& chain
 )
-  : self_addr_(self_addr)
+  : peers_(std::move(peers))
+  , self_addr_(self_addr)
   , hb_table_(std::move(hb_table))
   , state_(state)
   , mempool_(std::move(mempool))
   , chain_(chain)
 {
-  for (auto& addr : peers) {
-    auto chan = grpc::CreateChannel(addr, grpc::InsecureChannelCredentials());
-    stubs_.push_back(
-      blockchain::BlockChainService::NewStub(chan)
-    );
-    peer_addrs_.push_back(addr);
-  }
 }
 
 ElectionManager::~ElectionManager() {
@@ -60,8 +54,13 @@ void ElectionManager::loop() {
       // 2) vote for self
       int votesAccept = 1, votesReject = 0;
 
-      // 3) ask others
-      for (size_t i = 0; i < stubs_.size(); ++i) {
+      // 3) ask others, skipping peers known to be down
+      for (size_t i : peers_->Ordered()) {
+        if (!peers_->IsUp(i)) {
+          std::cout << "[ElectionManager] skipping " << peers_->Addr(i)
+                    << " (down)\n";
+          continue;
+        }
         grpc::ClientContext ctx;
         ctx.set_deadline(std::chrono::system_clock::now() +
                          std::chrono::seconds(1));
@@ -70,14 +69,16 @@ void ElectionManager::loop() {
         req.set_address(self_addr_);
         blockchain::TriggerElectionResponse resp;
 
-        auto status = stubs_[i]->TriggerElection(&ctx, req, &resp);
+        auto t0 = std::chrono::steady_clock::now();
+        auto status = peers_->Stub(i)->TriggerElection(&ctx, req, &resp);
+        peers_->Report(i, status, std::chrono::steady_clock::now() - t0);
         if (resp.vote()) {
           votesAccept++;
-          std::cout << "[ElectionManager] got vote from " << peer_addrs_[i]
+          std::cout << "[ElectionManager] got vote from " << peers_->Addr(i)
                     << "\n";
         } else if(resp.vote() == false && status.ok()) {
           votesReject++;
-          std::cout << "[ElectionManager] no vote from " << peer_addrs_[i]
+          std::cout << "[ElectionManager] no vote from " << peers_->Addr(i)
                     << ": " << status.error_message() << "\n";
         }
       }
@@ -91,18 +92,21 @@ void ElectionManager::loop() {
         std::cout << "[ElectionManager] I won election, leader=" << self_addr_ << "\n";
 
         // 5) notify all peers
-        for (size_t i = 0; i < stubs_.size(); ++i) {
+        for (size_t i : peers_->Ordered()) {
+          if (!peers_->IsUp(i)) continue;
           grpc::ClientContext ctx;
           ctx.set_deadline(std::chrono::system_clock::now() +
                            std::chrono::seconds(1));
           blockchain::NotifyLeadershipRequest req2;
           req2.set_address(self_addr_);
           blockchain::NotifyLeadershipResponse resp2;
-          stubs_[i]->NotifyLeadership(&ctx, req2, &resp2);
+          auto t0 = std::chrono::steady_clock::now();
+          auto status = peers_->Stub(i)->NotifyLeadership(&ctx, req2, &resp2);
+          peers_->Report(i, status, std::chrono::steady_clock::now() - t0);
         }
       } else {
         std::cout << "[ElectionManager] lost election (" << votesAccept
-                  << "/" << peer_addrs_.size() << ")\n";
+                  << "/" << peers_->Size() << ")\n";
       }
     }
 
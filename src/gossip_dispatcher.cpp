@@ -0,0 +1,196 @@
+// src/gossip_dispatcher.cpp
+
+#include "gossip_dispatcher.h"
+#include <algorithm>
+#include <iostream>
+
+GossipDispatcher::GossipDispatcher(std::shared_ptr<PeerRegistry> peers,
+                                   GossipOptions opts)
+  : opts_(opts)
+  , registry_(std::move(peers))
+{
+  opts_.queue_limit = std::max<size_t>(opts_.queue_limit, 1);
+  opts_.max_batch   = std::max<size_t>(opts_.max_batch, 1);
+  for (size_t i = 0; i < registry_->Size(); ++i) {
+    std::cout << "[Gossip] to peer=" << registry_->Addr(i) << "\n";
+    auto p = std::make_unique<Peer>();
+    p->index      = i;
+    p->stats.addr = registry_->Addr(i);
+    order_.push_back(peers_.size());
+    peers_.push_back(std::move(p));
+  }
+}
+
+GossipDispatcher::~GossipDispatcher() {
+  stop();
+}
+
+void GossipDispatcher::start() {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (running_) return;
+  running_ = true;
+  for (auto& p : peers_) {
+    p->thr = std::thread(&GossipDispatcher::loop, this, std::ref(*p));
+  }
+}
+
+void GossipDispatcher::stop() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  for (auto& p : peers_) {
+    if (p->thr.joinable()) p->thr.join();
+  }
+}
+
+void GossipDispatcher::Enqueue(const common::FileAudit& audit) {
+  if (peers_.empty()) return;
+  auto shared = std::make_shared<const common::FileAudit>(audit);
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    uint64_t seq = ++next_seq_;
+    size_t targets = peers_.size();
+    if (Epidemic()) {
+      // Partial Fisher-Yates over up peers: drawn peers that are up move to
+      // the front. If too few are up, the draws that were down (now right
+      // after them) make up the fanout.
+      targets = opts_.fanout;
+      size_t up = 0;
+      for (size_t i = 0; i < order_.size() && up < targets; ++i) {
+        std::uniform_int_distribution<size_t> pick(i, order_.size() - 1);
+        std::swap(order_[i], order_[pick(rng_)]);
+        if (registry_->IsUp(peers_[order_[i]]->index)) {
+          std::swap(order_[up++], order_[i]);
+        }
+      }
+    }
+    for (size_t t = 0; t < targets; ++t) {
+      auto& p = peers_[order_[t]];
+      if (p->queue.size() >= opts_.queue_limit) {
+        p->queue.pop_front();
+        ++p->stats.dropped;
+        if (!p->dropping) {
+          p->dropping = true;
+          std::cerr << "[Gossip] queue for " << p->stats.addr
+                    << " full; dropping oldest audits\n";
+        }
+      }
+      p->queue.push_back(Item{seq, shared});
+    }
+  }
+  cv_.notify_all();
+}
+
+std::vector<GossipDispatcher::PeerStats> GossipDispatcher::GetStats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  std::vector<PeerStats> out;
+  out.reserve(peers_.size());
+  for (auto& p : peers_) {
+    out.push_back(p->stats);
+    out.back().depth = p->queue.size();
+  }
+  return out;
+}
+
+// Send the front of the queue until stopped. A batch stays queued until
+// delivered, so a full queue may drop audits out from under it; those are
+// popped by sequence number rather than count.
+void GossipDispatcher::loop(Peer& p) {
+  std::chrono::milliseconds backoff{0};
+  std::unique_lock<std::mutex> lk(mu_);
+  while (true) {
+    cv_.wait(lk, [&]{ return !running_ || !p.queue.empty(); });
+    if (!running_) break;
+
+    // Another subsystem found the peer down: skip straight to the longest
+    // backoff instead of timing out on it first
+    if (backoff.count() == 0 && !registry_->IsUp(p.index)) {
+      backoff = opts_.max_backoff;
+      cv_.wait_for(lk, backoff, [&]{ return !running_; });
+      continue;
+    }
+
+    size_t n = std::min(p.queue.size(), opts_.max_batch);
+    std::vector<Item> batch(p.queue.begin(), p.queue.begin() + n);
+    lk.unlock();
+    bool ok = deliver(p, batch);
+    lk.lock();
+
+    if (ok) {
+      uint64_t last = batch.back().seq;
+      while (!p.queue.empty() && p.queue.front().seq <= last) {
+        p.queue.pop_front();
+      }
+      p.stats.sent += batch.size();
+      p.dropping = false;
+      if (backoff.count() > 0) {
+        std::cout << "[Gossip] " << p.stats.addr << " reachable again\n";
+        backoff = std::chrono::milliseconds(0);
+      }
+      continue;
+    }
+
+    ++p.stats.failures;
+    if (backoff.count() == 0) {
+      backoff = opts_.min_backoff;
+    } else {
+      backoff = std::min(backoff * 2, opts_.max_backoff);
+    }
+    cv_.wait_for(lk, backoff, [&]{ return !running_; });
+  }
+}
+
+bool GossipDispatcher::deliver(Peer& p, const std::vector<Item>& batch) {
+  if (p.batch_rpc) {
+    blockchain::WhisperBatch req;
+    req.mutable_audits()->Reserve(static_cast<int>(batch.size()));
+    for (auto& item : batch) *req.add_audits() = *item.audit;
+
+    grpc::ClientContext ctx;
+    ctx.set_deadline(std::chrono::system_clock::now() + opts_.rpc_timeout);
+    blockchain::WhisperBatchResponse resp;
+    auto t0 = std::chrono::steady_clock::now();
+    auto st = registry_->Stub(p.index)->WhisperAuditBatch(&ctx, req, &resp);
+    registry_->Report(p.index, st, std::chrono::steady_clock::now() - t0);
+    if (st.error_code() != grpc::StatusCode::UNIMPLEMENTED) {
+      if (!st.ok() || resp.status() != "success") {
+        std::cerr << "[Gossip] batch of " << batch.size() << " to "
+                  << p.stats.addr << " failed: "
+                  << (st.ok() ? resp.error_message() : st.error_message())
+                  << "\n";
+        return false;
+      }
+      for (auto& id : resp.rejected_req_ids()) {
+        std::cerr << "[Gossip] " << p.stats.addr
+                  << " rejected req_id=" << id << "\n";
+      }
+      return true;
+    }
+    std::cerr << "[Gossip] " << p.stats.addr
+              << " has no WhisperAuditBatch; whispering one audit at a time\n";
+    p.batch_rpc = false;
+  }
+
+  // Audits already delivered before a failure are resent on retry; the
+  // peer's mempool ignores the duplicates
+  for (auto& item : batch) {
+    grpc::ClientContext ctx;
+    ctx.set_deadline(std::chrono::system_clock::now() + opts_.rpc_timeout);
+    blockchain::WhisperResponse resp;
+    auto t0 = std::chrono::steady_clock::now();
+    auto st = registry_->Stub(p.index)->WhisperAuditRequest(&ctx, *item.audit,
+                                                            &resp);
+    registry_->Report(p.index, st, std::chrono::steady_clock::now() - t0);
+    if (st.error_code() == grpc::StatusCode::INVALID_ARGUMENT) {
+      std::cerr << "[Gossip] " << p.stats.addr << " rejected req_id="
+                << item.audit->req_id() << ": " << st.error_message() << "\n";
+    } else if (!st.ok()) {
+      std::cerr << "[Gossip] to " << p.stats.addr << " failed: "
+                << st.error_message() << "\n";
+      return false;
+    }
+  }
+  return true;
+}
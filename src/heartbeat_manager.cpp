@@ -8,23 +8,23 @@
 namespace fs = std::filesystem;
 
 HeartbeatManager::HeartbeatManager(
-    const std::vector<std::string>& peers,
+    std::shared_ptr<PeerRegistry>   peers,
     const std::string&              self_addr,
     ElectionState&                  state,
     std::shared_ptr<MempoolManager> mempool,
     ChainManager&                   chain,
-    std::shared_ptr<HeartbeatTable> table)
-  : self_addr_(self_addr)
+    std::shared_ptr<HeartbeatTable> table,
+    std::shared_ptr<VerifiedAuditCache> audit_cache,
+    std::shared_ptr<AuditProofStore> proofs)
+  : peers_(std::move(peers))
+  , self_addr_(self_addr)
   , state_(state)
   , mempool_(std::move(mempool))
   , chain_(chain)
   , table_(std::move(table))
+  , audit_cache_(std::move(audit_cache))
+  , proofs_(std::move(proofs))
 {
-  for (auto& addr : peers) {
-    auto chan = grpc::CreateChannel(addr, grpc::InsecureChannelCredentials());
-    stubs_.push_back(blockchain::BlockChainService::NewStub(chan));
-    peer_addrs_.push_back(addr);
-  }
 }
 
 HeartbeatManager::~HeartbeatManager() {
@@ -48,18 +48,20 @@ void HeartbeatManager::loop() {
     req.set_from_address(self_addr_);
     req.set_current_leader_address(state_.getLeader());
     req.set_latest_block_id(chain_.getLastID());
-    req.set_mem_pool_size((int64_t)mempool_->LoadAll().size());
+    req.set_mem_pool_size((int64_t)mempool_->Size());
 
-    // Send to each peer
-    for (size_t i = 0; i < stubs_.size(); ++i) {
-      auto& stub = stubs_[i];
-      const auto& peer = peer_addrs_[i];
+    // Send to each peer, down ones included: heartbeats are what bring
+    // a peer back up in the registry
+    for (size_t i = 0; i < peers_->Size(); ++i) {
+      const auto& peer = peers_->Addr(i);
 
       grpc::ClientContext ctx;
       ctx.set_deadline(std::chrono::system_clock::now() +
                        std::chrono::seconds(1));  // 1s timeout
       blockchain::HeartbeatResponse resp;
-      auto status = stub->SendHeartbeat(&ctx, req, &resp);
+      auto t0 = std::chrono::steady_clock::now();
+      auto status = peers_->Stub(i)->SendHeartbeat(&ctx, req, &resp);
+      peers_->Report(i, status, std::chrono::steady_clock::now() - t0);
       if (!status.ok()) {
         std::cerr << "[Heartbeat] to " << peer
                   << " failed: " << status.error_message() << "\n";
@@ -71,7 +73,7 @@ void HeartbeatManager::loop() {
       self_addr_,
       state_.getLeader(),
       chain_.getLastID(),
-      (int64_t)mempool_->LoadAll().size()
+      (int64_t)mempool_->Size()
     );
     table_->sweep();
 
@@ -114,9 +116,11 @@ void HeartbeatManager::fetchBlocksFromPeer(
     int64_t endId)
 {
   // look up which stub corresponds to `peer`
-  auto it = std::find(peer_addrs_.begin(), peer_addrs_.end(), peer);
-  if (it == peer_addrs_.end()) return;
-  auto& stub = stubs_[std::distance(peer_addrs_.begin(), it)];
+  const auto& addrs = peers_->Addrs();
+  auto it = std::find(addrs.begin(), addrs.end(), peer);
+  if (it == addrs.end()) return;
+  size_t i   = std::distance(addrs.begin(), it);
+  auto* stub = peers_->Stub(i);
 
   std::cout << "[Sync] fetching blocks " << startId
             << "–" << endId << " from " << peer << "\n";
@@ -129,7 +133,9 @@ void HeartbeatManager::fetchBlocksFromPeer(
     blockchain::GetBlockResponse gb_resp;
     gb_req.set_id(id);
 
+    auto t0 = std::chrono::steady_clock::now();
     auto status = stub->GetBlock(&ctx, gb_req, &gb_resp);
+    peers_->Report(i, status, std::chrono::steady_clock::now() - t0);
     if (!status.ok() || gb_resp.status() != "success") {
       std::cerr << "[Sync] failed to get block " << id
                 << ": " << (status.ok()
@@ -140,14 +146,27 @@ void HeartbeatManager::fetchBlocksFromPeer(
       std::cout << "[Sync] got block " << id << "\n";
     }
 
-    // commit into chain.json
+    // only commit blocks whose audits all carry valid signatures
     const auto& blk = gb_resp.block();
+    size_t bad = audit_cache_->VerifyBatch(blk.audits());
+    if (bad < static_cast<size_t>(blk.audits_size())) {
+      std::cerr << "[Sync] block " << id << " has invalid signature for "
+                << blk.audits(bad).req_id() << ", stopping sync\n";
+      return;
+    }
+
+    // commit into chain.json
     BlockMeta meta { blk.id(),
                      blk.hash(),
                      blk.previous_hash(),
                      blk.merkle_root() };
     chain_.append(meta);
 
+    // prune its audits from the mempool, as a commit from the leader would
+    std::vector<std::string> ids;
+    for (auto& a : blk.audits()) ids.push_back(a.req_id());
+    mempool_->RemoveBatch(ids);
+
     // write full block JSON file
     try {
       fs::create_directories("../blocks");
@@ -156,6 +175,7 @@ void HeartbeatManager::fetchBlocksFromPeer(
       std::ofstream out("../blocks/block_" + std::to_string(id) + ".json");
       out << json;
       std::cout << "[Sync] committed block " << id << "\n";
+      proofs_->Record(blk);
     } catch (std::exception& e) {
       std::cerr << "[Sync] error writing block file " << id
                 << ": " << e.what() << "\n";
@@ -1,4 +1,5 @@
 #include "leader_config.h"
+#include <cstdint>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <stdexcept>
@@ -30,4 +31,108 @@ LeaderConfig::LeaderConfig(const std::string& path) {
   leader_addr_       = j.at("leader_addr").get<std::string>();
   batch_size_        = j.at("batch_size").get<int>();
   batch_interval_s_  = j.at("batch_interval_s").get<int>();
+
+  // Optional tuning fields
+  pubkey_cache_size_ = j.value("pubkey_cache_size", pubkey_cache_size_);
+  verified_audit_cache_size_ =
+    j.value("verified_audit_cache_size", verified_audit_cache_size_);
+  crypto_threads_ = j.value("crypto_threads", crypto_threads_);
+  merkle_mode_ = j.value("merkle_mode", merkle_mode_);
+  if (merkle_mode_ != "hex" && merkle_mode_ != "binary") {
+    throw std::runtime_error(
+      "leader.json merkle_mode must be \"hex\" or \"binary\"");
+  }
+  max_block_bytes_  = j.value("max_block_bytes", max_block_bytes_);
+  max_block_audits_ = j.value("max_block_audits", max_block_audits_);
+  if (max_block_bytes_ == 0 || max_block_audits_ == 0) {
+    throw std::runtime_error(
+      "leader.json max_block_bytes and max_block_audits must be positive");
+  }
+  pipeline_depth_ = j.value("pipeline_depth", pipeline_depth_);
+  if (pipeline_depth_ == 0) {
+    throw std::runtime_error("leader.json pipeline_depth must be positive");
+  }
+  compact_blocks_ = j.value("compact_blocks", compact_blocks_);
+
+  mempool_format_ = j.value("mempool_format", mempool_format_);
+  if (mempool_format_ != "json" && mempool_format_ != "binary") {
+    throw std::runtime_error(
+      "leader.json mempool_format must be \"json\" or \"binary\"");
+  }
+  mempool_segment_bytes_ =
+    j.value("mempool_segment_bytes", mempool_segment_bytes_);
+  mempool_compact_live_ratio_ =
+    j.value("mempool_compact_live_ratio", mempool_compact_live_ratio_);
+  mempool_compact_interval_ms_ =
+    j.value("mempool_compact_interval_ms", mempool_compact_interval_ms_);
+  mempool_group_commit_window_us_ =
+    j.value("mempool_group_commit_window_us", mempool_group_commit_window_us_);
+  mempool_fsync_ = j.value("mempool_fsync", mempool_fsync_);
+
+  adaptive_batching_ = j.value("adaptive_batching", adaptive_batching_);
+  target_commit_latency_ms_ =
+    j.value("target_commit_latency_ms", target_commit_latency_ms_);
+  adaptive_min_batch_ = j.value("adaptive_min_batch", adaptive_min_batch_);
+  adaptive_max_batch_ = j.value("adaptive_max_batch", adaptive_max_batch_);
+  adaptive_min_linger_ms_ =
+    j.value("adaptive_min_linger_ms", adaptive_min_linger_ms_);
+  adaptive_max_linger_ms_ =
+    j.value("adaptive_max_linger_ms", adaptive_max_linger_ms_);
+  if (adaptive_min_batch_ == 0 || adaptive_max_batch_ < adaptive_min_batch_ ||
+      adaptive_min_linger_ms_ < 0 ||
+      adaptive_max_linger_ms_ < adaptive_min_linger_ms_) {
+    throw std::runtime_error(
+      "leader.json adaptive batch/linger bounds are inconsistent");
+  }
+
+  gossip_queue_limit_ = j.value("gossip_queue_limit", gossip_queue_limit_);
+  gossip_fanout_      = j.value("gossip_fanout", gossip_fanout_);
+  gossip_batch_max_   = j.value("gossip_batch_max", gossip_batch_max_);
+  gossip_timeout_ms_  = j.value("gossip_timeout_ms", gossip_timeout_ms_);
+  gossip_max_backoff_ms_ =
+    j.value("gossip_max_backoff_ms", gossip_max_backoff_ms_);
+  if (gossip_queue_limit_ == 0 || gossip_batch_max_ == 0 ||
+      gossip_timeout_ms_ <= 0 || gossip_max_backoff_ms_ <= 0) {
+    throw std::runtime_error("leader.json gossip_* settings must be positive");
+  }
+  anti_entropy_interval_ms_ =
+    j.value("anti_entropy_interval_ms", anti_entropy_interval_ms_);
+  if (anti_entropy_interval_ms_ < 0) {
+    throw std::runtime_error(
+      "leader.json anti_entropy_interval_ms must not be negative");
+  }
+
+  peer_keepalive_ms_ = j.value("peer_keepalive_ms", peer_keepalive_ms_);
+  peer_keepalive_timeout_ms_ =
+    j.value("peer_keepalive_timeout_ms", peer_keepalive_timeout_ms_);
+  peer_max_message_bytes_ =
+    j.value("peer_max_message_bytes", peer_max_message_bytes_);
+  peer_down_after_failures_ =
+    j.value("peer_down_after_failures", peer_down_after_failures_);
+  if (peer_keepalive_ms_ <= 0 || peer_keepalive_timeout_ms_ <= 0 ||
+      peer_max_message_bytes_ == 0 || peer_down_after_failures_ == 0 ||
+      peer_max_message_bytes_ > static_cast<size_t>(INT32_MAX)) {
+    throw std::runtime_error(
+      "leader.json peer_* settings must be positive (and messages < 2 GiB)");
+  }
+
+  rpc_control_threads_ = j.value("rpc_control_threads", rpc_control_threads_);
+  rpc_control_queue_limit_ =
+    j.value("rpc_control_queue_limit", rpc_control_queue_limit_);
+  rpc_data_threads_ = j.value("rpc_data_threads", rpc_data_threads_);
+  rpc_data_queue_limit_ =
+    j.value("rpc_data_queue_limit", rpc_data_queue_limit_);
+  rpc_stream_threads_ = j.value("rpc_stream_threads", rpc_stream_threads_);
+  if (rpc_control_threads_ == 0 || rpc_data_threads_ == 0 ||
+      rpc_stream_threads_ == 1) {
+    throw std::runtime_error(
+      "leader.json rpc_*_threads must be positive (rpc_stream_threads "
+      "0 or at least 2)");
+  }
+
+  stats_interval_ms_ = j.value("stats_interval_ms", stats_interval_ms_);
+  if (stats_interval_ms_ < 0) {
+    throw std::runtime_error(
+      "leader.json stats_interval_ms must not be negative");
+  }
 }
@@ -7,6 +7,13 @@
 #include "heartbeat_manager.h"
 #include "election_state.h"
 #include "election_manager.h"
+#include "worker_pool.h"
+#include "gossip_dispatcher.h"
+#include "mempool_reconciler.h"
+#include "peer_registry.h"
+#include "rpc_executor.h"
+#include "callback_services.h"
+#include "stats_reporter.h"
 #include <grpcpp/grpcpp.h>
 #include <iostream>
 
@@ -16,11 +23,29 @@ int main(int argc, char** argv) {
   std::cout << "Loaded peers:\n";
   for (auto& p : peers) std::cout << "  - " << p << "\n";
 
-  // Shared mempool manager
-  auto mempool = std::make_shared<MempoolManager>("../mempool.dat");
+  // Leader config & chain state
+  LeaderConfig cfg("../leader.json");
+  ChainManager chain("../chain.json");
+
+  // Shared mempool manager (replays the recovery log once)
+  MempoolOptions mempool_opts;
+  mempool_opts.format = cfg.getMempoolFormat() == "binary"
+                        ? MempoolFormat::kBinary : MempoolFormat::kJson;
+  mempool_opts.segment_bytes       = cfg.getMempoolSegmentBytes();
+  mempool_opts.compact_live_ratio  = cfg.getMempoolCompactLiveRatio();
+  mempool_opts.compact_interval_ms = cfg.getMempoolCompactIntervalMs();
+  mempool_opts.group_commit_window_us = cfg.getMempoolGroupCommitWindowUs();
+  mempool_opts.fsync               = cfg.getMempoolFsync();
+  mempool_opts.merkle_mode = cfg.getMerkleMode() == "binary"
+                             ? MerkleMode::kBinary : MerkleMode::kHexCompat;
+  // Shared by signature checks and Merkle builds of large blocks
+  auto crypto_pool = std::make_shared<WorkerPool>(cfg.getCryptoThreads());
+  auto mempool = std::make_shared<MempoolManager>("../mempool.dat",
+                                                  mempool_opts, crypto_pool);
+  mempool->Start();
 
-  // 2a) Reload existing audits and report
-  auto pending = mempool->LoadAll();
+  // 2a) Report recovered audits
+  auto pending = mempool->Snapshot();
   std::cout << "Recovered " << pending.size() 
           << " audits from mempool:\n";
   for (auto& a : pending) {
@@ -29,10 +54,6 @@ int main(int argc, char** argv) {
               << "\n";
   }
 
-  // Leader config & chain state
-  LeaderConfig cfg("../leader.json");
-  ChainManager chain("../chain.json");
-
   auto hb_table = std::make_shared<HeartbeatTable>(15);
 
   ElectionState election_state;    
@@ -43,12 +64,65 @@ int main(int argc, char** argv) {
     addr = argv[1];
   }
 
-  // Services
-  FileAuditServiceImpl  file_svc(peers,   mempool);
-  BlockChainServiceImpl block_svc(mempool, chain, hb_table, election_state, addr);
+  // Signature verification shared by the services and block sync; caches
+  // parsed keys and audits already verified, and checks whole blocks on
+  // the crypto pool
+  auto verifier    = std::make_shared<SignatureVerifier>(cfg.getPubkeyCacheSize());
+  auto audit_cache = std::make_shared<VerifiedAuditCache>(
+    verifier, cfg.getVerifiedAuditCacheSize(), crypto_pool);
+
+  // Inclusion proofs for committed audits, indexed from the block sidecars
+  auto proofs = std::make_shared<AuditProofStore>("../blocks",
+                                                  mempool_opts.merkle_mode);
+  proofs->Load(chain.getLastID());
+
+  // One keepalive-tuned channel per peer, shared by every subsystem that
+  // talks to peers, along with each peer's RTT and up/down state
+  PeerOptions peer_opts;
+  peer_opts.keepalive_time =
+    std::chrono::milliseconds(cfg.getPeerKeepaliveMs());
+  peer_opts.keepalive_timeout =
+    std::chrono::milliseconds(cfg.getPeerKeepaliveTimeoutMs());
+  peer_opts.max_message_bytes   = cfg.getPeerMaxMessageBytes();
+  peer_opts.down_after_failures = cfg.getPeerDownAfterFailures();
+  auto peer_registry = std::make_shared<PeerRegistry>(peers, peer_opts);
+
+  // Background gossip of admitted audits, batched per peer
+  GossipOptions gossip_opts;
+  gossip_opts.queue_limit = cfg.getGossipQueueLimit();
+  gossip_opts.fanout      = cfg.getGossipFanout();
+  gossip_opts.max_batch   = cfg.getGossipBatchMax();
+  gossip_opts.rpc_timeout = std::chrono::milliseconds(cfg.getGossipTimeoutMs());
+  gossip_opts.max_backoff =
+    std::chrono::milliseconds(cfg.getGossipMaxBackoffMs());
+  auto gossip = std::make_shared<GossipDispatcher>(peer_registry,
+                                                   gossip_opts);
+  gossip->start();
+
+  // Handler executors: heartbeats, elections and consensus never queue
+  // behind client and gossip traffic
+  auto control_exec = std::make_shared<RpcExecutor>(
+    "control", cfg.getRpcControlThreads(), cfg.getRpcControlQueueLimit());
+  auto data_exec = std::make_shared<RpcExecutor>(
+    "data", cfg.getRpcDataThreads(), cfg.getRpcDataQueueLimit());
+  control_exec->start();
+  data_exec->start();
+
+  // Services, served through the callback API
+  FileAuditServiceImpl  file_impl(mempool, audit_cache, gossip);
+  BlockChainServiceImpl block_impl(mempool, chain, hb_table, election_state,
+                                   addr, audit_cache, proofs, gossip);
+  FileAuditCallbackService  file_svc(file_impl, data_exec);
+  BlockChainCallbackService block_svc(block_impl, control_exec, data_exec);
 
   grpc::ServerBuilder builder;
   builder.AddListeningPort(addr, grpc::InsecureServerCredentials());
+  peer_registry->ConfigureServer(builder);
+  if (cfg.getRpcStreamThreads() > 0) {
+    grpc::ResourceQuota quota("node_server");
+    quota.SetMaxThreads(static_cast<int>(cfg.getRpcStreamThreads()));
+    builder.SetResourceQuota(quota);
+  }
   builder.RegisterService(&file_svc);
   builder.RegisterService(&block_svc);
 
@@ -59,26 +133,56 @@ int main(int argc, char** argv) {
   BlockScheduler scheduler(
     mempool,
     chain,
-    file_svc.getGossipStubs(),
+    peer_registry,
     cfg,
-    [&]{ return election_state.getLeader() == addr; }
+    [&]{ return election_state.getLeader() == addr; },
+    proofs
   );
   scheduler.start();
 
   HeartbeatManager hb_mgr(
-    peers, addr, election_state, mempool, chain, hb_table
+    peer_registry, addr, election_state, mempool, chain, hb_table, audit_cache,
+    proofs
   );
   hb_mgr.start();
 
   ElectionManager election_mgr(
-    peers, addr, hb_table, election_state, mempool, chain
+    peer_registry, addr, hb_table, election_state, mempool, chain
   );
   election_mgr.start();
 
+  // Anti-entropy: repair mempool gaps that gossip missed
+  ReconcileOptions reconcile_opts;
+  reconcile_opts.interval =
+    std::chrono::milliseconds(cfg.getAntiEntropyIntervalMs());
+  MempoolReconciler reconciler(peer_registry, mempool, audit_cache, proofs,
+                               reconcile_opts);
+  if (cfg.getAntiEntropyIntervalMs() > 0) reconciler.start();
+
+  // Periodic counters: peer health, gossip queues, caches, RPC queues
+  StatsSources stats_sources;
+  stats_sources.mempool     = mempool;
+  stats_sources.peers       = peer_registry;
+  stats_sources.gossip      = gossip;
+  stats_sources.verifier    = verifier;
+  stats_sources.audit_cache = audit_cache;
+  stats_sources.control     = control_exec;
+  stats_sources.data        = data_exec;
+  stats_sources.reconciler  = &reconciler;
+  StatsReporter stats(stats_sources,
+                      std::chrono::milliseconds(cfg.getStatsIntervalMs()));
+  stats.start();
+
   server->Wait();
+  stats.stop();
   scheduler.stop();
   hb_mgr.stop();
   election_mgr.stop();
+  reconciler.stop();
+  control_exec->stop();
+  data_exec->stop();
+  gossip->stop();
+  mempool->Stop();
 
   return 0;
 }
@@ -1,43 +1,141 @@
 #include "mempool_manager.h"
+#include "canonical_audit.h"
+#include "crc32c.h"
+#include "parallel_merkle.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <sstream>
-#include <unordered_set>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
 
 using google::protobuf::util::MessageToJsonString;
 using google::protobuf::util::JsonStringToMessage;
 
-// Constructor: just capture the path
-MempoolManager::MempoolManager(std::string path)
-    : path_(std::move(path)) {}
+// JSON segments: tombstone lines are "-" followed by a JSON FileAudit
+// carrying only req_id.
+static constexpr char kTombstoneMark = '-';
 
-// Append one audit as JSON line
-void MempoolManager::Append(const common::FileAudit& audit) {
-  std::lock_guard<std::mutex> lk(mu_);
-  std::ofstream out(path_, std::ios::app);
-  if (!out) {
-    std::cerr << "[MempoolManager] failed to open " << path_ << "\n";
-    return;
+// Binary segments start with this magic, followed by records of
+// [u32 len][u32 crc32c][u8 kind][payload]; len and crc cover kind+payload.
+static constexpr char     kBinaryMagic[8] = {'A','V','M','P','L','O','G','1'};
+static constexpr char     kKindAdd        = 'A';
+static constexpr char     kKindTombstone  = 'T';
+static constexpr size_t   kRecordHeader   = 8;
+static constexpr uint32_t kMaxRecordBytes = 64u << 20;
+
+// Tombstone target for an add that was still queued when it was removed
+static constexpr uint64_t kUnresolvedSegment = UINT64_MAX;
+
+// Cut alignment applies to prefixes at least this long
+static constexpr size_t kMinAlignedPrefix = 16;
+
+// Leaves BlockMerkleRoot() hashes on the pool, and per task
+static constexpr size_t kParallelHashMin = 256;
+static constexpr size_t kHashGrain       = 64;
+
+// Committed req_ids remembered so Append refuses to re-admit them
+static constexpr size_t kRemovedMemory = 65536;
+
+static bool ReadFile(const std::string& path, std::string* out) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  out->assign(std::istreambuf_iterator<char>(in), {});
+  return true;
+}
+
+static bool IsBinaryLog(const std::string& data) {
+  return data.size() >= sizeof(kBinaryMagic) &&
+         data.compare(0, sizeof(kBinaryMagic),
+                      kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+}
+
+static bool HasBinaryHeader(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  char head[sizeof(kBinaryMagic)];
+  return in.read(head, sizeof(head)) &&
+         std::equal(head, head + sizeof(head), kBinaryMagic);
+}
+
+static void PutU32(uint32_t v, std::string* out) {
+  for (int i = 0; i < 4; ++i) out->push_back(static_cast<char>(v >> (8 * i)));
+}
+
+static uint32_t GetU32(const char* p) {
+  uint32_t v = 0;
+  for (int i = 3; i >= 0; --i)
+    v = (v << 8) | static_cast<unsigned char>(p[i]);
+  return v;
+}
+
+static void EncodeBinaryRecord(char kind, const std::string& payload,
+                               std::string* out) {
+  std::string body;
+  body.reserve(payload.size() + 1);
+  body.push_back(kind);
+  body.append(payload);
+  PutU32(static_cast<uint32_t>(body.size()), out);
+  PutU32(Crc32c(body.data(), body.size()), out);
+  out->append(body);
+}
+
+/// Invoke fn(kind, payload, payload_len) for each intact record and return
+/// the offset just past the last one; anything beyond is a torn tail.
+template <typename Fn>
+static size_t ParseBinaryRecords(const std::string& data, Fn&& fn) {
+  size_t off = sizeof(kBinaryMagic);
+  while (data.size() - off >= kRecordHeader) {
+    uint32_t len = GetU32(data.data() + off);
+    uint32_t crc = GetU32(data.data() + off + 4);
+    if (len == 0 || len > kMaxRecordBytes ||
+        len > data.size() - off - kRecordHeader) break;
+    const char* body = data.data() + off + kRecordHeader;
+    if (Crc32c(body, len) != crc) break;
+    fn(body[0], body + 1, static_cast<size_t>(len - 1));
+    off += kRecordHeader + len;
   }
+  return off;
+}
+
+static bool EncodeJsonAdd(const common::FileAudit& audit, std::string* out) {
   std::string json;
   auto status = MessageToJsonString(audit, &json);
   if (!status.ok()) {
     std::cerr << "[MempoolManager] JSON serialization failed: "
               << status.ToString() << "\n";
-    return;
+    return false;
   }
-  out << json << "\n";
+  out->append(json);
+  out->push_back('\n');
+  return true;
 }
 
-// Load all audits by parsing JSON lines
-std::vector<common::FileAudit> MempoolManager::LoadAll() const {
-  std::lock_guard<std::mutex> lk(mu_);
-  std::vector<common::FileAudit> all;
-  std::ifstream in(path_);
-  if (!in) return all;
+static void EncodeJsonTombstone(const std::string& req_id, std::string* out) {
+  common::FileAudit t;
+  t.set_req_id(req_id);
+  std::string json;
+  MessageToJsonString(t, &json);
+  out->push_back(kTombstoneMark);
+  out->append(json);
+  out->push_back('\n');
+}
+
+/// Invoke fn(tombstone, audit) for each parseable JSON line.
+template <typename Fn>
+static void ParseJsonLines(const std::string& data, Fn&& fn) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    size_t eol = data.find('\n', pos);
+    if (eol == std::string::npos) eol = data.size();
+    std::string line = data.substr(pos, eol - pos);
+    pos = eol + 1;
 
-  std::string line;
-  while (std::getline(in, line)) {
     // trim whitespace
     auto first = line.find_first_not_of(" \t\r\n");
     if (first == std::string::npos) {
@@ -46,52 +144,860 @@ std::vector<common::FileAudit> MempoolManager::LoadAll() const {
     }
 
     common::FileAudit a;
-    auto status = JsonStringToMessage(line, &a);
+    bool tombstone = line[first] == kTombstoneMark;
+    auto status = JsonStringToMessage(
+      tombstone ? line.substr(first + 1) : line, &a);
     if (!status.ok()) {
       std::cerr << "[MempoolManager] JSON parse error: "
                 << status.ToString() << "\n";
       continue;
     }
-    all.push_back(std::move(a));
+    fn(tombstone, std::move(a));
   }
-  return all;
 }
 
+// Every field that goes into a block, including the signature
+static bool SameAudit(const common::FileAudit& a, const common::FileAudit& b) {
+  return a.req_id()                 == b.req_id() &&
+         a.timestamp()              == b.timestamp() &&
+         a.access_type()            == b.access_type() &&
+         a.file_info().file_id()    == b.file_info().file_id() &&
+         a.file_info().file_name()  == b.file_info().file_name() &&
+         a.user_info().user_id()    == b.user_info().user_id() &&
+         a.user_info().user_name()  == b.user_info().user_name() &&
+         a.signature()              == b.signature() &&
+         a.public_key()             == b.public_key() &&
+         a.envelope_root()          == b.envelope_root() &&
+         a.envelope_index()         == b.envelope_index() &&
+         std::equal(a.envelope_path().begin(), a.envelope_path().end(),
+                    b.envelope_path().begin(), b.envelope_path().end());
+}
 
-// Remove a batch of req_ids by rewriting the file
-void MempoolManager::RemoveBatch(const std::vector<std::string>& ids) {
+bool MempoolManager::ConvertJsonToBinary(const std::string& src,
+                                         const std::string& dst) {
+  std::string data;
+  if (!ReadFile(src, &data)) return false;
+
+  std::string out(kBinaryMagic, sizeof(kBinaryMagic));
+  ParseJsonLines(data, [&](bool tombstone, common::FileAudit a) {
+    if (tombstone) {
+      EncodeBinaryRecord(kKindTombstone, a.req_id(), &out);
+    } else {
+      EncodeBinaryRecord(kKindAdd, a.SerializeAsString(), &out);
+    }
+  });
+
+  std::ofstream f(dst, std::ios::trunc | std::ios::binary);
+  if (!f) return false;
+  f << out;
+  return static_cast<bool>(f);
+}
+
+bool MempoolManager::encodeAdd(const common::FileAudit& audit,
+                               std::string* out) const {
+  if (opts_.format == MempoolFormat::kBinary) {
+    std::string payload;
+    if (!audit.SerializeToString(&payload)) return false;
+    EncodeBinaryRecord(kKindAdd, payload, out);
+    return true;
+  }
+  return EncodeJsonAdd(audit, out);
+}
+
+void MempoolManager::encodeTombstone(const std::string& req_id,
+                                     std::string* out) const {
+  if (opts_.format == MempoolFormat::kBinary) {
+    EncodeBinaryRecord(kKindTombstone, req_id, out);
+  } else {
+    EncodeJsonTombstone(req_id, out);
+  }
+}
+
+// Constructor: capture the path, replay the recovery log once and launch
+// the log writer
+MempoolManager::MempoolManager(std::string path, MempoolOptions opts,
+                               std::shared_ptr<WorkerPool> pool)
+    : path_(std::move(path))
+    , opts_(opts)
+    , pool_(std::move(pool))
+    , acc_(opts.merkle_mode) {
+  replay();
+  thr_ = std::thread(&MempoolManager::loop, this);
+}
+
+MempoolManager::~MempoolManager() {
+  Stop();
+}
+
+void MempoolManager::Start() {
   std::lock_guard<std::mutex> lk(mu_);
-  std::unordered_set<std::string> to_remove(ids.begin(), ids.end());
+  background_compaction_ = true;
+  writer_cv_.notify_one();
+}
 
-  // Read everything
-  std::vector<common::FileAudit> keep;
+void MempoolManager::Stop() {
   {
-    std::ifstream in(path_);
-    std::string line;
-    while (std::getline(in, line)) {
-      common::FileAudit a;
-      auto st = JsonStringToMessage(line, &a);
-      if (!st.ok()) continue;
-      if (!to_remove.count(a.req_id())) {
-        keep.push_back(std::move(a));
+    std::lock_guard<std::mutex> lk(mu_);
+    stopping_ = true;
+  }
+  writer_cv_.notify_one();
+  if (thr_.joinable()) thr_.join();
+}
+
+std::string MempoolManager::segmentFile(uint64_t seg_id) const {
+  if (seg_id == 0) return path_;   // legacy single-file log
+  char suffix[32];
+  std::snprintf(suffix, sizeof(suffix), ".%06llu",
+                static_cast<unsigned long long>(seg_id));
+  return path_ + suffix;
+}
+
+// Discover segment files and rebuild the in-memory index from them
+void MempoolManager::replay() {
+  std::lock_guard<std::mutex> lk(mu_);
+
+  std::error_code ec;
+  if (fs::is_regular_file(path_, ec)) {
+    segments_[0].file = path_;
+  }
+
+  fs::path base(path_);
+  fs::path dir = base.parent_path().empty() ? fs::path(".")
+                                            : base.parent_path();
+  std::string prefix = base.filename().string() + ".";
+  for (auto& ent : fs::directory_iterator(dir, ec)) {
+    std::string name = ent.path().filename().string();
+    if (name.size() <= prefix.size() ||
+        name.compare(0, prefix.size(), prefix) != 0) continue;
+    std::string digits = name.substr(prefix.size());
+    if (digits.find_first_not_of("0123456789") != std::string::npos)
+      continue;
+    uint64_t id = std::stoull(digits);
+    segments_[id].file = segmentFile(id);
+  }
+
+  for (auto& kv : segments_) {
+    // One-time conversion of JSON segments when running in binary mode
+    if (opts_.format == MempoolFormat::kBinary &&
+        !HasBinaryHeader(kv.second.file)) {
+      std::string tmp = kv.second.file + ".tmp";
+      if (ConvertJsonToBinary(kv.second.file, tmp) &&
+          std::rename(tmp.c_str(), kv.second.file.c_str()) == 0) {
+        std::cout << "[MempoolManager] converted " << kv.second.file
+                  << " to binary\n";
+      } else {
+        std::cerr << "[MempoolManager] failed to convert "
+                  << kv.second.file << "\n";
       }
     }
+    replaySegment(kv.first);
   }
 
-  // Rewrite
-  std::ofstream out(path_, std::ios::trunc);
-  if (!out) {
-    std::cerr << "[MempoolManager] failed to reopen " << path_ << "\n";
+  active_ = segments_.empty() ? 1 : segments_.rbegin()->first + 1;
+  segments_[active_].file = segmentFile(active_);
+
+  // Build the accumulator once over the survivors
+  std::vector<Digest> leaves;
+  leaves.reserve(pending_.size());
+  for (auto const& kv : pending_) leaves.push_back(kv.second.leaf);
+  acc_.Reset(std::move(leaves));
+  acc_live_ = true;
+}
+
+void MempoolManager::replaySegment(uint64_t seg_id) {
+  Segment& seg = segments_[seg_id];
+  std::string data;
+  if (!ReadFile(seg.file, &data)) return;
+
+  if (!IsBinaryLog(data)) {
+    seg.bytes = data.size();
+    ParseJsonLines(data, [&](bool tombstone, common::FileAudit a) {
+      ++seg.records;
+      applyRecordLocked(seg_id, tombstone, std::move(a));
+    });
     return;
   }
-  for (auto& a : keep) {
-    std::string json;
-    auto status = MessageToJsonString(a, &json);
-    if (!status.ok()) {
-      std::cerr << "[MempoolManager] JSON serialization failed: "
-                << status.ToString() << "\n";
+
+  size_t good = ParseBinaryRecords(data,
+    [&](char kind, const char* payload, size_t len) {
+      ++seg.records;
+      common::FileAudit a;
+      if (kind == kKindTombstone) {
+        a.set_req_id(std::string(payload, len));
+      } else if (kind != kKindAdd || !a.ParseFromArray(payload, (int)len)) {
+        std::cerr << "[MempoolManager] bad record in " << seg.file << "\n";
+        return;
+      }
+      applyRecordLocked(seg_id, kind == kKindTombstone, std::move(a));
+    });
+  seg.bytes = good;
+  if (good < data.size()) {
+    // Torn tail from a crash mid-write: drop it so the file stays parseable
+    std::cerr << "[MempoolManager] dropping " << (data.size() - good)
+              << " torn bytes at end of " << seg.file << "\n";
+    std::error_code ec;
+    fs::resize_file(seg.file, good, ec);
+  }
+}
+
+void MempoolManager::applyRecordLocked(uint64_t seg_id, bool tombstone,
+                                       common::FileAudit a) {
+  if (tombstone) {
+    uint64_t target = 0;
+    if (eraseLocked(a.req_id(), &target) && target != seg_id) {
+      segments_[seg_id].tombstones.emplace_back(a.req_id(), target);
+    }
+  } else if (!index_.count(a.req_id())) {
+    Entry e;
+    if (AppendCanonicalAudit(a, &e.encoded)) {
+      e.leaf = SHA256Digest(e.encoded.data(), e.encoded.size());
+    } else {
+      e.encoded.clear();
+      e.leaf = SHA256Digest("", 0);
+    }
+    e.audit = std::move(a);
+    insertLocked(std::move(e), seg_id);
+  }
+}
+
+bool MempoolManager::insertLocked(Entry entry, uint64_t seg_id) {
+  const common::FileAudit& audit = entry.audit;
+  if (index_.count(audit.req_id())) return false;
+  index_.emplace(audit.req_id(), Location{audit.timestamp(), seg_id});
+  uint64_t h = IdHash(audit.req_id());
+  auto& bucket = id_digest_[h % kIdBuckets];
+  bucket.x ^= h;
+  ++bucket.count;
+  segments_[seg_id].live.insert(audit.req_id());
+  placeLocked(std::move(entry));
+  return true;
+}
+
+// Add an indexed entry to pending_ (and the accumulator) in block order
+void MempoolManager::placeLocked(Entry entry) {
+  OrderKey key{entry.audit.timestamp(), entry.audit.req_id()};
+  auto it = pending_.emplace(std::move(key), std::move(entry)).first;
+  if (acc_live_) {
+    // Audits mostly arrive in timestamp order, so count from the back
+    size_t rank = pending_.size() - std::distance(it, pending_.end());
+    acc_.Insert(acc_front_drop_ + rank, it->second.leaf);
+  }
+}
+
+bool MempoolManager::eraseLocked(const std::string& req_id,
+                                 uint64_t* seg_id) {
+  auto it = index_.find(req_id);
+  if (it == index_.end()) return false;
+  *seg_id = it->second.segment;
+  auto seg = segments_.find(*seg_id);
+  if (seg != segments_.end()) seg->second.live.erase(req_id);
+  auto p = pending_.find(OrderKey{it->second.timestamp, req_id});
+  if (p == pending_.end()) reserved_.erase(req_id);
+  if (acc_live_ && p != pending_.end()) {
+    if (p == pending_.begin()) {
+      ++acc_front_drop_;
+    } else {
+      acc_.Erase(acc_front_drop_ + std::distance(pending_.begin(), p));
+    }
+  }
+  if (p != pending_.end()) pending_.erase(p);
+  index_.erase(it);
+  uint64_t h = IdHash(req_id);
+  auto& bucket = id_digest_[h % kIdBuckets];
+  bucket.x ^= h;
+  --bucket.count;
+  return true;
+}
+
+uint64_t MempoolManager::enqueueLocked(QueuedWrite w,
+                                       const std::string& bytes) {
+  queue_.push_back(std::move(w));
+  queue_bytes_.append(bytes);
+  writer_cv_.notify_one();
+  return ++enqueued_seq_;
+}
+
+void MempoolManager::waitDurable(std::unique_lock<std::mutex>& lk,
+                                 uint64_t seq) {
+  durable_cv_.wait(lk, [&]{ return durable_seq_ >= seq || exited_; });
+}
+
+// Enqueue the audit for the next group commit and wait until it's durable
+bool MempoolManager::Append(const common::FileAudit& audit, bool* failed) {
+  return AppendBatch({&audit}, nullptr, failed) == 1;
+}
+
+size_t MempoolManager::AppendBatch(
+    const std::vector<const common::FileAudit*>& audits,
+    std::vector<const common::FileAudit*>* admitted,
+    bool* failed) {
+  if (failed) *failed = false;
+  struct Ready {
+    const common::FileAudit* audit;
+    std::string              bytes;
+    QueuedWrite              write;
+  };
+  // Encode and hash the Merkle leaves here, off the block path
+  std::vector<Ready> ready;
+  ready.reserve(audits.size());
+  for (const auto* audit : audits) {
+    std::string bytes;
+    if (!encodeAdd(*audit, &bytes)) continue;
+    QueuedWrite w;
+    w.req_id = audit->req_id();
+    if (!AppendCanonicalAudit(*audit, &w.entry.encoded)) {
+      std::cerr << "[MempoolManager] audit is not valid UTF-8: "
+                << audit->req_id() << "\n";
       continue;
     }
-    out << json << "\n";
+    w.entry.leaf  = SHA256Digest(w.entry.encoded.data(),
+                                 w.entry.encoded.size());
+    w.entry.audit = *audit;
+    ready.push_back(Ready{audit, std::move(bytes), std::move(w)});
+  }
+
+  std::unique_lock<std::mutex> lk(mu_);
+  if (stopping_) {
+    std::cerr << "[MempoolManager] Append after Stop: "
+              << audits.size() << " audit(s)\n";
+    if (failed) *failed = true;
+    return 0;
+  }
+  std::vector<const common::FileAudit*> added;
+  uint64_t seq = 0;
+  for (auto& r : ready) {
+    const std::string& id = r.audit->req_id();
+    if (index_.count(id) || staged_.count(id) || removed_.count(id)) continue;
+    staged_.insert(id);
+    seq = enqueueLocked(std::move(r.write), r.bytes);
+    added.push_back(r.audit);
   }
+  if (added.empty()) return 0;
+  // Every record queued so far goes out in the same group commit
+  auto outcome = queue_outcome_;
+  waitDurable(lk, seq);
+  if (durable_seq_ < seq || outcome->failed) {
+    if (failed) *failed = true;
+    return 0;
+  }
+  if (admitted) *admitted = added;
+  return added.size();
+}
+
+size_t MempoolManager::Size() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return pending_.size();
+}
+
+uint64_t MempoolManager::AdmittedCount() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return admitted_;
+}
+
+bool MempoolManager::WaitForSize(
+    size_t n, std::chrono::steady_clock::time_point deadline) {
+  std::unique_lock<std::mutex> lk(mu_);
+  ++size_waiters_;
+  size_watermark_ = std::min(size_watermark_, n);
+  size_cv_.wait_until(lk, deadline, [&]{
+    return pending_.size() >= n || wake_pending_;
+  });
+  wake_pending_ = false;
+  if (--size_waiters_ == 0) size_watermark_ = SIZE_MAX;
+  return pending_.size() >= n;
+}
+
+void MempoolManager::Wake() {
+  std::lock_guard<std::mutex> lk(mu_);
+  wake_pending_ = true;
+  size_cv_.notify_all();
+}
+
+bool MempoolManager::Contains(const std::string& req_id) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return index_.count(req_id) != 0;
+}
+
+std::vector<common::FileAudit> MempoolManager::Snapshot() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  std::vector<common::FileAudit> all;
+  all.reserve(pending_.size());
+  for (auto const& kv : pending_) all.push_back(kv.second.audit);
+  return all;
+}
+
+void MempoolManager::CopyAudits(
+    const google::protobuf::RepeatedPtrField<std::string>& ids,
+    google::protobuf::RepeatedPtrField<common::FileAudit>* out,
+    std::vector<int>* missing) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  out->Reserve(out->size() + ids.size());
+  for (int i = 0; i < ids.size(); ++i) {
+    const common::FileAudit* found = nullptr;
+    auto loc = index_.find(ids[i]);
+    if (loc != index_.end()) {
+      auto p = pending_.find(OrderKey{loc->second.timestamp, ids[i]});
+      if (p != pending_.end()) {
+        found = &p->second.audit;
+      } else {
+        auto r = reserved_.find(ids[i]);
+        if (r != reserved_.end()) found = &r->second.audit;
+      }
+    }
+    auto* a = out->Add();
+    if (found) {
+      *a = *found;
+    } else {
+      missing->push_back(out->size() - 1);
+    }
+  }
+}
+
+size_t MempoolManager::prefixLengthLocked(
+    const std::function<bool(const common::FileAudit&)>& take) const {
+  size_t n = 0;
+  for (auto it = pending_.begin();
+       it != pending_.end() && take(it->second.audit); ++it) {
+    ++n;
+  }
+  if (n < pending_.size() && n >= kMinAlignedPrefix) {
+    size_t align = 1;
+    while (align * 2 <= n / 8) align *= 2;
+    n -= n % align;
+  }
+  return n;
+}
+
+MempoolManager::Prefix MempoolManager::copyPrefixLocked(size_t n) {
+  Prefix out;
+  out.audits.reserve(n);
+  out.leaves.reserve(n);
+  auto it = pending_.begin();
+  for (size_t i = 0; i < n; ++i, ++it) {
+    out.audits.push_back(it->second.audit);
+    out.encoded.append(it->second.encoded);
+    out.leaves.push_back(it->second.leaf);
+  }
+  out.merkle_root = acc_.Root(n);
+  return out;
+}
+
+MempoolManager::Prefix MempoolManager::CutPrefix(
+    const std::function<bool(const common::FileAudit&)>& take) {
+  std::lock_guard<std::mutex> lk(mu_);
+  return copyPrefixLocked(prefixLengthLocked(take));
+}
+
+MempoolManager::Prefix MempoolManager::ReservePrefix(
+    const std::function<bool(const common::FileAudit&)>& take) {
+  std::lock_guard<std::mutex> lk(mu_);
+  size_t n = prefixLengthLocked(take);
+  Prefix out = copyPrefixLocked(n);
+  for (size_t i = 0; i < n; ++i) {
+    auto node = pending_.extract(pending_.begin());
+    reserved_.emplace(node.key().second, std::move(node.mapped()));
+  }
+  // The prefix is aligned, so the cached subtrees behind it survive
+  acc_.EraseFront(n);
+  return out;
+}
+
+void MempoolManager::Release(const std::vector<std::string>& ids) {
+  std::lock_guard<std::mutex> lk(mu_);
+  for (auto const& id : ids) {
+    auto it = reserved_.find(id);
+    if (it == reserved_.end()) continue;
+    Entry e = std::move(it->second);
+    reserved_.erase(it);
+    placeLocked(std::move(e));
+  }
+  if (size_waiters_ > 0 && pending_.size() >= size_watermark_) {
+    size_cv_.notify_all();
+  }
+}
+
+size_t MempoolManager::ReservedCount() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return reserved_.size();
+}
+
+// FNV-1a, then a splitmix64 finalizer so nearby req_ids spread over the
+// buckets
+uint64_t MempoolManager::IdHash(const std::string& req_id) {
+  uint64_t h = 14695981039346656037ull;
+  for (unsigned char c : req_id) {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+std::vector<MempoolManager::IdBucket> MempoolManager::IdDigest() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return id_digest_;
+}
+
+std::vector<std::string> MempoolManager::IdsInBuckets(
+    const std::vector<uint32_t>& buckets) const {
+  std::vector<bool> want(kIdBuckets, false);
+  for (uint32_t b : buckets) {
+    if (b < kIdBuckets) want[b] = true;
+  }
+  std::vector<std::string> ids;
+  std::lock_guard<std::mutex> lk(mu_);
+  for (auto& kv : index_) {
+    if (want[IdHash(kv.first) % kIdBuckets]) ids.push_back(kv.first);
+  }
+  return ids;
+}
+
+std::string MempoolManager::BlockMerkleRoot(
+    const google::protobuf::RepeatedPtrField<common::FileAudit>& audits,
+    std::vector<std::string>* payloads) {
+  size_t n = static_cast<size_t>(audits.size());
+  payloads->assign(n, std::string());
+  std::vector<Digest> leaves(n);
+  std::vector<size_t> misses;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    bool is_prefix = n <= pending_.size();
+    auto next = pending_.begin();
+    for (size_t i = 0; i < n; ++i) {
+      const auto& a = audits[static_cast<int>(i)];
+      auto loc = index_.find(a.req_id());
+      auto p = loc == index_.end()
+             ? pending_.end()
+             : pending_.find(OrderKey{loc->second.timestamp, a.req_id()});
+      if (p == pending_.end() || !SameAudit(p->second.audit, a)) {
+        is_prefix = false;
+        misses.push_back(i);
+        continue;
+      }
+      (*payloads)[i] = p->second.encoded;
+      leaves[i]      = p->second.leaf;
+      if (is_prefix) is_prefix = p == next++;
+    }
+    if (is_prefix) return acc_.Root(n);
+  }
+
+  auto hashMiss = [&](size_t k) {
+    size_t i = misses[k];
+    auto& payload = (*payloads)[i];
+    payload = CanonicalAudit(audits[static_cast<int>(i)]);
+    leaves[i] = SHA256Digest(payload.data(), payload.size());
+  };
+  if (pool_ && misses.size() >= kParallelHashMin) {
+    pool_->ParallelFor(misses.size(), hashMiss, kHashGrain);
+  } else {
+    for (size_t k = 0; k < misses.size(); ++k) hashMiss(k);
+  }
+  return ParallelMerkleRoot(std::move(leaves), opts_.merkle_mode, pool_.get());
+}
+
+size_t MempoolManager::SegmentCount() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  size_t n = 0;
+  for (auto const& kv : segments_) {
+    if (kv.second.records > 0) ++n;
+  }
+  return n;
+}
+
+// Drop a batch of req_ids from memory and log one tombstone per removal
+void MempoolManager::RemoveBatch(const std::vector<std::string>& ids) {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (stopping_) return;
+  uint64_t seq = 0;
+  for (auto const& id : ids) {
+    if (removed_.insert(id).second) {
+      removed_order_.push_back(id);
+      if (removed_order_.size() > kRemovedMemory) {
+        removed_.erase(removed_order_.front());
+        removed_order_.pop_front();
+      }
+    }
+    QueuedWrite w;
+    w.tombstone = true;
+    w.req_id    = id;
+    if (staged_.count(id)) {
+      // Add still queued: drop it from memory once written, and resolve
+      // the tombstone target after the add lands in a segment
+      if (!cancelled_.insert(id).second) continue;
+      w.target = kUnresolvedSegment;
+    } else if (!eraseLocked(id, &w.target)) {
+      continue;
+    }
+    std::string bytes;
+    encodeTombstone(id, &bytes);
+    seq = enqueueLocked(std::move(w), bytes);
+  }
+  acc_.EraseFront(acc_front_drop_);
+  acc_front_drop_ = 0;
+  if (seq) waitDurable(lk, seq);
+}
+
+bool MempoolManager::needsCompactionLocked(uint64_t seg_id) const {
+  if (seg_id == active_) return false;
+  auto it = segments_.find(seg_id);
+  if (it == segments_.end()) return false;
+  const Segment& seg = it->second;
+  if (seg.records == 0) return true;
+  return static_cast<double>(seg.live.size()) / seg.records
+         < opts_.compact_live_ratio;
+}
+
+// Writer thread: append bytes to a segment file and make them durable
+bool MempoolManager::writeDurable(uint64_t seg_id, const std::string& bytes) {
+  if (fd_ < 0 || fd_seg_ != seg_id) {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = ::open(segmentFile(seg_id).c_str(),
+                 O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    fd_seg_ = seg_id;
+    if (fd_ < 0) {
+      std::cerr << "[MempoolManager] failed to open "
+                << segmentFile(seg_id) << ": " << std::strerror(errno)
+                << "\n";
+      return false;
+    }
+  }
+
+  // On failure cut the file back, so a torn or unacknowledged group
+  // commit doesn't come back on replay
+  off_t start = ::lseek(fd_, 0, SEEK_END);
+  auto fail = [&](const char* what) {
+    std::cerr << "[MempoolManager] " << what << " failed: "
+              << std::strerror(errno) << "\n";
+    if (start >= 0 && ::ftruncate(fd_, start) != 0) {
+      std::cerr << "[MempoolManager] could not truncate "
+                << segmentFile(seg_id) << ": " << std::strerror(errno)
+                << "\n";
+    }
+    return false;
+  };
+
+  const char* p   = bytes.data();
+  size_t      len = bytes.size();
+  while (len > 0) {
+    ssize_t n = ::write(fd_, p, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return fail("write");
+    }
+    p   += n;
+    len -= static_cast<size_t>(n);
+  }
+  if (opts_.fsync && ::fdatasync(fd_) != 0) return fail("fdatasync");
+  return true;
+}
+
+// Writer thread: write `count` encoded records to a segment with mu_
+// released during I/O, then account for them and roll the active segment
+// when it's full.
+bool MempoolManager::writeSegmentLocked(std::unique_lock<std::mutex>& lk,
+                                        uint64_t seg_id, std::string bytes,
+                                        size_t count) {
+  if (segments_[seg_id].bytes == 0 &&
+      opts_.format == MempoolFormat::kBinary) {
+    bytes.insert(0, kBinaryMagic, sizeof(kBinaryMagic));
+  }
+
+  lk.unlock();
+  bool ok = writeDurable(seg_id, bytes);
+  lk.lock();
+  if (!ok) return false;
+
+  Segment& seg = segments_[seg_id];
+  seg.records += count;
+  seg.bytes   += bytes.size();
+  if (seg_id == active_ && seg.bytes >= opts_.segment_bytes) {
+    ++active_;
+    segments_[active_].file = segmentFile(active_);
+  }
+  return ok;
+}
+
+// Writer thread: one group commit of everything queued so far
+void MempoolManager::flushLocked(std::unique_lock<std::mutex>& lk) {
+  std::vector<QueuedWrite> batch;
+  std::string bytes;
+  batch.swap(queue_);
+  bytes.swap(queue_bytes_);
+  auto outcome = std::move(queue_outcome_);
+  queue_outcome_ = std::make_shared<CommitOutcome>();
+  uint64_t seq    = enqueued_seq_;
+  uint64_t seg_id = active_;
+
+  bool ok = writeSegmentLocked(lk, seg_id, std::move(bytes), batch.size());
+  if (!ok) {
+    // Its Append callers fail and the adds stay out of memory. Records
+    // that reached the file anyway may reappear on replay; a client's
+    // retry of the same req_id is then deduplicated
+    outcome->failed = true;
+    std::cerr << "[MempoolManager] group commit of " << batch.size()
+              << " records failed\n";
+  }
+
+  // Publish the batch to memory now that it's on disk
+  for (auto& w : batch) {
+    if (!w.tombstone) {
+      staged_.erase(w.req_id);
+      if (cancelled_.erase(w.req_id)) {
+        if (ok) cancelled_at_[w.req_id] = seg_id;
+        continue;
+      }
+      if (ok && insertLocked(std::move(w.entry), seg_id)) ++admitted_;
+      continue;
+    }
+    if (w.target == kUnresolvedSegment) {
+      auto it = cancelled_at_.find(w.req_id);
+      if (it == cancelled_at_.end()) continue;
+      w.target = it->second;
+      cancelled_at_.erase(it);
+    }
+    if (w.target != seg_id) {
+      segments_[seg_id].tombstones.emplace_back(w.req_id, w.target);
+      compact_hint_ = compact_hint_ || needsCompactionLocked(w.target);
+    }
+  }
+
+  durable_seq_ = seq;
+  durable_cv_.notify_all();
+  if (size_waiters_ > 0 && pending_.size() >= size_watermark_) {
+    size_cv_.notify_all();
+  }
+}
+
+// Writer thread: re-append a sealed segment's tombstones that still
+// shadow older segments, then its live records, to the active segment,
+// and delete its file.
+bool MempoolManager::compactSegmentLocked(std::unique_lock<std::mutex>& lk,
+                                          uint64_t seg_id) {
+  auto it = segments_.find(seg_id);
+  if (it == segments_.end() || seg_id == active_) return false;
+  Segment seg = std::move(it->second);
+  segments_.erase(it);
+
+  std::string buf;
+  size_t count = 0;
+  uint64_t dest = active_;
+  Segment& out = segments_[dest];
+  std::vector<std::string> copy(seg.live.begin(), seg.live.end());
+  for (auto& t : seg.tombstones) {
+    if (!segments_.count(t.second)) continue;
+    encodeTombstone(t.first, &buf);
+    ++count;
+    // A req_id that left removed_ may have been re-added since, after the
+    // tombstone: copy that add too so it still replays after it
+    auto loc = index_.find(t.first);
+    if (loc != index_.end() && loc->second.segment != seg_id) {
+      segments_[loc->second.segment].live.erase(t.first);
+      copy.push_back(t.first);
+    }
+    out.tombstones.push_back(std::move(t));
+  }
+
+  size_t moved = 0;
+  for (auto const& id : copy) {
+    auto loc = index_.find(id);
+    if (loc == index_.end()) continue;
+    auto p = pending_.find(OrderKey{loc->second.timestamp, id});
+    const Entry* e = p != pending_.end() ? &p->second : nullptr;
+    if (!e) {
+      auto r = reserved_.find(id);
+      if (r != reserved_.end()) e = &r->second;
+    }
+    if (!e || !encodeAdd(e->audit, &buf)) continue;
+    // Repoint before writing so concurrent removals target `dest`
+    loc->second.segment = dest;
+    out.live.insert(id);
+    ++moved;
+  }
+  count += moved;
+
+  if (count > 0 && !writeSegmentLocked(lk, dest, std::move(buf), count)) {
+    // Keep the old file: replay dedupes whatever did reach `dest`
+    std::cerr << "[MempoolManager] compaction of " << seg.file
+              << " not durable, keeping it\n";
+    return false;
+  }
+
+  if (std::remove(seg.file.c_str()) != 0) {
+    std::cerr << "[MempoolManager] failed to delete " << seg.file << "\n";
+  }
+  std::cout << "[MempoolManager] compacted " << seg.file
+            << " (moved " << moved << " live of "
+            << seg.records << " records)\n";
+  return true;
+}
+
+size_t MempoolManager::compactLocked(std::unique_lock<std::mutex>& lk) {
+  std::vector<uint64_t> candidates;
+  for (auto const& kv : segments_) {
+    if (needsCompactionLocked(kv.first)) candidates.push_back(kv.first);
+  }
+
+  size_t dropped = 0;
+  for (auto id : candidates) {
+    if (needsCompactionLocked(id) && compactSegmentLocked(lk, id)) ++dropped;
+    // Don't hold up group commits behind a long compaction pass
+    if (!queue_.empty()) flushLocked(lk);
+  }
+  return dropped;
+}
+
+size_t MempoolManager::Compact() {
+  std::unique_lock<std::mutex> lk(mu_);
+  if (exited_) return 0;
+  uint64_t ticket = ++compact_requested_;
+  writer_cv_.notify_one();
+  durable_cv_.wait(lk, [&]{ return compact_served_ >= ticket || exited_; });
+  return last_compacted_;
+}
+
+// Log writer: group-commits queued records and runs compaction
+void MempoolManager::loop() {
+  using clock = std::chrono::steady_clock;
+  const auto interval = std::chrono::milliseconds(opts_.compact_interval_ms);
+  auto next_compact = clock::now() + interval;
+
+  std::unique_lock<std::mutex> lk(mu_);
+  while (true) {
+    writer_cv_.wait_until(lk, next_compact, [&]{
+      return stopping_ || !queue_.empty() ||
+             compact_requested_ > compact_served_;
+    });
+
+    if (!queue_.empty()) {
+      if (opts_.group_commit_window_us > 0 && !stopping_) {
+        writer_cv_.wait_for(
+          lk, std::chrono::microseconds(opts_.group_commit_window_us),
+          [&]{ return stopping_; });
+      }
+      flushLocked(lk);
+    }
+
+    bool requested = compact_requested_ > compact_served_;
+    bool due = background_compaction_ &&
+               (compact_hint_ || clock::now() >= next_compact);
+    if (requested || due) {
+      uint64_t ticket = compact_requested_;
+      compact_hint_   = false;
+      last_compacted_ = compactLocked(lk);
+      compact_served_ = ticket;
+      durable_cv_.notify_all();
+    }
+    if (clock::now() >= next_compact) next_compact = clock::now() + interval;
+
+    if (stopping_ && queue_.empty()) break;
+  }
+
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+  exited_ = true;
+  durable_cv_.notify_all();
 }
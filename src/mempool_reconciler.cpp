@@ -0,0 +1,186 @@
+// src/mempool_reconciler.cpp
+
+#include "mempool_reconciler.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+
+MempoolReconciler::MempoolReconciler(
+    std::shared_ptr<PeerRegistry>       peers,
+    std::shared_ptr<MempoolManager>     mempool,
+    std::shared_ptr<VerifiedAuditCache> audit_cache,
+    std::shared_ptr<AuditProofStore>    proofs,
+    ReconcileOptions                    opts)
+  : peers_(std::move(peers))
+  , mempool_(std::move(mempool))
+  , audit_cache_(std::move(audit_cache))
+  , proofs_(std::move(proofs))
+  , opts_(opts)
+{
+  opts_.fetch_batch = std::max<size_t>(opts_.fetch_batch, 1);
+}
+
+MempoolReconciler::~MempoolReconciler() {
+  stop();
+}
+
+void MempoolReconciler::start() {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (running_ || peers_->Size() == 0) return;
+  running_ = true;
+  thr_ = std::thread(&MempoolReconciler::loop, this);
+}
+
+void MempoolReconciler::stop() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  if (thr_.joinable()) thr_.join();
+}
+
+MempoolReconciler::Stats MempoolReconciler::GetStats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return stats_;
+}
+
+void MempoolReconciler::loop() {
+  std::mt19937_64 rng{std::random_device{}()};
+  std::unique_lock<std::mutex> lk(mu_);
+  while (!cv_.wait_for(lk, opts_.interval, [&]{ return !running_; })) {
+    lk.unlock();
+    std::vector<size_t> up;
+    for (size_t i = 0; i < peers_->Size(); ++i) {
+      if (peers_->IsUp(i)) up.push_back(i);
+    }
+    if (up.empty()) {
+      std::uniform_int_distribution<size_t> pick(0, peers_->Size() - 1);
+      PullFrom(pick(rng));
+    } else {
+      std::uniform_int_distribution<size_t> pick(0, up.size() - 1);
+      PullFrom(up[pick(rng)]);
+    }
+    lk.lock();
+  }
+}
+
+size_t MempoolReconciler::PullFrom(size_t i) {
+  auto* stub = peers_->Stub(i);
+  const auto& peer = peers_->Addr(i);
+  auto deadline = [&](grpc::ClientContext& ctx) {
+    ctx.set_deadline(std::chrono::system_clock::now() + opts_.rpc_timeout);
+  };
+  std::chrono::steady_clock::time_point t0;
+  auto report = [&](const grpc::Status& st) {
+    peers_->Report(i, st, std::chrono::steady_clock::now() - t0);
+  };
+  auto failed = [&](const char* what, const grpc::Status& st) {
+    std::cerr << "[AntiEntropy] " << what << " from " << peer << " failed: "
+              << st.error_message() << "\n";
+    std::lock_guard<std::mutex> lk(mu_);
+    ++stats_.rounds;
+    ++stats_.failed_rounds;
+    return size_t(0);
+  };
+
+  // 1) Compare digests
+  blockchain::MempoolDigest theirs;
+  {
+    grpc::ClientContext ctx;
+    deadline(ctx);
+    t0 = std::chrono::steady_clock::now();
+    auto st = stub->GetMempoolDigest(&ctx, blockchain::MempoolDigestRequest(),
+                                     &theirs);
+    report(st);
+    if (!st.ok()) return failed("GetMempoolDigest", st);
+  }
+  auto ours = mempool_->IdDigest();
+  if (theirs.bucket_xor_size()   != static_cast<int>(ours.size()) ||
+      theirs.bucket_count_size() != static_cast<int>(ours.size())) {
+    std::cerr << "[AntiEntropy] " << peer << " sent a "
+              << theirs.bucket_xor_size() << "-bucket digest, expected "
+              << ours.size() << "\n";
+    std::lock_guard<std::mutex> lk(mu_);
+    ++stats_.rounds;
+    ++stats_.failed_rounds;
+    return 0;
+  }
+  blockchain::BucketIdsRequest diff;
+  for (size_t b = 0; b < ours.size(); ++b) {
+    if (ours[b].x != theirs.bucket_xor(b) ||
+        ours[b].count != theirs.bucket_count(b)) {
+      diff.add_buckets(static_cast<uint32_t>(b));
+    }
+  }
+  if (diff.buckets_size() == 0) {
+    std::lock_guard<std::mutex> lk(mu_);
+    ++stats_.rounds;
+    return 0;
+  }
+
+  // 2) Their req_ids in those buckets that we neither hold nor committed
+  blockchain::BucketIds ids;
+  {
+    grpc::ClientContext ctx;
+    deadline(ctx);
+    t0 = std::chrono::steady_clock::now();
+    auto st = stub->GetBucketIds(&ctx, diff, &ids);
+    report(st);
+    if (!st.ok()) return failed("GetBucketIds", st);
+  }
+  std::vector<std::string> want;
+  for (auto& id : ids.req_ids()) {
+    if (want.size() >= opts_.max_pull) break;
+    if (!mempool_->Contains(id) && !proofs_->Contains(id)) want.push_back(id);
+  }
+
+  // 3) Fetch, verify and admit them in chunks
+  size_t pulled = 0, rejected = 0;
+  bool   cut_short = false;
+  for (size_t at = 0; at < want.size(); at += opts_.fetch_batch) {
+    blockchain::FetchAuditsRequest req;
+    std::unordered_set<std::string> asked;
+    size_t end = std::min(want.size(), at + opts_.fetch_batch);
+    for (size_t k = at; k < end; ++k) {
+      req.add_req_ids(want[k]);
+      asked.insert(want[k]);
+    }
+    blockchain::WhisperBatch got;
+    grpc::ClientContext ctx;
+    deadline(ctx);
+    t0 = std::chrono::steady_clock::now();
+    auto st = stub->FetchAudits(&ctx, req, &got);
+    report(st);
+    if (!st.ok()) {
+      std::cerr << "[AntiEntropy] FetchAudits from " << peer << " failed: "
+                << st.error_message() << "\n";
+      cut_short = true;
+      break;
+    }
+
+    std::vector<std::string> bad;
+    std::vector<const common::FileAudit*> ok;
+    for (auto* a : audit_cache_->ValidAudits(got.audits(), &bad)) {
+      if (asked.count(a->req_id()) && !proofs_->Contains(a->req_id())) {
+        ok.push_back(a);
+      }
+    }
+    pulled   += mempool_->AppendBatch(ok);
+    rejected += bad.size();
+  }
+
+  if (pulled > 0 || rejected > 0) {
+    std::cout << "[AntiEntropy] pulled " << pulled << " audits from " << peer
+              << " (" << diff.buckets_size() << " buckets differed";
+    if (rejected > 0) std::cout << ", " << rejected << " bad signatures";
+    std::cout << ")\n";
+  }
+  std::lock_guard<std::mutex> lk(mu_);
+  ++stats_.rounds;
+  if (cut_short) ++stats_.failed_rounds;
+  stats_.buckets_differed += diff.buckets_size();
+  stats_.pulled           += pulled;
+  stats_.rejected         += rejected;
+  return pulled;
+}
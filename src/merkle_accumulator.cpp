@@ -0,0 +1,97 @@
+// src/merkle_accumulator.cpp
+
+#include "merkle_accumulator.h"
+#include <algorithm>
+
+MerkleAccumulator::MerkleAccumulator(MerkleMode mode)
+  : mode_(mode)
+  , levels_(1)
+{}
+
+void MerkleAccumulator::Reset(std::vector<Digest> leaves) {
+  levels_.assign(1, std::move(leaves));
+  extend(Size());
+}
+
+void MerkleAccumulator::Insert(size_t pos, const Digest& leaf) {
+  auto& leaves = levels_[0];
+  pos = std::min(pos, leaves.size());
+  leaves.insert(leaves.begin() + pos, leaf);
+  invalidateFrom(pos);
+  extend(leaves.size());
+}
+
+void MerkleAccumulator::Erase(size_t pos) {
+  auto& leaves = levels_[0];
+  if (pos >= leaves.size()) return;
+  leaves.erase(leaves.begin() + pos);
+  invalidateFrom(pos);
+}
+
+void MerkleAccumulator::EraseFront(size_t count) {
+  auto& leaves = levels_[0];
+  count = std::min(count, leaves.size());
+  leaves.erase(leaves.begin(), leaves.begin() + count);
+
+  // A level stays aligned only if its node width divides the shift
+  for (size_t l = 1; l < levels_.size(); ++l) {
+    if (count % (size_t{1} << l) != 0) {
+      levels_.resize(l);
+      break;
+    }
+    auto& nodes = levels_[l];
+    nodes.erase(nodes.begin(),
+                nodes.begin() + std::min(count >> l, nodes.size()));
+  }
+}
+
+void MerkleAccumulator::invalidateFrom(size_t pos) {
+  for (size_t l = 1; l < levels_.size(); ++l) {
+    auto& nodes = levels_[l];
+    nodes.resize(std::min(nodes.size(), pos >> l));
+  }
+}
+
+// Hash every missing aligned node that lies entirely within [0, n).
+void MerkleAccumulator::extend(size_t n) {
+  for (size_t l = 1; (n >> l) > 0; ++l) {
+    if (levels_.size() <= l) levels_.resize(l + 1);
+    const auto& below = levels_[l - 1];
+    auto&       nodes = levels_[l];
+    size_t      full  = n >> l;
+    nodes.reserve(full);
+    for (size_t k = nodes.size(); k < full; ++k) {
+      nodes.push_back(MerkleParent(below[2*k], below[2*k + 1], mode_));
+    }
+  }
+}
+
+std::string MerkleAccumulator::Root(size_t n) {
+  n = std::min(n, Size());
+  if (n == 0) return "";
+  extend(n);
+  if (n == 1) return DigestToHex(levels_[0][0]);
+
+  // Walk up the right edge of the prefix tree. At each level at most the
+  // last node is partial (not aligned); everything left of it is cached.
+  Digest edge{};
+  bool   has_edge = false;
+  size_t count    = n;   // nodes on the level below
+  for (size_t l = 1; ; ++l) {
+    size_t full       = n >> l;
+    size_t full_below = n >> (l - 1);
+    size_t parents    = (count + 1) / 2;
+    if (parents > full) {
+      const auto&   below = levels_[l - 1];
+      size_t        li    = 2 * full;
+      const Digest& left  = li < full_below ? below[li] : edge;
+      const Digest& right = (li + 1 == full_below && has_edge) ? edge : left;
+      edge     = MerkleParent(left, right, mode_);
+      has_edge = true;
+    } else {
+      has_edge = false;
+    }
+    count = parents;
+    if (count == 1) return DigestToHex(has_edge ? edge : levels_[l][0]);
+  }
+}
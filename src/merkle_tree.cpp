@@ -1,25 +1,102 @@
 #include "merkle_tree.h"
+#include <openssl/evp.h>
 #include <openssl/sha.h>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
+#include <memory>
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <google/protobuf/io/coded_stream.h>
 
+static const char kHexDigits[] = "0123456789abcdef";
+
+static void hexInto(const unsigned char* buf, size_t len, char* out) {
+  for (size_t i = 0; i < len; i++) {
+    out[2*i]     = kHexDigits[buf[i] >> 4];
+    out[2*i + 1] = kHexDigits[buf[i] & 0xF];
+  }
+}
+
 static std::string toHex(const unsigned char* buf, size_t len) {
-  std::ostringstream out;
-  out << std::hex << std::setfill('0');
-  for (size_t i = 0; i < len; i++)
-    out << std::setw(2) << (int)buf[i];
-  return out.str();
+  std::string out(2 * len, '\0');
+  hexInto(buf, len, &out[0]);
+  return out;
+}
+
+// Fetched once: EVP_sha256() and the SHA256() one-shot re-fetch the
+// algorithm on every use, which costs more than hashing a Merkle node
+static const EVP_MD* sha256Md() {
+  static EVP_MD* md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+  return md;
+}
+
+// SHA-256 through the pre-fetched EVP_MD and a per-thread context;
+// OpenSSL picks SHA-NI when available.
+static void sha256(const void* data, size_t len, unsigned char* out) {
+  const EVP_MD* md = sha256Md();
+  thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>
+    ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+  EVP_DigestInit_ex2(ctx.get(), md, nullptr);
+  EVP_DigestUpdate(ctx.get(), data, len);
+  EVP_DigestFinal_ex(ctx.get(), out, nullptr);
 }
 
 std::string SHA256Hex(const std::string& data) {
+  return SHA256Hex(data.data(), data.size());
+}
+
+std::string SHA256Hex(const void* data, size_t len) {
   unsigned char hash[SHA256_DIGEST_LENGTH];
-  SHA256(reinterpret_cast<const unsigned char*>(data.data()),
-         data.size(), hash);
+  sha256(data, len, hash);
   return toHex(hash, SHA256_DIGEST_LENGTH);
 }
 
+Digest SHA256Digest(const void* data, size_t len) {
+  Digest d;
+  sha256(data, len, d.data());
+  return d;
+}
+
+Sha256Stream::Sha256Stream()
+  : ctx_(EVP_MD_CTX_new())
+{
+  EVP_DigestInit_ex2(ctx_, sha256Md(), nullptr);
+}
+
+Sha256Stream::~Sha256Stream() {
+  EVP_MD_CTX_free(ctx_);
+}
+
+Sha256Stream& Sha256Stream::Update(const void* data, size_t len) {
+  EVP_DigestUpdate(ctx_, data, len);
+  return *this;
+}
+
+Digest Sha256Stream::Final() {
+  Digest d;
+  EVP_DigestFinal_ex(ctx_, d.data(), nullptr);
+  EVP_DigestInit_ex2(ctx_, sha256Md(), nullptr);
+  return d;
+}
+
+std::string DigestToHex(const Digest& d) {
+  return toHex(d.data(), d.size());
+}
+
+bool HexToDigest(const std::string& hex, Digest* out) {
+  auto nibble = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  };
+  if (hex.size() != 2 * out->size()) return false;
+  for (size_t i = 0; i < out->size(); ++i) {
+    int hi = nibble(hex[2*i]), lo = nibble(hex[2*i + 1]);
+    if (hi < 0 || lo < 0) return false;
+    (*out)[i] = static_cast<uint8_t>(hi << 4 | lo);
+  }
+  return true;
+}
+
 /// New: deterministic Serialize
 std::string DeterministicSerialize(const google::protobuf::Message& msg) {
   std::string out;
@@ -44,4 +121,55 @@ std::string ComputeMerkleRoot(const std::vector<std::string>& leaf_hashes) {
     level.swap(next);
   }
   return level[0];
-}
\ No newline at end of file
+}
+
+// Parent node of (l, r); reads both children before writing `out`, so out
+// may alias either of them.
+static void hashPair(const Digest& l, const Digest& r, MerkleMode mode,
+                     Digest* out) {
+  if (mode == MerkleMode::kBinary) {
+    unsigned char buf[64];
+    std::memcpy(buf,      l.data(), 32);
+    std::memcpy(buf + 32, r.data(), 32);
+    sha256(buf, sizeof(buf), out->data());
+  } else {
+    char buf[128];
+    hexInto(l.data(), 32, buf);
+    hexInto(r.data(), 32, buf + 64);
+    sha256(buf, sizeof(buf), out->data());
+  }
+}
+
+Digest MerkleParent(const Digest& left, const Digest& right, MerkleMode mode) {
+  Digest out;
+  hashPair(left, right, mode, &out);
+  return out;
+}
+
+std::string ComputeMerkleRoot(std::vector<Digest> level, MerkleMode mode) {
+  if (level.empty()) return "";
+  size_t n = level.size();
+  while (n > 1) {
+    size_t parents = (n + 1) / 2;
+    for (size_t i = 0; i < parents; ++i) {
+      const Digest& left  = level[2*i];
+      const Digest& right = (2*i + 1 < n ? level[2*i + 1] : left);
+      hashPair(left, right, mode, &level[i]);
+    }
+    n = parents;
+  }
+  return DigestToHex(level[0]);
+}
+
+bool VerifyMerkleProof(const Digest& leaf, uint64_t index,
+                       const std::vector<Digest>& siblings, MerkleMode mode,
+                       const std::string& root_hex) {
+  if (siblings.size() < 64 && (index >> siblings.size()) != 0) return false;
+  Digest node = leaf;
+  for (const Digest& sib : siblings) {
+    if (index & 1) hashPair(sib, node, mode, &node);
+    else           hashPair(node, sib, mode, &node);
+    index >>= 1;
+  }
+  return DigestToHex(node) == root_hex;
+}
@@ -0,0 +1,51 @@
+// src/parallel_merkle.cpp
+
+#include "parallel_merkle.h"
+#include <algorithm>
+
+// Smallest run handed to one worker, and runs per thread to even out load
+static constexpr size_t kMinRun        = 256;
+static constexpr size_t kRunsPerThread = 4;
+
+// Apply `rounds` reductions to base[0, count) in place, duplicating the
+// last node of odd levels (a single node is hashed with itself).
+static void reduceRun(Digest* base, size_t count, size_t rounds,
+                      MerkleMode mode) {
+  for (size_t r = 0; r < rounds; ++r) {
+    size_t parents = (count + 1) / 2;
+    for (size_t i = 0; i < parents; ++i) {
+      const Digest& left  = base[2*i];
+      const Digest& right = 2*i + 1 < count ? base[2*i + 1] : left;
+      base[i] = MerkleParent(left, right, mode);
+    }
+    count = parents;
+  }
+}
+
+std::string ParallelMerkleRoot(std::vector<Digest> leaves, MerkleMode mode,
+                               WorkerPool* pool, size_t serial_below) {
+  size_t n = leaves.size();
+  if (!pool || pool->Size() == 0 || n < serial_below) {
+    return ComputeMerkleRoot(std::move(leaves), mode);
+  }
+
+  // Largest power-of-two run that still gives every thread a few runs
+  size_t want = (pool->Size() + 1) * kRunsPerThread;
+  size_t rounds = 0;
+  while ((kMinRun << (rounds + 1)) * want <= n) ++rounds;
+  size_t run = kMinRun << rounds;
+  rounds += 8;   // log2(kMinRun)
+  size_t runs = (n + run - 1) / run;
+  if (runs < 2) return ComputeMerkleRoot(std::move(leaves), mode);
+
+  Digest* base = leaves.data();
+  pool->ParallelFor(runs, [&](size_t k) {
+    size_t begin = k * run;
+    reduceRun(base + begin, std::min(run, n - begin), rounds, mode);
+  });
+
+  // Each run's root is the level-`rounds` node above it
+  std::vector<Digest> tops(runs);
+  for (size_t k = 0; k < runs; ++k) tops[k] = leaves[k * run];
+  return ComputeMerkleRoot(std::move(tops), mode);
+}
@@ -0,0 +1,121 @@
+// src/peer_registry.cpp
+
+#include "peer_registry.h"
+#include <algorithm>
+#include <iostream>
+
+PeerRegistry::PeerRegistry(const std::vector<std::string>& peers,
+                           PeerOptions opts)
+  : opts_(opts)
+  , addrs_(peers)
+  , health_(peers.size())
+{
+  opts_.down_after_failures = std::max<size_t>(opts_.down_after_failures, 1);
+
+  grpc::ChannelArguments args;
+  args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS,
+              static_cast<int>(opts_.keepalive_time.count()));
+  args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS,
+              static_cast<int>(opts_.keepalive_timeout.count()));
+  args.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+  args.SetInt(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+  args.SetMaxReceiveMessageSize(static_cast<int>(opts_.max_message_bytes));
+  args.SetMaxSendMessageSize(static_cast<int>(opts_.max_message_bytes));
+
+  for (auto& addr : peers) {
+    auto chan = grpc::CreateCustomChannel(
+      addr, grpc::InsecureChannelCredentials(), args);
+    stubs_.push_back(blockchain::BlockChainService::NewStub(chan));
+    channels_.push_back(std::move(chan));
+  }
+}
+
+void PeerRegistry::Report(size_t i, const grpc::Status& st,
+                          std::chrono::steady_clock::duration rtt) {
+  switch (st.error_code()) {
+    case grpc::StatusCode::UNAVAILABLE:
+    case grpc::StatusCode::DEADLINE_EXCEEDED:
+      ReportFailure(i);
+      break;
+    default:
+      ReportSuccess(i, rtt);
+  }
+}
+
+void PeerRegistry::ReportSuccess(size_t i,
+                                 std::chrono::steady_clock::duration rtt) {
+  int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(rtt)
+                 .count();
+  std::lock_guard<std::mutex> lk(mu_);
+  auto& h = health_.at(i);
+  ++h.calls;
+  h.streak = 0;
+  // EWMA with weight 1/8, as TCP smooths its RTT
+  h.rtt_us = h.rtt_us == 0 ? us : h.rtt_us + (us - h.rtt_us) / 8;
+  if (h.down) {
+    h.down = false;
+    std::cout << "[Peers] " << addrs_[i] << " is up\n";
+  }
+}
+
+void PeerRegistry::ReportFailure(size_t i) {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto& h = health_.at(i);
+  ++h.failures;
+  if (++h.streak >= opts_.down_after_failures && !h.down) {
+    h.down = true;
+    std::cerr << "[Peers] marking " << addrs_[i] << " down after "
+              << h.streak << " failed calls\n";
+  }
+}
+
+bool PeerRegistry::IsUp(size_t i) const {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (health_.at(i).down) return false;
+  }
+  return channels_[i]->GetState(false) != GRPC_CHANNEL_TRANSIENT_FAILURE;
+}
+
+std::chrono::microseconds PeerRegistry::Rtt(size_t i) const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return std::chrono::microseconds(health_.at(i).rtt_us);
+}
+
+std::vector<size_t> PeerRegistry::Ordered() const {
+  std::vector<std::pair<bool, int64_t>> key(addrs_.size());
+  for (size_t i = 0; i < key.size(); ++i) {
+    key[i] = {!IsUp(i), Rtt(i).count()};
+  }
+  std::vector<size_t> out(addrs_.size());
+  for (size_t i = 0; i < out.size(); ++i) out[i] = i;
+  std::stable_sort(out.begin(), out.end(),
+                   [&](size_t a, size_t b) { return key[a] < key[b]; });
+  return out;
+}
+
+void PeerRegistry::ConfigureServer(grpc::ServerBuilder& builder) const {
+  // Accept our peers' keepalive pings, with slack for timer jitter, instead
+  // of answering them with GOAWAY "too_many_pings"
+  builder.AddChannelArgument(
+    GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS,
+    static_cast<int>(opts_.keepalive_time.count() / 2));
+  builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+  builder.SetMaxReceiveMessageSize(static_cast<int>(opts_.max_message_bytes));
+  builder.SetMaxSendMessageSize(static_cast<int>(opts_.max_message_bytes));
+}
+
+std::vector<PeerRegistry::PeerStats> PeerRegistry::GetStats() const {
+  std::vector<PeerStats> out(addrs_.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i].addr = addrs_[i];
+    out[i].up   = IsUp(i);
+  }
+  std::lock_guard<std::mutex> lk(mu_);
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i].rtt_us   = health_[i].rtt_us;
+    out[i].calls    = health_[i].calls;
+    out[i].failures = health_[i].failures;
+  }
+  return out;
+}
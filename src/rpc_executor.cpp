@@ -0,0 +1,91 @@
+// src/rpc_executor.cpp
+
+#include "rpc_executor.h"
+#include <algorithm>
+#include <iostream>
+
+RpcExecutor::RpcExecutor(std::string name, size_t threads, size_t queue_limit)
+  : name_(std::move(name))
+  , threads_n_(std::max<size_t>(threads, 1))
+  , queue_limit_(queue_limit)
+{
+  stats_.threads = threads_n_;
+}
+
+RpcExecutor::~RpcExecutor() {
+  stop();
+}
+
+void RpcExecutor::start() {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (running_ || stopped_) return;
+  running_ = true;
+  for (size_t i = 0; i < threads_n_; ++i) {
+    threads_.emplace_back(&RpcExecutor::loop, this);
+  }
+}
+
+void RpcExecutor::stop() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopped_ = true;
+  }
+  cv_.notify_all();
+  for (auto& t : threads_) {
+    if (t.joinable()) t.join();
+  }
+
+  // Never started: run what was queued here, so every call still finishes
+  std::unique_lock<std::mutex> lk(mu_);
+  while (!queue_.empty()) {
+    auto task = std::move(queue_.front());
+    queue_.pop_front();
+    lk.unlock();
+    task();
+    lk.lock();
+    ++stats_.completed;
+  }
+}
+
+bool RpcExecutor::Submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (stopped_) return false;
+    if (queue_limit_ > 0 && queue_.size() >= queue_limit_) {
+      ++stats_.rejected;
+      if (!full_logged_) {
+        full_logged_ = true;
+        std::cerr << "[RpcExecutor] " << name_ << " queue full ("
+                  << queue_limit_ << " calls), rejecting\n";
+      }
+      return false;
+    }
+    queue_.push_back(std::move(task));
+    stats_.peak_queued = std::max(stats_.peak_queued, queue_.size());
+  }
+  cv_.notify_one();
+  return true;
+}
+
+RpcExecutor::Stats RpcExecutor::GetStats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  Stats out = stats_;
+  out.queued = queue_.size();
+  return out;
+}
+
+void RpcExecutor::loop() {
+  std::unique_lock<std::mutex> lk(mu_);
+  for (;;) {
+    cv_.wait(lk, [&]{ return stopped_ || !queue_.empty(); });
+    if (queue_.empty()) return;    // stopped and drained
+
+    auto task = std::move(queue_.front());
+    queue_.pop_front();
+    if (queue_.size() < queue_limit_ / 2) full_logged_ = false;
+    lk.unlock();
+    task();
+    lk.lock();
+    ++stats_.completed;
+  }
+}
@@ -4,96 +4,45 @@
 #include "merkle_tree.h"    
 #include "heartbeat_table.h"   
 #include "election_state.h"                   // SHA256Hex, ComputeMerkleRoot
+#include "verified_audit_cache.h"
+#include "canonical_audit.h"
+#include "audit_envelope.h"
 #include <google/protobuf/util/json_util.h>       // MessageToJsonString
-#include <openssl/pem.h>
-#include <openssl/evp.h>
-#include <openssl/bio.h>
-#include <openssl/buffer.h>
 #include <iostream>
 #include <chrono>
+#include <thread>
 #include <unordered_set>
-#include <nlohmann/json.hpp>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
-using ordered_json = nlohmann::ordered_json;
 namespace fs = std::filesystem;
 using namespace std::chrono;
 
 using google::protobuf::util::MessageToJsonString;
 using google::protobuf::util::JsonStringToMessage;
 
-static constexpr auto kGossipTimeoutMs = 200;
-
-// Utility: Base64-decode into a byte vector
-static std::vector<unsigned char> Base64Decode(const std::string& b64) {
-  BIO* bmem  = BIO_new_mem_buf(b64.data(), (int)b64.size());
-  BIO* b64f  = BIO_new(BIO_f_base64());
-  BIO_set_flags(b64f, BIO_FLAGS_BASE64_NO_NL);
-  bmem = BIO_push(b64f, bmem);
-  std::vector<unsigned char> out(b64.size());
-  int len = BIO_read(bmem, out.data(), (int)out.size());
-  BIO_free_all(bmem);
-  if (len < 0) return {};
-  out.resize(len);
-  return out;
-}
+// How long a proposal may wait for its parent's vote or commit to land
+static constexpr auto kParentWaitMs = 100;
 
-// Utility: verify signature_b64 over data using PEM public key
-static bool VerifySignature(
-    const std::string& data,
-    const std::string& signature_b64,
-    const std::string& pubkey_pem)
-{
-  auto sig = Base64Decode(signature_b64);
-  std::cout << "[VerifySignature] decoded signature (len="
-            << sig.size() << ")\n";
-  BIO* bio = BIO_new_mem_buf(pubkey_pem.data(), (int)pubkey_pem.size());
-  EVP_PKEY* pkey = PEM_read_bio_PUBKEY(bio, NULL, NULL, NULL);
-  BIO_free(bio);
-  std::cout << "[VerifySignature] decoded public key (len="
-            << pubkey_pem << ")\n";
-  std::cout << "Signature: " << signature_b64 << "\n";
-  std::cout << "Data: " << data << "\n";
-  if (!pkey) return false;
-
-  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-  
-  EVP_DigestVerifyInit(ctx, NULL, EVP_sha256(), NULL, pkey);
+// Cap on one FetchAudits call, keeping the reply under gRPC's 4 MiB limit
+static constexpr size_t kMaxFetchAudits = 1024;
 
-  EVP_PKEY_CTX *pctx = EVP_MD_CTX_pkey_ctx(ctx);
-  if (EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PADDING) <= 0) {
-    std::cerr << "Failed to set RSA padding\n";
-  }
+// Audits a SubmitAuditStream reads ahead of the batch being made durable
+static constexpr int kStreamReadAhead = 1024;
 
-  EVP_DigestVerifyUpdate(ctx, data.data(), data.size());
-  int rc = EVP_DigestVerifyFinal(ctx, sig.data(), sig.size());
-  std::cout << "[VerifySignature] EVP_DigestVerifyFinal rc="
-            << rc << "\n";
-  EVP_MD_CTX_free(ctx);
-  EVP_PKEY_free(pkey);
-  return rc == 1;
-}
+// Audits in one envelope at most (a 14-level path each)
+static constexpr int kMaxEnvelopeAudits = 16384;
 
 // -- FileAuditServiceImpl -------------------------------------------------
 
 FileAuditServiceImpl::FileAuditServiceImpl(
-    const std::vector<std::string>& peers,
-    std::shared_ptr<MempoolManager> mempool)
+    std::shared_ptr<MempoolManager> mempool,
+    std::shared_ptr<VerifiedAuditCache> audit_cache,
+    std::shared_ptr<GossipDispatcher> gossip)
   : mempool_(std::move(mempool))
+  , audit_cache_(std::move(audit_cache))
+  , gossip_(std::move(gossip))
 {
-  for (auto& addr : peers) {
-    std::cout << "[FileAuditServiceImpl] gossip to peer="
-              << addr << "\n";
-    auto chan = grpc::CreateChannel(addr, grpc::InsecureChannelCredentials());
-    gossip_stubs_.push_back(
-      blockchain::BlockChainService::NewStub(chan));
-  }
-}
-
-std::vector<std::unique_ptr<blockchain::BlockChainService::Stub>>&
-FileAuditServiceImpl::getGossipStubs() {
-  return gossip_stubs_;
 }
 
 
@@ -103,65 +52,168 @@ grpc::Status FileAuditServiceImpl::SubmitAudit(
     fileaudit::FileAuditResponse* response)
 {
 
-  std::cout << "[SubmitAudit] client signature="
-            << request->signature() << "\n";
-  std::cout << "[SubmitAudit] client public key="
-            << request->public_key() << "\n";
   std::cout << "[SubmitAudit] verifying client signature\n";
 
-  // 1) Canonical JSON payload (sorted keys)
-  ordered_json j;
-  j["access_type"] = request->access_type();
-  j["file_info"]   = {{"file_id",   request->file_info().file_id()},
-                      {"file_name", request->file_info().file_name()}};
-  j["req_id"]      = request->req_id();
-  j["timestamp"]   = request->timestamp();
-  j["user_info"]   = {{"user_id",   request->user_info().user_id()},
-                      {"user_name", request->user_info().user_name()}};
-  std::string payload = j.dump();
+  // 1) Canonical JSON payload (sorted keys), in a per-thread buffer
+  thread_local std::string payload;
+  payload.clear();
+  bool encoded = AppendCanonicalAudit(*request, &payload);
   std::cout << "[SubmitAudit] payload=" << payload << "\n";
 
-  if (!VerifySignature(payload,
-                       request->signature(),
-                       request->public_key())) {
+  if (!encoded || !audit_cache_->Verify(*request, payload)) {
     return grpc::Status(
       grpc::StatusCode::INVALID_ARGUMENT,
       "Invalid client signature");
   }
   std::cout << "[SubmitAudit] verified client signature\n";
 
-  // 2) Persist to mempool
-  mempool_->Append(*request);
-
-  // 3) Gossip to peers
-for (auto& stub : gossip_stubs_) {
-    // create a new context and set a 200 ms deadline
-    grpc::ClientContext ctx2;
-    ctx2.set_deadline(
-      std::chrono::system_clock::now() +
-      std::chrono::milliseconds(kGossipTimeoutMs)
-    );
-
-    blockchain::WhisperResponse wr;
-    auto st = stub->WhisperAuditRequest(&ctx2, *request, &wr);
-
-    if (!st.ok()) {
-      if (st.error_code() == grpc::StatusCode::DEADLINE_EXCEEDED) {
-        std::cerr << "[Gossip] to peer timed out after "
-                  << kGossipTimeoutMs << "ms\n";
+  // 2) Persist to mempool (returns once the group commit is durable); a
+  //    duplicate is already there, but a failed write must not be acked
+  bool failed = false;
+  bool added  = mempool_->Append(*request, &failed);
+  if (failed) {
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                        "audit could not be persisted");
+  }
+
+  // 3) Queue for gossip; the dispatcher whispers it in the background
+  if (added) gossip_->Enqueue(*request);
+
+  // 4) Reply to client
+  response->set_req_id(request->req_id());
+  response->set_status("success");
+  return grpc::Status::OK;
+}
+
+grpc::Status FileAuditServiceImpl::SubmitAuditStream(
+    grpc::ServerContext* context,
+    grpc::ServerReaderWriter<fileaudit::FileAuditResponse,
+                             common::FileAudit>* stream)
+{
+  std::mutex              mu;
+  std::condition_variable cv;
+  google::protobuf::RepeatedPtrField<common::FileAudit> pending;
+  bool                    eof  = false;
+  bool                    stop = false;
+
+  std::thread reader([&] {
+    common::FileAudit a;
+    while (stream->Read(&a)) {
+      std::unique_lock<std::mutex> lk(mu);
+      cv.wait(lk, [&]{ return stop || pending.size() < kStreamReadAhead; });
+      if (stop) break;
+      *pending.Add() = std::move(a);
+      cv.notify_all();
+    }
+    std::lock_guard<std::mutex> lk(mu);
+    eof = true;
+    cv.notify_all();
+  });
+
+  // Each pass takes every audit read so far: one VerifyBatch, one durable
+  // AppendBatch, then the acks
+  uint64_t total = 0, rejected_total = 0;
+  bool     client_gone = false;
+  while (true) {
+    google::protobuf::RepeatedPtrField<common::FileAudit> chunk;
+    {
+      std::unique_lock<std::mutex> lk(mu);
+      cv.wait(lk, [&]{ return eof || !pending.empty(); });
+      if (pending.empty()) break;
+      chunk.Swap(&pending);
+      cv.notify_all();
+    }
+
+    std::vector<std::string> rejected;
+    auto valid = audit_cache_->ValidAudits(chunk, &rejected);
+    std::vector<const common::FileAudit*> admitted;
+    bool failed = false;
+    mempool_->AppendBatch(valid, &admitted, &failed);
+    for (auto* a : admitted) gossip_->Enqueue(*a);
+
+    std::unordered_set<std::string> bad(rejected.begin(), rejected.end());
+    fileaudit::FileAuditResponse ack;
+    for (int i = 0; i < chunk.size() && !client_gone; ++i) {
+      ack.set_req_id(chunk[i].req_id());
+      if (bad.count(chunk[i].req_id())) {
+        ack.set_status("failure");
+        ack.set_error_message("Invalid client signature");
+      } else if (failed) {
+        ack.set_status("failure");
+        ack.set_error_message("audit could not be persisted");
       } else {
-        std::cerr << "[Gossip] to peer failed: "
-                  << st.error_message() << "\n";
+        ack.set_status("success");
+        ack.clear_error_message();
       }
-    } else {
-      std::cout << "[Gossip] to peer succeeded: "
-                << wr.status() << "\n";
+      // Buffer all but the chunk's last ack into as few frames as possible
+      grpc::WriteOptions opts;
+      if (i + 1 < chunk.size()) opts.set_buffer_hint();
+      client_gone = !stream->Write(ack, opts);
+    }
+    total          += chunk.size();
+    rejected_total += rejected.size();
+    std::cout << "[SubmitAuditStream] " << chunk.size() << " audits: "
+              << admitted.size() << " added, " << rejected.size()
+              << " rejected" << (failed ? ", write failed" : "") << "\n";
+    if (client_gone) {
+      std::lock_guard<std::mutex> lk(mu);
+      stop = true;
+      cv.notify_all();
+      context->TryCancel();   // unblocks a pending Read
+      break;
     }
   }
+  reader.join();
 
-  // 4) Reply to client
-  response->set_req_id(request->req_id());
+  if (client_gone) {
+    return grpc::Status(grpc::StatusCode::CANCELLED, "client went away");
+  }
+  std::cout << "[SubmitAuditStream] stream done: " << total << " audits, "
+            << rejected_total << " rejected\n";
+  return grpc::Status::OK;
+}
+
+grpc::Status FileAuditServiceImpl::SubmitAuditEnvelope(
+    grpc::ServerContext* /*ctx*/,
+    const common::AuditEnvelope* request,
+    fileaudit::AuditEnvelopeResponse* response)
+{
+  auto fail = [&](const std::string& why) {
+    std::cerr << "[SubmitAuditEnvelope] rejected envelope of "
+              << request->audits_size() << " audits: " << why << "\n";
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, why);
+  };
+  if (request->audits_size() > kMaxEnvelopeAudits) {
+    return fail("more than " + std::to_string(kMaxEnvelopeAudits) +
+                " audits");
+  }
+
+  google::protobuf::RepeatedPtrField<common::FileAudit> audits;
+  std::string root = OpenEnvelope(*request, &audits);
+  if (root.empty()) return fail("empty envelope or invalid UTF-8");
+  if (!audit_cache_->VerifyEnvelope(root, request->signature(),
+                                    request->public_key())) {
+    return fail("Invalid client signature");
+  }
+
+  std::vector<const common::FileAudit*> all, admitted;
+  all.reserve(audits.size());
+  for (auto& a : audits) all.push_back(&a);
+  bool failed = false;
+  mempool_->AppendBatch(all, &admitted, &failed);
+  if (failed) {
+    std::cerr << "[SubmitAuditEnvelope] " << audits.size()
+              << " audits under " << root.substr(0, 12)
+              << " could not be persisted\n";
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                        "audits could not be persisted");
+  }
+  for (auto* a : admitted) gossip_->Enqueue(*a);
+
+  std::cout << "[SubmitAuditEnvelope] " << audits.size() << " audits under "
+            << root.substr(0, 12) << ": " << admitted.size() << " added\n";
   response->set_status("success");
+  response->set_added(static_cast<uint32_t>(admitted.size()));
   return grpc::Status::OK;
 }
 
@@ -173,12 +225,18 @@ BlockChainServiceImpl::BlockChainServiceImpl(
     ChainManager& chain,
     std::shared_ptr<HeartbeatTable> hb_table,
     ElectionState& election_state,
-    std::string self_addr)
+    std::string self_addr,
+    std::shared_ptr<VerifiedAuditCache> audit_cache,
+    std::shared_ptr<AuditProofStore> proofs,
+    std::shared_ptr<GossipDispatcher> gossip)
   : mempool_(std::move(mempool))
   , chain_(chain)
   , hb_table_(std::move(hb_table))
   , state_(election_state)
   , self_addr_(std::move(self_addr))
+  , audit_cache_(std::move(audit_cache))
+  , proofs_(std::move(proofs))
+  , gossip_(std::move(gossip))
 {}
 
 grpc::Status BlockChainServiceImpl::WhisperAuditRequest(
@@ -197,21 +255,13 @@ grpc::Status BlockChainServiceImpl::WhisperAuditRequest(
   std::cout << "  signature: (len=" << request->signature().size() << ")\n";
   std::cout << "  public_key: (len=" << request->public_key().size() << ")\n";
 
-  ordered_json j;
-  j["access_type"] = request->access_type();
-  j["file_info"]   = {{"file_id",   request->file_info().file_id()},
-                      {"file_name", request->file_info().file_name()}};
-  j["req_id"]      = request->req_id();
-  j["timestamp"]   = request->timestamp();
-  j["user_info"]   = {{"user_id",   request->user_info().user_id()},
-                      {"user_name", request->user_info().user_name()}};
-  std::string payload2 = j.dump();
+  thread_local std::string payload2;
+  payload2.clear();
+  bool encoded = AppendCanonicalAudit(*request, &payload2);
   std::cout << "[SubmitAudit] payload=" << payload2 << "\n";
 
 
-  if (!VerifySignature(payload2,
-                       request->signature(),
-                       request->public_key()))
+  if (!encoded || !audit_cache_->Verify(*request, payload2))
   {
     std::cerr << "[WhisperAuditRequest] invalid signature for req_id="
               << request->req_id() << "\n";
@@ -223,101 +273,281 @@ grpc::Status BlockChainServiceImpl::WhisperAuditRequest(
               << request->req_id() << "\n";
   }
 
-  // 2) Persist to mempool
-  mempool_->Append(*request);
-
-  // 3) Log that it's added
-  std::cout << "[WhisperAuditRequest] audit added to mempool\n";
+  // 2) Persist to mempool (returns once the group commit is durable)
+  bool failed = false;
+  if (mempool_->Append(*request, &failed)) {
+    std::cout << "[WhisperAuditRequest] audit added to mempool\n";
+    relay({request});
+  } else if (failed) {
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                        "audit could not be persisted");
+  }
 
   // 4) Ack
   response->set_status("success");
   return grpc::Status::OK;
 }
 
+grpc::Status BlockChainServiceImpl::WhisperAuditBatch(
+    grpc::ServerContext* /*ctx*/,
+    const blockchain::WhisperBatch* request,
+    blockchain::WhisperBatchResponse* response)
+{
+  // 1) Verify the whole batch on the crypto pool
+  std::vector<std::string> rejected;
+  auto good = audit_cache_->ValidAudits(request->audits(), &rejected);
+  for (auto& id : rejected) {
+    std::cerr << "[WhisperAuditBatch] invalid signature for req_id="
+              << id << "\n";
+    response->add_rejected_req_ids(id);
+  }
+
+  // 2) Persist with a single durability wait
+  std::vector<const common::FileAudit*> added;
+  bool failed = false;
+  mempool_->AppendBatch(good, &added, &failed);
+  if (failed) {
+    // The sender keeps the batch queued and retries it
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                        "audits could not be persisted");
+  }
+  std::cout << "[WhisperAuditBatch] " << request->audits_size()
+            << " audits: " << added.size() << " added, "
+            << rejected.size() << " rejected\n";
+
+  // 3) Epidemic mode: pass audits new to us on to our own fanout
+  relay(added);
+
+  response->set_status("success");
+  response->set_accepted(static_cast<uint32_t>(added.size()));
+  return grpc::Status::OK;
+}
+
+grpc::Status BlockChainServiceImpl::GetMempoolDigest(
+    grpc::ServerContext* /*ctx*/,
+    const blockchain::MempoolDigestRequest* /*request*/,
+    blockchain::MempoolDigest* response)
+{
+  auto digest = mempool_->IdDigest();
+  response->mutable_bucket_xor()->Reserve(digest.size());
+  response->mutable_bucket_count()->Reserve(digest.size());
+  for (auto& b : digest) {
+    response->add_bucket_xor(b.x);
+    response->add_bucket_count(b.count);
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status BlockChainServiceImpl::GetBucketIds(
+    grpc::ServerContext* /*ctx*/,
+    const blockchain::BucketIdsRequest* request,
+    blockchain::BucketIds* response)
+{
+  std::vector<uint32_t> buckets(request->buckets().begin(),
+                                request->buckets().end());
+  for (auto& id : mempool_->IdsInBuckets(buckets)) {
+    response->add_req_ids(std::move(id));
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status BlockChainServiceImpl::FetchAudits(
+    grpc::ServerContext* /*ctx*/,
+    const blockchain::FetchAuditsRequest* request,
+    blockchain::WhisperBatch* response)
+{
+  if (request->req_ids_size() > static_cast<int>(kMaxFetchAudits)) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "at most " + std::to_string(kMaxFetchAudits) +
+                        " req_ids per FetchAudits");
+  }
+  // Ids we no longer hold come back as empty placeholders; drop them
+  std::vector<int> missing;
+  mempool_->CopyAudits(request->req_ids(), response->mutable_audits(),
+                       &missing);
+  for (auto it = missing.rbegin(); it != missing.rend(); ++it) {
+    response->mutable_audits()->DeleteSubrange(*it, 1);
+  }
+  return grpc::Status::OK;
+}
+
+void BlockChainServiceImpl::relay(
+    const std::vector<const common::FileAudit*>& audits) {
+  if (!gossip_ || !gossip_->Epidemic()) return;
+  for (auto* a : audits) gossip_->Enqueue(*a);
+}
+
 grpc::Status BlockChainServiceImpl::ProposeBlock(
     grpc::ServerContext* /*ctx*/,
     const blockchain::Block* blk,
     blockchain::BlockVoteResponse* resp)
 {
-  // 1) Recompute Merkle root from the same JSON-hashes Python uses
-  std::vector<std::string> leafs;
+  voteOnBlock(*blk, nullptr, false, resp);
+  return grpc::Status::OK;
+}
+
+grpc::Status BlockChainServiceImpl::ProposeCompactBlock(
+    grpc::ServerContext* /*ctx*/,
+    const blockchain::CompactBlock* cb,
+    blockchain::BlockVoteResponse* resp)
+{
+  // Rebuild the block from our mempool plus whatever the leader prefilled
+  auto blk = std::make_shared<blockchain::Block>();
+  blk->set_id(cb->id());
+  blk->set_hash(cb->hash());
+  blk->set_previous_hash(cb->previous_hash());
+  blk->set_merkle_root(cb->merkle_root());
+  std::vector<int> missing;
+  mempool_->CopyAudits(cb->req_ids(), blk->mutable_audits(), &missing);
+
+  if (!missing.empty()) {
+    std::unordered_map<std::string, const common::FileAudit*> prefilled;
+    for (auto& a : cb->audits()) prefilled.emplace(a.req_id(), &a);
+    for (int i : missing) {
+      auto it = prefilled.find(cb->req_ids(i));
+      if (it != prefilled.end()) {
+        *blk->mutable_audits(i) = *it->second;
+      } else {
+        resp->add_missing_req_ids(cb->req_ids(i));
+      }
+    }
+  }
+  if (resp->missing_req_ids_size() > 0) {
+    resp->set_vote(false);
+    resp->set_status("missing");
+    return grpc::Status::OK;
+  }
+  voteOnBlock(*blk, blk, true, resp);
+  return grpc::Status::OK;
+}
+
+// Validate a proposed block and vote. A yes vote keeps the block (`owned`,
+// or a copy) until it's committed. For a block rebuilt from a compact
+// proposal a root or hash mismatch may just mean our copy of an audit
+// differs, so we ask for the full block instead of voting no.
+void BlockChainServiceImpl::voteOnBlock(
+    const blockchain::Block& block,
+    std::shared_ptr<const blockchain::Block> owned,
+    bool compact,
+    blockchain::BlockVoteResponse* resp)
+{
+  const blockchain::Block* blk = &block;
+  const char* mismatch = compact ? "full_required" : "failure";
+
+  // 0) an audit that is already on the chain must not be committed twice
   for (auto& a : blk->audits()) {
-    ordered_json j;
-    j["access_type"] = a.access_type();
-    j["file_info"]   = {
-      {"file_id",   a.file_info().file_id()},
-      {"file_name", a.file_info().file_name()}
-    };
-    j["req_id"]      = a.req_id();
-    j["timestamp"]   = a.timestamp();
-    j["user_info"]   = {
-      {"user_id",   a.user_info().user_id()},
-      {"user_name", a.user_info().user_name()}
-    };
-    leafs.push_back(SHA256Hex(j.dump()));
-  }
-  if (ComputeMerkleRoot(leafs) != blk->merkle_root()) {
+    if (proofs_->Contains(a.req_id())) {
+      resp->set_vote(false);
+      resp->set_status("failure");
+      resp->set_error_message("audit already committed: " + a.req_id());
+      return;
+    }
+  }
+
+  // 1) Recompute Merkle root from the same JSON-hashes Python uses (the
+  //    mempool already holds the leaves of audits we've been whispered)
+  std::vector<std::string> payloads;
+  if (mempool_->BlockMerkleRoot(blk->audits(), &payloads) != blk->merkle_root()) {
     resp->set_vote(false);
-    resp->set_status("failure");
+    resp->set_status(mismatch);
     resp->set_error_message("bad merkle_root");
-    return grpc::Status::OK;
+    return;
   }
 
-  // 2) prev‐hash
-  if (blk->previous_hash() != chain_.getLastHash()) {
+  // 2) prev‐hash: our chain head, or a block we voted for that the
+  //    leader hasn't committed yet
+  if (!awaitParent(*blk)) {
     resp->set_vote(false);
     resp->set_status("failure");
     resp->set_error_message("bad previous_hash");
-    return grpc::Status::OK;
+    return;
   }
 
-  // // 3) verify block.hash matches header:
-  // {
-  //     // recompute same header string
-  //   std::string hdr;
-  //   hdr += std::to_string(blk->id());
-  //   hdr += blk->previous_hash();
-  //   hdr += blk->merkle_root();
-  //   for (auto& a : blk->audits()) {
-  //     hdr += a.SerializeAsString();
-  //   }
-  //   auto expected = SHA256Hex(hdr);
-  //   if (expected != blk->hash()) {
-  //     resp->set_vote(false);
-  //     resp->set_status("failure");
-  //     resp->set_error_message("block_hash mismatch");
-  //     return grpc::Status::OK;
-  //   }
-  // }
-  // // 4) verify each audit’s signature…
-  // for (auto& a : blk->audits()) {
-  //   common::FileAudit copy = a;
-  //   copy.clear_signature();
-  //   copy.clear_public_key();
-  //   std::string payload;
-  //   copy.SerializeToString(&payload);
-  //   if (!VerifySignature(
-  //         payload,
-  //         a.signature(),
-  //         a.public_key()))
-  //   {
-  //     resp->set_vote(false);
-  //     resp->set_status("failure");
-  //     resp->set_error_message("invalid audit signature: " + a.req_id());
-  //     return grpc::Status::OK;
-  //   }
-  // }
+  // 3) verify block.hash matches header + canonical audits, streaming
+  //    the payloads from step 1 into the hash one at a time
+  {
+    Sha256Stream hasher;
+    hasher.Update(std::to_string(blk->id()))
+          .Update(blk->previous_hash())
+          .Update(blk->merkle_root());
+    for (auto& payload : payloads) hasher.Update(payload);
+    if (hasher.FinalHex() != blk->hash()) {
+      resp->set_vote(false);
+      resp->set_status(mismatch);
+      resp->set_error_message("block_hash mismatch");
+      return;
+    }
+  }
+
+  // 4) verify each audit’s signature (cached for audits we've whispered;
+  //    the rest are checked in parallel on the crypto pool)
+  size_t bad = audit_cache_->VerifyBatch(blk->audits(), &payloads);
+  if (bad < static_cast<size_t>(blk->audits_size())) {
+    resp->set_vote(false);
+    resp->set_status("failure");
+    resp->set_error_message(
+      "invalid audit signature: " + blk->audits(bad).req_id());
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(voted_mu_);
+    voted_[blk->hash()] = VotedBlock{
+      blk->id(), owned ? std::move(owned)
+                       : std::make_shared<const blockchain::Block>(*blk)};
+  }
+  voted_cv_.notify_all();
 
   resp->set_vote(true);
   resp->set_status("success");
-  return grpc::Status::OK;
+}
+
+// Wait briefly for `blk`'s parent to become our head or a voted block;
+// with pipelining its proposal can overtake the parent's
+bool BlockChainServiceImpl::awaitParent(const blockchain::Block& blk) {
+  std::unique_lock<std::mutex> lk(voted_mu_);
+  return voted_cv_.wait_for(lk, milliseconds(kParentWaitMs), [&]{
+    if (blk.previous_hash() == chain_.getLastHash()) return true;
+    auto it = voted_.find(blk.previous_hash());
+    return it != voted_.end() && it->second.id + 1 == blk.id();
+  });
 }
 
 grpc::Status BlockChainServiceImpl::CommitBlock(
     grpc::ServerContext* /*ctx*/,
     const blockchain::Block* blk,
-    blockchain::BlockCommitResponse* resp) 
+    blockchain::BlockCommitResponse* resp)
+{
+  applyCommit(*blk, resp);
+  return grpc::Status::OK;
+}
+
+grpc::Status BlockChainServiceImpl::ConfirmBlock(
+    grpc::ServerContext* /*ctx*/,
+    const blockchain::BlockCommitRef* ref,
+    blockchain::BlockCommitResponse* resp)
+{
+  std::shared_ptr<const blockchain::Block> blk;
+  {
+    std::lock_guard<std::mutex> lk(voted_mu_);
+    auto it = voted_.find(ref->hash());
+    if (it != voted_.end() && it->second.id == ref->id()) blk = it->second.block;
+  }
+  if (!blk) {
+    resp->set_status("unknown_block");
+    resp->set_error_message("no vote recorded for block " +
+                            std::to_string(ref->id()));
+    return grpc::Status::OK;
+  }
+  applyCommit(*blk, resp);
+  return grpc::Status::OK;
+}
+
+// Append a block to the chain, prune the mempool and write the block file
+void BlockChainServiceImpl::applyCommit(const blockchain::Block& block,
+                                        blockchain::BlockCommitResponse* resp)
 {
+  const blockchain::Block* blk = &block;
   std::cout << "[CommitBlock] received block id=" << blk->id()
             << ", merkle_root=" << blk->merkle_root() << "\n";
   // // 1) verify merkle root
@@ -340,7 +570,14 @@ grpc::Status BlockChainServiceImpl::CommitBlock(
   //   return grpc::Status::OK;
   // }
 
-  // // 3) (optional) verify each audit’s signature here…
+  // 3) verify each audit’s signature (normally cached by ProposeBlock)
+  size_t bad = audit_cache_->VerifyBatch(blk->audits());
+  if (bad < static_cast<size_t>(blk->audits_size())) {
+    resp->set_status("failure");
+    resp->set_error_message(
+      "invalid audit signature: " + blk->audits(bad).req_id());
+    return;
+  }
 
   // 4) commit into chain.json
   BlockMeta meta {
@@ -350,6 +587,14 @@ grpc::Status BlockChainServiceImpl::CommitBlock(
     blk->merkle_root()
   };
   chain_.append(meta);
+  {
+    // Votes on this block and any abandoned sibling are settled
+    std::lock_guard<std::mutex> lk(voted_mu_);
+    for (auto it = voted_.begin(); it != voted_.end();) {
+      it = it->second.id <= blk->id() ? voted_.erase(it) : std::next(it);
+    }
+  }
+  voted_cv_.notify_all();
 
   // 5) prune mempool
   std::vector<std::string> ids;
@@ -368,7 +613,7 @@ grpc::Status BlockChainServiceImpl::CommitBlock(
       std::cerr << "[CommitBlock] ERROR writing block file: " << path << "\n";
       resp->set_status("failure");
       resp->set_error_message("could not write block file");
-      return grpc::Status::OK;
+      return;
     }
     out << block_json;
     out.close();
@@ -377,11 +622,13 @@ grpc::Status BlockChainServiceImpl::CommitBlock(
     std::cerr << "[CommitBlock] exception writing block file: " << e.what() << "\n";
     resp->set_status("failure");
     resp->set_error_message("exception writing block file");
-    return grpc::Status::OK;
+    return;
   }
 
+  // 7) store the tree levels for inclusion proofs
+  proofs_->Record(*blk);
+
   resp->set_status("success");
-  return grpc::Status::OK;
 }
 
 grpc::Status BlockChainServiceImpl::GetBlock(
@@ -423,6 +670,31 @@ grpc::Status BlockChainServiceImpl::GetBlock(
   return grpc::Status::OK;
 }
 
+grpc::Status BlockChainServiceImpl::GetAuditProof(
+    grpc::ServerContext* /*ctx*/,
+    const blockchain::GetAuditProofRequest* req,
+    blockchain::GetAuditProofResponse* resp)
+{
+  // Served from the stored tree levels; the block itself isn't read
+  AuditProofStore::Proof proof;
+  if (!proofs_->GetProof(req->req_id(), &proof)) {
+    resp->set_status("failure");
+    resp->set_error_message("audit not found in a committed block");
+    return grpc::Status::OK;
+  }
+
+  resp->set_block_id(proof.block_id);
+  resp->set_block_hash(proof.block_hash);
+  resp->set_merkle_root(proof.merkle_root);
+  resp->set_leaf_index(static_cast<int64_t>(proof.leaf_index));
+  resp->set_leaf_hash(DigestToHex(proof.leaf));
+  for (auto& sib : proof.siblings) resp->add_siblings(DigestToHex(sib));
+  resp->set_merkle_mode(
+    proofs_->Mode() == MerkleMode::kBinary ? "binary" : "hex");
+  resp->set_status("success");
+  return grpc::Status::OK;
+}
+
 
 grpc::Status BlockChainServiceImpl::SendHeartbeat(
     grpc::ServerContext* /*ctx*/,
@@ -473,7 +745,7 @@ grpc::Status BlockChainServiceImpl::TriggerElection(
 
   // Our own stats
   int64_t my_blocks = chain_.getLastID();
-  int64_t my_pool   = static_cast<int64_t>(mempool_->LoadAll().size());
+  int64_t my_pool   = static_cast<int64_t>(mempool_->Size());
 
   bool vote_yes = false;
   if (cand_blocks > my_blocks ||
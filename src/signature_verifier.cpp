@@ -0,0 +1,99 @@
+// src/signature_verifier.cpp
+
+#include "signature_verifier.h"
+#include <openssl/bio.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <openssl/sha.h>
+#include <iostream>
+
+std::vector<unsigned char> Base64Decode(const std::string& b64) {
+  BIO* bmem  = BIO_new_mem_buf(b64.data(), (int)b64.size());
+  BIO* b64f  = BIO_new(BIO_f_base64());
+  BIO_set_flags(b64f, BIO_FLAGS_BASE64_NO_NL);
+  bmem = BIO_push(b64f, bmem);
+  std::vector<unsigned char> out(b64.size());
+  int len = BIO_read(bmem, out.data(), (int)out.size());
+  BIO_free_all(bmem);
+  if (len < 0) return {};
+  out.resize(len);
+  return out;
+}
+
+SignatureVerifier::SignatureVerifier(size_t capacity)
+  : capacity_(capacity > 0 ? capacity : 1)
+{}
+
+SignatureVerifier::KeyPtr SignatureVerifier::lookup(
+    const std::string& pubkey_pem
+) {
+  unsigned char md[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const unsigned char*>(pubkey_pem.data()),
+         pubkey_pem.size(), md);
+  std::string digest(reinterpret_cast<char*>(md), sizeof(md));
+
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = index_.find(digest);
+    if (it != index_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      ++stats_.hits;
+      return it->second->second;
+    }
+    ++stats_.misses;
+  }
+
+  // Parse outside the lock; a racing thread may parse the same key too
+  BIO* bio = BIO_new_mem_buf(pubkey_pem.data(), (int)pubkey_pem.size());
+  EVP_PKEY* raw = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+  BIO_free(bio);
+  if (!raw) return nullptr;
+  KeyPtr key(raw, EVP_PKEY_free);
+
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = index_.find(digest);
+  if (it != index_.end()) return it->second->second;
+  lru_.emplace_front(digest, key);
+  index_[digest] = lru_.begin();
+  if (lru_.size() > capacity_) {
+    index_.erase(lru_.back().first);
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+  return key;
+}
+
+bool SignatureVerifier::Verify(
+    const std::string& data,
+    const std::string& signature_b64,
+    const std::string& pubkey_pem)
+{
+  auto sig = Base64Decode(signature_b64);
+  KeyPtr pkey = lookup(pubkey_pem);
+  if (!pkey || sig.empty()) return false;
+
+  // One digest context per thread, reset between uses
+  thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>
+    ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+  EVP_MD_CTX_reset(ctx.get());
+
+  EVP_PKEY_CTX* pctx = nullptr;
+  if (EVP_DigestVerifyInit(ctx.get(), &pctx, EVP_sha256(), nullptr,
+                           pkey.get()) != 1) {
+    return false;
+  }
+  if (EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PADDING) <= 0) {
+    std::cerr << "[SignatureVerifier] failed to set RSA padding\n";
+  }
+  if (EVP_DigestVerifyUpdate(ctx.get(), data.data(), data.size()) != 1) {
+    return false;
+  }
+  return EVP_DigestVerifyFinal(ctx.get(), sig.data(), sig.size()) == 1;
+}
+
+SignatureVerifier::Stats SignatureVerifier::GetStats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  Stats s = stats_;
+  s.size  = lru_.size();
+  return s;
+}
@@ -0,0 +1,102 @@
+// src/stats_reporter.cpp
+
+#include "stats_reporter.h"
+#include <iostream>
+#include <sstream>
+
+StatsReporter::StatsReporter(StatsSources sources,
+                             std::chrono::milliseconds interval)
+  : sources_(std::move(sources))
+  , interval_(interval)
+{}
+
+StatsReporter::~StatsReporter() {
+  stop();
+}
+
+void StatsReporter::start() {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (running_ || interval_.count() <= 0) return;
+  running_ = true;
+  thr_ = std::thread(&StatsReporter::loop, this);
+}
+
+void StatsReporter::stop() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  if (thr_.joinable()) thr_.join();
+}
+
+void StatsReporter::loop() {
+  std::unique_lock<std::mutex> lk(mu_);
+  while (!cv_.wait_for(lk, interval_, [&]{ return !running_; })) {
+    lk.unlock();
+    std::cout << Report() << std::flush;
+    lk.lock();
+  }
+}
+
+// Hits as a percentage of all lookups
+static double HitRate(uint64_t hits, uint64_t misses) {
+  uint64_t total = hits + misses;
+  return total ? 100.0 * hits / total : 0.0;
+}
+
+std::string StatsReporter::Report() const {
+  std::ostringstream out;
+  out.setf(std::ios::fixed);
+  out.precision(1);
+
+  if (auto& m = sources_.mempool) {
+    out << "[Stats] mempool: pending=" << m->Size()
+        << " reserved=" << m->ReservedCount()
+        << " admitted=" << m->AdmittedCount()
+        << " segments=" << m->SegmentCount() << "\n";
+  }
+  if (auto& p = sources_.peers) {
+    for (auto& s : p->GetStats()) {
+      out << "[Stats] peer " << s.addr << ": " << (s.up ? "up" : "down")
+          << " rtt=" << s.rtt_us << "us calls=" << s.calls
+          << " failures=" << s.failures << "\n";
+    }
+  }
+  if (auto& g = sources_.gossip) {
+    for (auto& s : g->GetStats()) {
+      out << "[Stats] gossip " << s.addr << ": depth=" << s.depth
+          << " sent=" << s.sent << " dropped=" << s.dropped
+          << " failures=" << s.failures << "\n";
+    }
+  }
+  if (auto& v = sources_.verifier) {
+    auto s = v->GetStats();
+    out << "[Stats] pubkey cache: size=" << s.size << " hit="
+        << HitRate(s.hits, s.misses) << "% (" << s.hits << "/"
+        << s.hits + s.misses << ") evictions=" << s.evictions << "\n";
+  }
+  if (auto& c = sources_.audit_cache) {
+    auto s = c->GetStats();
+    out << "[Stats] verified audits: size=" << s.size << " hit="
+        << HitRate(s.hits, s.misses) << "% rsa_checks=" << s.misses
+        << " invalid=" << s.failures << " evictions=" << s.evictions
+        << "\n";
+  }
+  for (auto* e : {sources_.control.get(), sources_.data.get()}) {
+    if (!e) continue;
+    auto s = e->GetStats();
+    out << "[Stats] rpc " << e->Name() << ": threads=" << s.threads
+        << " queued=" << s.queued << " peak=" << s.peak_queued
+        << " completed=" << s.completed << " rejected=" << s.rejected
+        << "\n";
+  }
+  if (auto* r = sources_.reconciler) {
+    auto s = r->GetStats();
+    out << "[Stats] anti-entropy: rounds=" << s.rounds
+        << " failed=" << s.failed_rounds
+        << " buckets_differed=" << s.buckets_differed
+        << " pulled=" << s.pulled << " rejected=" << s.rejected << "\n";
+  }
+  return out.str();
+}
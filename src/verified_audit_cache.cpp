@@ -0,0 +1,186 @@
+// src/verified_audit_cache.cpp
+
+#include "verified_audit_cache.h"
+#include "canonical_audit.h"
+#include "audit_envelope.h"
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+// Below this many audits a batch is verified on the calling thread
+static constexpr size_t kParallelMin = 8;
+// Audits claimed per worker step (each RSA verify is tens of microseconds)
+static constexpr size_t kGrain       = 4;
+
+VerifiedAuditCache::VerifiedAuditCache(
+    std::shared_ptr<SignatureVerifier> verifier,
+    size_t capacity,
+    std::shared_ptr<WorkerPool> pool)
+  : verifier_(std::move(verifier))
+  , pool_(std::move(pool))
+  , capacity_(capacity > 0 ? capacity : 1)
+{}
+
+std::string VerifiedAuditCache::cacheKey(
+    const common::FileAudit& audit,
+    const std::string& payload) const
+{
+  unsigned char md[2 * SHA256_DIGEST_LENGTH];
+
+  // Signature and the key it is checked against, then the signed payload
+  thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>
+    ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+  EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
+  EVP_DigestUpdate(ctx.get(), audit.signature().data(), audit.signature().size());
+  EVP_DigestUpdate(ctx.get(), audit.public_key().data(), audit.public_key().size());
+  if (!audit.envelope_root().empty()) {
+    uint32_t index = audit.envelope_index();
+    EVP_DigestUpdate(ctx.get(), audit.envelope_root().data(),
+                     audit.envelope_root().size());
+    EVP_DigestUpdate(ctx.get(), &index, sizeof(index));
+    for (auto& sib : audit.envelope_path()) {
+      EVP_DigestUpdate(ctx.get(), sib.data(), sib.size());
+    }
+  }
+  EVP_DigestFinal_ex(ctx.get(), md, nullptr);
+  SHA256(reinterpret_cast<const unsigned char*>(payload.data()),
+         payload.size(), md + SHA256_DIGEST_LENGTH);
+
+  std::string key = audit.req_id();
+  key.push_back('\0');
+  key.append(reinterpret_cast<char*>(md), sizeof(md));
+  return key;
+}
+
+bool VerifiedAuditCache::Verify(const common::FileAudit& audit) {
+  std::string payload;
+  if (!AppendCanonicalAudit(audit, &payload)) return false;
+  return Verify(audit, payload);
+}
+
+bool VerifiedAuditCache::Verify(
+    const common::FileAudit& audit,
+    const std::string& payload)
+{
+  std::string key = cacheKey(audit, payload);
+  if (lookup(key)) return true;
+
+  if (!audit.envelope_root().empty()) {
+    if (!CheckEnvelopePath(audit, payload)) {
+      std::lock_guard<std::mutex> lk(mu_);
+      ++stats_.failures;
+      return false;
+    }
+    if (!VerifyEnvelope(audit.envelope_root(), audit.signature(),
+                        audit.public_key())) {
+      return false;
+    }
+  } else {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      ++stats_.misses;
+    }
+    if (!verifier_->Verify(payload, audit.signature(), audit.public_key())) {
+      std::lock_guard<std::mutex> lk(mu_);
+      ++stats_.failures;
+      return false;
+    }
+  }
+  insert(std::move(key));
+  return true;
+}
+
+bool VerifiedAuditCache::VerifyEnvelope(
+    const std::string& root,
+    const std::string& signature,
+    const std::string& public_key)
+{
+  // NUL, root, NUL, digest of signature + key: never an audit's key, whose
+  // 64 digest bytes follow a single NUL
+  unsigned char md[SHA256_DIGEST_LENGTH];
+  thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>
+    ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+  EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
+  EVP_DigestUpdate(ctx.get(), signature.data(), signature.size());
+  EVP_DigestUpdate(ctx.get(), public_key.data(), public_key.size());
+  EVP_DigestFinal_ex(ctx.get(), md, nullptr);
+  std::string key(1, '\0');
+  key.append(root);
+  key.push_back('\0');
+  key.append(reinterpret_cast<char*>(md), sizeof(md));
+  if (lookup(key)) return true;
+
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    ++stats_.misses;
+  }
+  if (!verifier_->Verify(root, signature, public_key)) {
+    std::lock_guard<std::mutex> lk(mu_);
+    ++stats_.failures;
+    return false;
+  }
+  insert(std::move(key));
+  return true;
+}
+
+bool VerifiedAuditCache::lookup(const std::string& key) {
+  std::lock_guard<std::mutex> lk(mu_);
+  auto it = index_.find(key);
+  if (it == index_.end()) return false;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  ++stats_.hits;
+  return true;
+}
+
+void VerifiedAuditCache::insert(std::string key) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (index_.count(key)) return;   // verified concurrently
+  lru_.push_front(std::move(key));
+  index_[lru_.front()] = lru_.begin();
+  if (lru_.size() > capacity_) {
+    index_.erase(lru_.back());
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+}
+
+size_t VerifiedAuditCache::VerifyBatch(
+    const google::protobuf::RepeatedPtrField<common::FileAudit>& audits,
+    const std::vector<std::string>* payloads)
+{
+  auto check = [&](size_t i) {
+    return payloads ? Verify(audits[i], (*payloads)[i]) : Verify(audits[i]);
+  };
+  size_t n = audits.size();
+  if (!pool_ || n < kParallelMin) {
+    for (size_t i = 0; i < n; ++i) {
+      if (!check(i)) return i;
+    }
+    return n;
+  }
+  return pool_->ParallelAll(n, check, kGrain);
+}
+
+std::vector<const common::FileAudit*> VerifiedAuditCache::ValidAudits(
+    const google::protobuf::RepeatedPtrField<common::FileAudit>& audits,
+    std::vector<std::string>* rejected) {
+  // Only if some audit is bad, sort them out one by one (the good ones
+  // are cached by now)
+  bool all_ok = VerifyBatch(audits) == static_cast<size_t>(audits.size());
+  std::vector<const common::FileAudit*> ok;
+  ok.reserve(audits.size());
+  for (auto& a : audits) {
+    if (all_ok || Verify(a)) {
+      ok.push_back(&a);
+    } else if (rejected) {
+      rejected->push_back(a.req_id());
+    }
+  }
+  return ok;
+}
+
+VerifiedAuditCache::Stats VerifiedAuditCache::GetStats() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  Stats s = stats_;
+  s.size  = lru_.size();
+  return s;
+}
@@ -0,0 +1,97 @@
+// src/worker_pool.cpp
+
+#include "worker_pool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t threads) {
+  if (threads == 0) {
+    size_t hw = std::thread::hardware_concurrency();
+    threads = hw > 1 ? hw - 1 : 1;
+  }
+  threads_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back(&WorkerPool::loop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& t : threads_) t.join();
+}
+
+// Claim chunks of `job` until it is exhausted or something failed.
+void WorkerPool::run(Job& job) {
+  for (;;) {
+    if (job.failed.load(std::memory_order_relaxed) != job.n) return;
+    size_t begin = job.next.fetch_add(job.grain);
+    if (begin >= job.n) return;
+    size_t end = std::min(begin + job.grain, job.n);
+    for (size_t i = begin; i < end; ++i) {
+      if (!(*job.fn)(i)) {
+        size_t expected = job.n;
+        job.failed.compare_exchange_strong(expected, i);
+        return;
+      }
+    }
+  }
+}
+
+void WorkerPool::loop() {
+  std::unique_lock<std::mutex> lk(mu_);
+  for (;;) {
+    work_cv_.wait(lk, [&]{ return stopping_ || !jobs_.empty(); });
+    if (stopping_) return;
+
+    auto job = jobs_.front();
+    ++job->active;
+    lk.unlock();
+    run(*job);
+    lk.lock();
+
+    // Nothing left to claim: retire the job so workers move on
+    auto it = std::find(jobs_.begin(), jobs_.end(), job);
+    if (it != jobs_.end()) jobs_.erase(it);
+    if (--job->active == 0) done_cv_.notify_all();
+  }
+}
+
+size_t WorkerPool::ParallelAll(
+    size_t n,
+    const std::function<bool(size_t)>& fn,
+    size_t grain
+) {
+  if (n == 0) return 0;
+  auto job    = std::make_shared<Job>();
+  job->fn     = &fn;
+  job->n      = n;
+  job->grain  = std::max<size_t>(grain, 1);
+  job->failed = n;
+
+  if (n > job->grain) {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      jobs_.push_back(job);
+    }
+    work_cv_.notify_all();
+  }
+
+  run(*job);
+
+  std::unique_lock<std::mutex> lk(mu_);
+  auto it = std::find(jobs_.begin(), jobs_.end(), job);
+  if (it != jobs_.end()) jobs_.erase(it);
+  done_cv_.wait(lk, [&]{ return job->active == 0; });
+  return job->failed.load();
+}
+
+void WorkerPool::ParallelFor(
+    size_t n,
+    const std::function<void(size_t)>& fn,
+    size_t grain
+) {
+  ParallelAll(n, [&](size_t i) { fn(i); return true; }, grain);
+}
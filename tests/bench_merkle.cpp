@@ -0,0 +1,93 @@
+// bench_merkle.cpp
+//
+// Compares the hex-string reference ComputeMerkleRoot with the digest
+// engine in hex-compatible and binary modes, and checks that the
+// compatible mode reproduces the reference root. Also compares hashing a
+// block through one concatenated header string with Sha256Stream.
+//
+//   ./bench_merkle [max_leaves]
+
+#include "merkle_tree.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+template <typename Fn>
+static double TimeMs(int reps, Fn fn) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r) fn();
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(t1 - t0).count() / reps;
+}
+
+int main(int argc, char** argv) {
+  size_t max_leaves = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+
+  // Leaves as the block code produces them: SHA-256 of a payload
+  std::vector<Digest>      digests;
+  std::vector<std::string> hexes;
+  for (size_t i = 0; i < max_leaves; ++i) {
+    std::string payload = "{\"req_id\":\"bench-" + std::to_string(i) + "\"}";
+    digests.push_back(SHA256Digest(payload.data(), payload.size()));
+    hexes.push_back(DigestToHex(digests.back()));
+  }
+
+  // Compatible mode must match the reference for every shape of tree
+  for (size_t n = 0; n <= 70 && n <= max_leaves; ++n) {
+    std::vector<std::string> h(hexes.begin(), hexes.begin() + n);
+    std::vector<Digest>      d(digests.begin(), digests.begin() + n);
+    assert(ComputeMerkleRoot(d, MerkleMode::kHexCompat) == ComputeMerkleRoot(h));
+    if (n >= 2) {
+      assert(ComputeMerkleRoot(d, MerkleMode::kBinary) != ComputeMerkleRoot(h));
+    }
+  }
+
+  std::printf("%10s %14s %14s %14s %9s %9s\n", "leaves", "reference ms",
+              "hex-compat ms", "binary ms", "compat x", "binary x");
+  for (size_t n = 1000; n <= max_leaves; n *= 10) {
+    std::vector<std::string> h(hexes.begin(), hexes.begin() + n);
+    std::vector<Digest>      d(digests.begin(), digests.begin() + n);
+    int reps = n <= 10000 ? 20 : 3;
+
+    std::string ref, compat, binary;
+    double t_ref    = TimeMs(reps, [&]{ ref = ComputeMerkleRoot(h); });
+    double t_compat = TimeMs(reps, [&]{
+      compat = ComputeMerkleRoot(d, MerkleMode::kHexCompat);
+    });
+    double t_binary = TimeMs(reps, [&]{
+      binary = ComputeMerkleRoot(d, MerkleMode::kBinary);
+    });
+    assert(ref == compat);
+
+    std::printf("%10zu %14.2f %14.2f %14.2f %8.1fx %8.1fx\n", n, t_ref,
+                t_compat, t_binary, t_ref / t_compat, t_ref / t_binary);
+  }
+
+  // Block hash: id + previous_hash + merkle_root + every audit payload
+  std::vector<std::string> payloads;
+  for (size_t i = 0; i < max_leaves; ++i) {
+    payloads.push_back("{\"access_type\":1,\"file_info\":{\"file_id\":\"f" +
+                       std::to_string(i) + "\"},\"req_id\":\"bench-" +
+                       std::to_string(i) + "\"}");
+  }
+  const std::string prev = hexes[0], root = hexes[max_leaves - 1];
+  std::string joined, streamed;
+  double t_join = TimeMs(3, [&]{
+    std::string header = std::to_string(max_leaves) + prev + root;
+    for (auto& p : payloads) header += p;
+    joined = SHA256Hex(header);
+  });
+  double t_stream = TimeMs(3, [&]{
+    Sha256Stream hasher;
+    hasher.Update(std::to_string(max_leaves)).Update(prev).Update(root);
+    for (auto& p : payloads) hasher.Update(p);
+    streamed = hasher.FinalHex();
+  });
+  assert(joined == streamed);
+  std::printf("block hash over %zu audits: header string %.2f ms, "
+              "streamed %.2f ms\n", max_leaves, t_join, t_stream);
+  return 0;
+}
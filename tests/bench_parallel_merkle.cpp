@@ -0,0 +1,83 @@
+// bench_parallel_merkle.cpp
+//
+// How block Merkle construction scales with threads: hashing the leaves
+// from their payloads (as BlockMerkleRoot does for audits it hasn't
+// cached) plus building the root, with 1 (serial) to N threads. Every
+// parallel root is checked against the serial one.
+//
+//   ./bench_parallel_merkle [leaves] [max_threads]
+
+#include "parallel_merkle.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+template <typename Fn>
+static double TimeMs(int reps, Fn fn) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r) fn();
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(t1 - t0).count() / reps;
+}
+
+int main(int argc, char** argv) {
+  size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+  size_t max_threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                                : std::thread::hardware_concurrency();
+  if (max_threads == 0) max_threads = 1;
+  const int reps = 5;
+
+  // Payloads about the size of a canonical audit
+  std::vector<std::string> payloads;
+  for (size_t i = 0; i < n; ++i) {
+    payloads.push_back("{\"req_id\":\"bench-" + std::to_string(i) +
+                       "\",\"file_info\":{\"file_id\":\"f\",\"file_name\":"
+                       "\"report.pdf\"},\"user_info\":{\"user_id\":\"u1\"}}");
+  }
+
+  std::printf("%d hardware threads, %zu leaves\n",
+              static_cast<int>(std::thread::hardware_concurrency()), n);
+  std::printf("%8s %8s %12s %12s %12s %9s\n", "mode", "threads", "leaves ms",
+              "tree ms", "total ms", "speedup");
+  for (MerkleMode mode : {MerkleMode::kHexCompat, MerkleMode::kBinary}) {
+    std::vector<Digest> leaves(n);
+    std::string serial;
+    double base = 0;
+    for (size_t t = 1; t <= max_threads; t *= 2) {
+      // The caller is one of the t threads
+      std::unique_ptr<WorkerPool> pool;
+      if (t > 1) pool = std::make_unique<WorkerPool>(t - 1);
+
+      double t_leaves = TimeMs(reps, [&]{
+        auto hash = [&](size_t i) {
+          leaves[i] = SHA256Digest(payloads[i].data(), payloads[i].size());
+        };
+        if (pool) {
+          pool->ParallelFor(n, hash, 64);
+        } else {
+          for (size_t i = 0; i < n; ++i) hash(i);
+        }
+      });
+      std::string root;
+      double t_tree = TimeMs(reps, [&]{
+        root = ParallelMerkleRoot(leaves, mode, pool.get());
+      });
+
+      if (t == 1) {
+        serial = root;
+        base   = t_leaves + t_tree;
+      }
+      assert(root == serial);
+      std::printf("%8s %8zu %12.2f %12.2f %12.2f %8.2fx\n",
+                  mode == MerkleMode::kBinary ? "binary" : "hex", t, t_leaves,
+                  t_tree, t_leaves + t_tree, base / (t_leaves + t_tree));
+      if (t < max_threads && t * 2 > max_threads) t = max_threads / 2;
+    }
+  }
+  return 0;
+}
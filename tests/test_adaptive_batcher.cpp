@@ -0,0 +1,86 @@
+// test_adaptive_batcher.cpp
+
+#include "adaptive_batcher.h"
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace std::chrono;
+
+// Feed `per_ms` arrivals every millisecond for `ms` milliseconds.
+static void Feed(AdaptiveBatcher& b, uint64_t& total,
+                 steady_clock::time_point& now, double per_ms, int ms) {
+  for (int i = 0; i < ms / 10; ++i) {
+    now   += milliseconds(10);
+    total += static_cast<uint64_t>(per_ms * 10);
+    b.ObserveArrivals(total, now);
+  }
+}
+
+// Feed rounds following fixed_ms + per_audit_ms * n.
+static void Rounds(AdaptiveBatcher& b, double fixed_ms, double per_audit_ms) {
+  for (int i = 0; i < 40; ++i) {
+    size_t n = 50 + 50 * (i % 4);
+    double t = fixed_ms + per_audit_ms * n;
+    b.ObserveRound(n, duration_cast<steady_clock::duration>(
+                          duration<double, std::milli>(t)));
+  }
+}
+
+int main() {
+  AdaptiveBatchOptions opts;
+  opts.target_latency_ms = 150;
+  opts.min_batch         = 1;
+  opts.max_batch         = 1000;
+  opts.min_linger_ms     = 5;
+  opts.max_linger_ms     = 1000;
+
+  // 1) Idle: cut on the first audit, linger for the whole target
+  {
+    AdaptiveBatcher b(opts);
+    assert(b.BatchSize() == 1);
+    assert(b.Linger() == milliseconds(150));
+    std::cout << "[Test] Idle defaults OK\n";
+  }
+
+  // 2) Steady arrivals, no round data yet: batch = rate * target
+  AdaptiveBatcher b(opts);
+  uint64_t total = 0;
+  auto now = steady_clock::now();
+  b.ObserveArrivals(total, now);
+  Feed(b, total, now, 1.0, 10000);
+  auto st = b.GetStats();
+  assert(std::abs(st.arrival_rate_per_s - 1000.0) < 10.0);
+  assert(b.BatchSize() >= 148 && b.BatchSize() <= 151);
+  std::cout << "[Test] Arrival rate OK\n";
+
+  // 3) Round model fitted from varying block sizes
+  Rounds(b, 10.0, 0.1);
+  st = b.GetStats();
+  assert(std::abs(st.fixed_ms - 10.0) < 0.5);
+  assert(std::abs(st.per_audit_ms - 0.1) < 0.005);
+  // linger + 10 + 0.1 * linger == 150  ->  linger ~ 127ms, batch ~ 128
+  assert(b.Linger() >= milliseconds(125) && b.Linger() <= milliseconds(128));
+  assert(b.BatchSize() >= 125 && b.BatchSize() <= 130);
+  std::cout << "[Test] Round model OK\n";
+
+  // 4) A burst shrinks linger but grows the batch, capped at max_batch
+  Feed(b, total, now, 5.0, 10000);
+  assert(b.Linger() < milliseconds(127));
+  assert(b.BatchSize() > 128);
+  Feed(b, total, now, 20.0, 10000);   // 20/ms * 0.1ms/audit: can't keep up
+  assert(b.BatchSize() == opts.max_batch);
+  std::cout << "[Test] Burst OK\n";
+
+  // 5) Back to idle: linger bounded by max_linger, batch by min_batch
+  Feed(b, total, now, 0.0, 20000);
+  assert(b.BatchSize() <= 2);
+  assert(b.Linger() <= milliseconds(opts.max_linger_ms));
+  st = b.GetStats();
+  assert(st.rounds == 40);
+  std::cout << "[Test] Decay OK\n";
+
+  std::cout << "🎉 All AdaptiveBatcher tests passed\n";
+  return 0;
+}
@@ -0,0 +1,301 @@
+// test_block_broadcaster.cpp
+
+#include "block_broadcaster.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+// A peer that votes as told, optionally slowly, and logs what it received
+class FakePeer final : public blockchain::BlockChainService::Service {
+public:
+  bool         vote     = true;
+  milliseconds delay{0};
+  bool         compact  = true;    // serve the compact RPCs
+  bool         rebuild  = true;    // can rebuild compact blocks
+  bool         forget   = false;   // loses voted blocks before the commit
+  std::set<std::string> lacks;     // req_ids not in this peer's mempool
+
+  std::atomic<int> full_proposals{0};
+  std::atomic<int> full_commits{0};
+  std::atomic<int> prefilled{0};
+
+  grpc::Status ProposeBlock(grpc::ServerContext*, const blockchain::Block* b,
+                            blockchain::BlockVoteResponse* resp) override {
+    ++full_proposals;
+    return castVote(b->id(), resp);
+  }
+
+  grpc::Status ProposeCompactBlock(grpc::ServerContext*,
+                                   const blockchain::CompactBlock* b,
+                                   blockchain::BlockVoteResponse* resp) override {
+    if (!compact) return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "");
+    std::set<std::string> sent;
+    for (auto& a : b->audits()) sent.insert(a.req_id());
+    prefilled += b->audits_size();
+    for (auto& id : b->req_ids()) {
+      if (lacks.count(id) && !sent.count(id)) resp->add_missing_req_ids(id);
+    }
+    if (resp->missing_req_ids_size() > 0) {
+      resp->set_status("missing");
+      return grpc::Status::OK;
+    }
+    if (!rebuild) {
+      resp->set_status("full_required");
+      return grpc::Status::OK;
+    }
+    return castVote(b->id(), resp);
+  }
+
+  grpc::Status CommitBlock(grpc::ServerContext*, const blockchain::Block* b,
+                           blockchain::BlockCommitResponse* resp) override {
+    ++full_commits;
+    record("C" + std::to_string(b->id()));
+    resp->set_status("success");
+    return grpc::Status::OK;
+  }
+
+  grpc::Status ConfirmBlock(grpc::ServerContext*,
+                            const blockchain::BlockCommitRef* ref,
+                            blockchain::BlockCommitResponse* resp) override {
+    if (!compact) return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "");
+    if (forget) {
+      resp->set_status("unknown_block");
+      return grpc::Status::OK;
+    }
+    record("C" + std::to_string(ref->id()));
+    resp->set_status("success");
+    return grpc::Status::OK;
+  }
+
+  std::vector<std::string> Log() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return log_;
+  }
+
+private:
+  grpc::Status castVote(int64_t id, blockchain::BlockVoteResponse* resp) {
+    std::this_thread::sleep_for(delay);
+    record("P" + std::to_string(id));
+    resp->set_vote(vote);
+    resp->set_status(vote ? "success" : "failure");
+    if (!vote) resp->set_error_message("no");
+    return grpc::Status::OK;
+  }
+
+  void record(std::string e) {
+    std::lock_guard<std::mutex> lk(mu_);
+    log_.push_back(std::move(e));
+  }
+  std::mutex               mu_;
+  std::vector<std::string> log_;
+};
+
+struct Cluster {
+  std::vector<std::unique_ptr<FakePeer>>     peers;
+  std::vector<std::unique_ptr<grpc::Server>> servers;
+  BlockBroadcaster::StubList                 stubs;
+
+  // `dead` extra stubs point at a port nobody listens on
+  explicit Cluster(size_t live, size_t dead = 0) {
+    for (size_t i = 0; i < live; ++i) {
+      peers.push_back(std::make_unique<FakePeer>());
+      int port = 0;
+      grpc::ServerBuilder b;
+      b.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(),
+                         &port);
+      b.RegisterService(peers.back().get());
+      servers.push_back(b.BuildAndStart());
+      stubs.push_back(blockchain::BlockChainService::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(port),
+                            grpc::InsecureChannelCredentials())));
+    }
+    for (size_t i = 0; i < dead; ++i) {
+      stubs.push_back(blockchain::BlockChainService::NewStub(
+        grpc::CreateChannel("127.0.0.1:1", grpc::InsecureChannelCredentials())));
+    }
+  }
+  ~Cluster() {
+    for (auto& s : servers) s->Shutdown();
+  }
+};
+
+static std::shared_ptr<const blockchain::Block> MakeBlock(int64_t id) {
+  auto b = std::make_shared<blockchain::Block>();
+  b->set_id(id);
+  b->set_hash("h" + std::to_string(id));
+  return b;
+}
+
+static std::shared_ptr<const blockchain::Block> MakeBlock(
+    int64_t id, const std::vector<std::string>& req_ids) {
+  auto b = std::make_shared<blockchain::Block>(*MakeBlock(id));
+  for (auto& r : req_ids) b->add_audits()->set_req_id(r);
+  return b;
+}
+
+// Wait for a peer to log `n` entries
+static std::vector<std::string> WaitLog(FakePeer& p, size_t n) {
+  auto until = steady_clock::now() + seconds(5);
+  while (p.Log().size() < n && steady_clock::now() < until) {
+    std::this_thread::sleep_for(milliseconds(5));
+  }
+  return p.Log();
+}
+
+int main() {
+  const milliseconds kPropose(500), kCommit(1000);
+
+  // 1) Quorum sizes: a majority of peers + this node
+  {
+    Cluster c(0);
+    BlockBroadcaster bc(c.stubs, kPropose, kCommit);
+    assert(bc.Quorum() == 0);
+    assert(bc.Propose(MakeBlock(1)));
+  }
+  {
+    Cluster c(2);
+    assert(BlockBroadcaster(c.stubs, kPropose, kCommit).Quorum() == 1);
+    Cluster d(4);
+    assert(BlockBroadcaster(d.stubs, kPropose, kCommit).Quorum() == 2);
+  }
+  std::cout << "[Test] quorum OK\n";
+
+  // 2) Every peer sees propose/commit in order, commits don't block
+  {
+    Cluster c(3);
+    BlockBroadcaster bc(c.stubs, kPropose, kCommit);
+    for (int64_t id = 1; id <= 5; ++id) {
+      auto b = MakeBlock(id);
+      assert(bc.Propose(b));
+      bc.Commit(b);
+    }
+    for (auto& p : c.peers) {
+      auto log = WaitLog(*p, 10);
+      assert(log.size() == 10);
+      for (int64_t id = 1; id <= 5; ++id) {
+        assert(log[2*(id-1)]     == "P" + std::to_string(id));
+        assert(log[2*(id-1) + 1] == "C" + std::to_string(id));
+      }
+    }
+  }
+  std::cout << "[Test] ordered fan-out OK\n";
+
+  // 3) Dead and slow peers don't hold up a majority
+  {
+    Cluster c(3, 2);              // quorum 3 of 5 peers
+    c.peers[2]->delay = milliseconds(2000);
+    BlockBroadcaster bc(c.stubs, kPropose, kCommit);
+    auto t0 = steady_clock::now();
+    // Only 2 fast yes votes: out of reach once the dead peers fail
+    bool ok = bc.Propose(MakeBlock(1));
+    assert(!ok);
+    assert(steady_clock::now() - t0 < kPropose + milliseconds(200));
+
+    Cluster d(3, 1);              // quorum 2 of 4 peers
+    d.peers[2]->delay = milliseconds(2000);
+    BlockBroadcaster bd(d.stubs, kPropose, kCommit);
+    t0 = steady_clock::now();
+    assert(bd.Propose(MakeBlock(1)));
+    assert(steady_clock::now() - t0 < milliseconds(300));
+  }
+  std::cout << "[Test] dead/slow peers OK\n";
+
+  // 4) Early reject once enough peers vote no; commits only to yes voters
+  {
+    Cluster c(4);                 // quorum 2
+    c.peers[0]->vote  = false;
+    c.peers[1]->vote  = false;
+    c.peers[2]->vote  = false;
+    c.peers[3]->delay = milliseconds(2000);
+    BlockBroadcaster bc(c.stubs, kPropose, kCommit);
+    auto t0 = steady_clock::now();
+    assert(!bc.Propose(MakeBlock(1)));
+    assert(steady_clock::now() - t0 < milliseconds(300));
+
+    Cluster d(2);                 // quorum 1
+    d.peers[1]->vote = false;
+    BlockBroadcaster bd(d.stubs, kPropose, kCommit);
+    auto b = MakeBlock(7);
+    assert(bd.Propose(b));
+    bd.Commit(b);
+    assert((WaitLog(*d.peers[0], 2) == std::vector<std::string>{"P7", "C7"}));
+    std::this_thread::sleep_for(milliseconds(100));
+    assert((d.peers[1]->Log() == std::vector<std::string>{"P7"}));
+  }
+  std::cout << "[Test] early reject / yes-only commits OK\n";
+
+  // 5) A window lets proposals overlap; commits still follow every
+  //    earlier call on the lane
+  {
+    Cluster c(2);
+    for (auto& p : c.peers) p->delay = milliseconds(100);
+    BlockBroadcaster bc(c.stubs, kPropose, kCommit, 3);
+    std::vector<std::shared_ptr<const blockchain::Block>> blocks;
+    std::vector<std::shared_ptr<BlockBroadcaster::Ballot>> ballots;
+    auto t0 = steady_clock::now();
+    for (int64_t id = 1; id <= 3; ++id) {
+      blocks.push_back(MakeBlock(id));
+      ballots.push_back(bc.StartProposal(blocks.back()));
+    }
+    for (auto& b : ballots) assert(b->Wait());
+    assert(steady_clock::now() - t0 < milliseconds(250));
+    for (auto& b : blocks) bc.Commit(b);
+    for (auto& p : c.peers) {
+      auto log = WaitLog(*p, 6);
+      assert((std::vector<std::string>(log.begin() + 3, log.end()) ==
+              std::vector<std::string>{"C1", "C2", "C3"}));
+    }
+  }
+  std::cout << "[Test] pipelined window OK\n";
+
+  // 6) Compact proposals: missing audits are sent once, peers that can't
+  //    rebuild or don't know the RPCs get full blocks
+  {
+    Cluster c(5);
+    c.peers[1]->lacks   = {"r2"};
+    c.peers[2]->rebuild = false;
+    c.peers[3]->compact = false;
+    c.peers[4]->forget  = true;
+    BlockBroadcaster bc(c.stubs, kPropose, kCommit);
+    auto b = MakeBlock(1, {"r1", "r2", "r3"});
+    assert(bc.Propose(b));
+    bc.Commit(b);
+    for (auto& p : c.peers) {
+      assert((WaitLog(*p, 2) == std::vector<std::string>{"P1", "C1"}));
+    }
+    assert(c.peers[0]->full_proposals == 0 && c.peers[0]->full_commits == 0);
+    assert(c.peers[0]->prefilled == 0);
+    assert(c.peers[1]->full_proposals == 0 && c.peers[1]->prefilled == 1);
+    assert(c.peers[2]->full_proposals == 1 && c.peers[2]->full_commits == 0);
+    assert(c.peers[3]->full_proposals == 1 && c.peers[3]->full_commits == 1);
+    assert(c.peers[4]->full_proposals == 0 && c.peers[4]->full_commits == 1);
+
+    // A peer found lacking the RPCs stays on full blocks
+    auto b2 = MakeBlock(2, {"r4"});
+    assert(bc.Propose(b2));
+    bc.Commit(b2);
+    WaitLog(*c.peers[3], 4);
+    assert(c.peers[3]->full_proposals == 2 && c.peers[3]->full_commits == 2);
+
+    // Compact off: always full blocks
+    Cluster d(1);
+    BlockBroadcaster bd(d.stubs, kPropose, kCommit, 1, false);
+    auto b3 = MakeBlock(3, {"r5"});
+    assert(bd.Propose(b3));
+    bd.Commit(b3);
+    WaitLog(*d.peers[0], 2);
+    assert(d.peers[0]->full_proposals == 1 && d.peers[0]->full_commits == 1);
+  }
+  std::cout << "[Test] compact proposals OK\n";
+
+  std::cout << "🎉 All BlockBroadcaster tests passed\n";
+  return 0;
+}
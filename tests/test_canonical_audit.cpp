@@ -0,0 +1,142 @@
+// test_canonical_audit.cpp
+
+#include "canonical_audit.h"
+#include <nlohmann/json.hpp>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+using ordered_json = nlohmann::ordered_json;
+
+// The ordered_json encoding every call site used before; the reference
+// the canonical encoder has to match byte for byte.
+static bool ReferenceEncode(const common::FileAudit& a, std::string* out) {
+  ordered_json j;
+  j["access_type"] = a.access_type();
+  j["file_info"]   = {{"file_id",   a.file_info().file_id()},
+                      {"file_name", a.file_info().file_name()}};
+  j["req_id"]      = a.req_id();
+  j["timestamp"]   = a.timestamp();
+  j["user_info"]   = {{"user_id",   a.user_info().user_id()},
+                      {"user_name", a.user_info().user_name()}};
+  try {
+    *out = j.dump();
+    return true;
+  } catch (const nlohmann::json::type_error&) {
+    return false;   // invalid UTF-8
+  }
+}
+
+static common::FileAudit MakeAudit(const std::vector<std::string>& f,
+                                   int access, int64_t ts) {
+  common::FileAudit a;
+  a.set_req_id(f[0]);
+  a.mutable_file_info()->set_file_id(f[1]);
+  a.mutable_file_info()->set_file_name(f[2]);
+  a.mutable_user_info()->set_user_id(f[3]);
+  a.mutable_user_info()->set_user_name(f[4]);
+  a.set_access_type(static_cast<common::AccessType>(access));
+  a.set_timestamp(ts);
+  a.set_signature("sig-not-encoded");
+  a.set_public_key("key-not-encoded");
+  return a;
+}
+
+// Returns true if both encoders agree (same bytes, or both reject).
+static bool Same(const common::FileAudit& a) {
+  std::string ref, got;
+  bool ref_ok = ReferenceEncode(a, &ref);
+  bool got_ok = AppendCanonicalAudit(a, &got);
+  if (ref_ok != got_ok) return false;
+  if (!ref_ok) return CanonicalAudit(a).empty();
+  return ref == got && CanonicalAudit(a) == ref;
+}
+
+int main() {
+  // 1) Typical audit
+  auto a = MakeAudit({"smoke1", "file123", "important.docx", "user42", "alice"},
+                     common::READ, 1746000000000);
+  assert(Same(a));
+  assert(CanonicalAudit(a) ==
+    R"({"access_type":1,"file_info":{"file_id":"file123","file_name":"important.docx"},)"
+    R"("req_id":"smoke1","timestamp":1746000000000,"user_info":{"user_id":"user42","user_name":"alice"}})");
+  std::cout << "[Test] Typical audit OK\n";
+
+  // 2) Every ASCII byte, alone and inside text
+  for (int c = 0; c < 0x80; ++c) {
+    std::string ch(1, static_cast<char>(c));
+    assert(Same(MakeAudit({ch, "a" + ch + "b", ch + ch, "", "x" + ch}, 2, -1)));
+  }
+  std::cout << "[Test] ASCII escaping OK\n";
+
+  // 3) Integer edge cases and out-of-range enum values
+  for (int64_t ts : {int64_t{0}, int64_t{-1}, int64_t{9},
+                     std::numeric_limits<int64_t>::min(),
+                     std::numeric_limits<int64_t>::max()}) {
+    for (int access : {0, 4, 99, -7}) {
+      assert(Same(MakeAudit({"r", "f", "n", "u", "v"}, access, ts)));
+    }
+  }
+  std::cout << "[Test] Integers OK\n";
+
+  // 4) Valid multi-byte UTF-8 passes through unescaped
+  const std::vector<std::string> utf8 = {
+    "\xC3\xA9", "\xE4\xB8\xAD\xE6\x96\x87", "\xF0\x9F\x98\x80",
+    "\xEF\xBF\xBF", "\xEE\x80\x80", "\xF4\x8F\xBF\xBF", "\xC2\x80",
+  };
+  for (auto& s : utf8) {
+    assert(Same(MakeAudit({s, s + "\n", "\"" + s, s + s, "\\"}, 1, 5)));
+  }
+  std::cout << "[Test] UTF-8 OK\n";
+
+  // 5) Malformed UTF-8 is rejected exactly when the reference rejects it
+  const std::vector<std::string> bad = {
+    "\x80", "\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF", "\xED\xA0\x80",
+    "\xF0\x80\x80\xAF", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFF",
+    "\xC3", "\xE4\xB8", "\xF0\x9F\x98", "ok\xC3(",
+  };
+  for (auto& s : bad) {
+    assert(Same(MakeAudit({"r", s, "n", "u", "v"}, 1, 5)));
+    assert(Same(MakeAudit({"r", "f", "n", "u", "end" + s}, 1, 5)));
+  }
+  std::cout << "[Test] Malformed UTF-8 OK\n";
+
+  // 6) Random fields: printable-heavy, control-heavy and raw bytes
+  std::mt19937_64 rng(42);
+  auto randomString = [&](int mode) {
+    std::string s(rng() % 24, '\0');
+    for (auto& ch : s) {
+      uint64_t r = rng();
+      if (mode == 0)      ch = static_cast<char>(0x20 + r % 0x5F);
+      else if (mode == 1) ch = static_cast<char>(r % 0x80);
+      else                ch = static_cast<char>(r & 0xFF);
+    }
+    if (mode == 1 && rng() % 3 == 0) s += utf8[rng() % utf8.size()];
+    return s;
+  };
+  size_t rejected = 0;
+  for (int i = 0; i < 20000; ++i) {
+    int mode = i % 3;
+    std::vector<std::string> f;
+    for (int k = 0; k < 5; ++k) f.push_back(randomString(mode));
+    auto r = MakeAudit(f, static_cast<int>(rng() % 6),
+                       static_cast<int64_t>(rng()));
+    assert(Same(r));
+    if (CanonicalAudit(r).empty()) ++rejected;
+  }
+  assert(rejected > 0);
+  std::cout << "[Test] Random equivalence OK (" << rejected
+            << " invalid UTF-8 cases)\n";
+
+  // 7) Appends to an existing buffer without clearing it
+  std::string buf = "prefix";
+  assert(AppendCanonicalAudit(a, &buf));
+  assert(buf == "prefix" + CanonicalAudit(a));
+  std::cout << "[Test] Append OK\n";
+
+  std::cout << "🎉 All canonical audit tests passed\n";
+  return 0;
+}
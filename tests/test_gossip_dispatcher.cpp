@@ -0,0 +1,242 @@
+// test_gossip_dispatcher.cpp
+
+#include "gossip_dispatcher.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+// A peer that records the audits it is whispered, optionally failing the
+// first few calls, stalling, or lacking the batch RPC
+class FakePeer final : public blockchain::BlockChainService::Service {
+public:
+  bool             batch_rpc = true;
+  milliseconds     delay{0};
+  std::atomic<int> fail_first{0};
+  std::atomic<int> calls{0};
+  std::atomic<int> max_batch{0};
+
+  grpc::Status WhisperAuditBatch(grpc::ServerContext*,
+                                 const blockchain::WhisperBatch* req,
+                                 blockchain::WhisperBatchResponse* resp) override {
+    if (!batch_rpc) return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "");
+    ++calls;
+    if (fail_first.fetch_sub(1) > 0) {
+      return grpc::Status(grpc::StatusCode::UNAVAILABLE, "not yet");
+    }
+    std::this_thread::sleep_for(delay);
+    max_batch = std::max<int>(max_batch, req->audits_size());
+    for (auto& a : req->audits()) record(a.req_id());
+    resp->set_status("success");
+    resp->set_accepted(req->audits_size());
+    return grpc::Status::OK;
+  }
+
+  grpc::Status WhisperAuditRequest(grpc::ServerContext*,
+                                   const common::FileAudit* a,
+                                   blockchain::WhisperResponse* resp) override {
+    ++calls;
+    record(a->req_id());
+    resp->set_status("success");
+    return grpc::Status::OK;
+  }
+
+  std::vector<std::string> Got() {
+    std::lock_guard<std::mutex> lk(mu_);
+    return got_;
+  }
+
+private:
+  void record(std::string id) {
+    std::lock_guard<std::mutex> lk(mu_);
+    got_.push_back(std::move(id));
+  }
+  std::mutex               mu_;
+  std::vector<std::string> got_;
+};
+
+struct Peers {
+  std::vector<std::unique_ptr<FakePeer>>     peers;
+  std::vector<std::unique_ptr<grpc::Server>> servers;
+  std::vector<std::string>                   addrs;
+
+  explicit Peers(size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      peers.push_back(std::make_unique<FakePeer>());
+      int port = 0;
+      grpc::ServerBuilder b;
+      b.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(),
+                         &port);
+      b.RegisterService(peers.back().get());
+      servers.push_back(b.BuildAndStart());
+      addrs.push_back("127.0.0.1:" + std::to_string(port));
+    }
+  }
+  ~Peers() {
+    for (auto& s : servers) s->Shutdown();
+  }
+};
+
+static common::FileAudit MakeAudit(int i) {
+  common::FileAudit a;
+  a.set_req_id("g" + std::to_string(i));
+  a.set_timestamp(i);
+  return a;
+}
+
+static std::vector<std::string> WaitGot(FakePeer& p, size_t n) {
+  auto until = steady_clock::now() + seconds(5);
+  while (p.Got().size() < n && steady_clock::now() < until) {
+    std::this_thread::sleep_for(milliseconds(5));
+  }
+  return p.Got();
+}
+
+int main() {
+  // 1) Queued audits are coalesced into batches and delivered in order
+  {
+    Peers c(2);
+    GossipOptions opts;
+    opts.max_batch = 100;
+    GossipDispatcher g(std::make_shared<PeerRegistry>(c.addrs), opts);
+    for (int i = 0; i < 250; ++i) g.Enqueue(MakeAudit(i));
+    g.start();
+    for (auto& p : c.peers) {
+      auto got = WaitGot(*p, 250);
+      assert(got.size() == 250);
+      for (int i = 0; i < 250; ++i) assert(got[i] == "g" + std::to_string(i));
+      assert(p->calls == 3 && p->max_batch == 100);
+    }
+    auto stats = g.GetStats();
+    assert(stats.size() == 2 && stats[0].addr == c.addrs[0]);
+    assert(stats[0].sent == 250 && stats[0].depth == 0);
+    assert(stats[0].dropped == 0 && stats[0].failures == 0);
+  }
+  std::cout << "[Test] batching OK\n";
+
+  // 2) Failed calls are retried with backoff without losing audits
+  {
+    Peers c(1);
+    c.peers[0]->fail_first = 3;
+    GossipOptions opts;
+    opts.min_backoff = milliseconds(10);
+    GossipDispatcher g(std::make_shared<PeerRegistry>(c.addrs), opts);
+    g.start();
+    for (int i = 0; i < 10; ++i) g.Enqueue(MakeAudit(i));
+    assert(WaitGot(*c.peers[0], 10).size() == 10);
+    auto s = g.GetStats()[0];
+    assert(s.failures == 3 && s.sent == 10 && s.depth == 0);
+  }
+  std::cout << "[Test] retry OK\n";
+
+  // 3) An unreachable peer's queue is bounded and doesn't hold up others
+  {
+    Peers c(1);
+    std::vector<std::string> addrs = {"127.0.0.1:1", c.addrs[0]};
+    GossipOptions opts;
+    opts.queue_limit = 5;
+    opts.rpc_timeout = milliseconds(100);
+    opts.min_backoff = milliseconds(10);
+    GossipDispatcher g(std::make_shared<PeerRegistry>(addrs), opts);
+    g.start();
+    for (int i = 0; i < 20; ++i) {
+      g.Enqueue(MakeAudit(i));
+      std::this_thread::sleep_for(milliseconds(2));
+    }
+    assert(WaitGot(*c.peers[0], 20).size() == 20);
+    auto dead = g.GetStats()[0];
+    assert(dead.depth == 5 && dead.dropped == 15 && dead.sent == 0);
+    assert(dead.failures >= 1);
+  }
+  std::cout << "[Test] bounded queue OK\n";
+
+  // 4) Enqueue never waits on a slow peer
+  {
+    Peers c(1);
+    c.peers[0]->delay = milliseconds(300);
+    GossipDispatcher g(std::make_shared<PeerRegistry>(c.addrs));
+    g.start();
+    auto t0 = steady_clock::now();
+    for (int i = 0; i < 100; ++i) g.Enqueue(MakeAudit(i));
+    assert(steady_clock::now() - t0 < milliseconds(50));
+    assert(WaitGot(*c.peers[0], 100).size() == 100);
+  }
+  std::cout << "[Test] non-blocking enqueue OK\n";
+
+  // 5) Peers without the batch RPC are whispered one audit at a time
+  {
+    Peers c(1);
+    c.peers[0]->batch_rpc = false;
+    GossipDispatcher g(std::make_shared<PeerRegistry>(c.addrs));
+    for (int i = 0; i < 4; ++i) g.Enqueue(MakeAudit(i));
+    g.start();
+    assert(WaitGot(*c.peers[0], 4).size() == 4);
+    assert(c.peers[0]->calls == 4);
+  }
+  std::cout << "[Test] single-audit fallback OK\n";
+
+  // 6) With a fanout each audit goes to that many random peers
+  {
+    Peers c(4);
+    GossipOptions opts;
+    opts.fanout = 2;
+    GossipDispatcher g(std::make_shared<PeerRegistry>(c.addrs), opts);
+    assert(g.Epidemic());
+    g.start();
+    for (int i = 0; i < 200; ++i) g.Enqueue(MakeAudit(i));
+    auto until = steady_clock::now() + seconds(5);
+    size_t total = 0;
+    while (steady_clock::now() < until) {
+      total = 0;
+      for (auto& p : c.peers) total += p->Got().size();
+      if (total >= 400) break;
+      std::this_thread::sleep_for(milliseconds(5));
+    }
+    assert(total == 400);
+    std::map<std::string, int> copies;
+    for (auto& p : c.peers) {
+      assert(!p->Got().empty());     // all peers get picked
+      for (auto& id : p->Got()) ++copies[id];
+    }
+    assert(copies.size() == 200);
+    for (auto& kv : copies) assert(kv.second == 2);
+
+    GossipOptions all;
+    all.fanout = 4;
+    assert(!GossipDispatcher(std::make_shared<PeerRegistry>(c.addrs), all)
+               .Epidemic());
+  }
+  std::cout << "[Test] epidemic fanout OK\n";
+
+  // 7) A peer marked down by another subsystem is left out of the fanout
+  {
+    Peers c(3);
+    auto reg = std::make_shared<PeerRegistry>(c.addrs);
+    reg->ReportFailure(0);
+    reg->ReportFailure(0);
+    assert(!reg->IsUp(0));
+    GossipOptions opts;
+    opts.fanout = 1;
+    GossipDispatcher g(reg, opts);
+    g.start();
+    for (int i = 0; i < 100; ++i) g.Enqueue(MakeAudit(i));
+    auto until = steady_clock::now() + seconds(5);
+    while (c.peers[1]->Got().size() + c.peers[2]->Got().size() < 100 &&
+           steady_clock::now() < until) {
+      std::this_thread::sleep_for(milliseconds(5));
+    }
+    assert(c.peers[1]->Got().size() + c.peers[2]->Got().size() == 100);
+    assert(c.peers[0]->Got().empty() && g.GetStats()[0].depth == 0);
+  }
+  std::cout << "[Test] down peers skipped OK\n";
+
+  std::cout << "🎉 All GossipDispatcher tests passed\n";
+  return 0;
+}
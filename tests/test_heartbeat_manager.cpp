@@ -0,0 +1,168 @@
+// test_heartbeat_manager.cpp
+
+#include "heartbeat_manager.h"
+#include "canonical_audit.h"
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+namespace fs = std::filesystem;
+
+static std::string PublicPem(EVP_PKEY* pkey) {
+  BIO* bio = BIO_new(BIO_s_mem());
+  PEM_write_bio_PUBKEY(bio, pkey);
+  BUF_MEM* mem;
+  BIO_get_mem_ptr(bio, &mem);
+  std::string pem(mem->data, mem->length);
+  BIO_free(bio);
+  return pem;
+}
+
+static std::string Sign(const std::string& data, EVP_PKEY* pkey) {
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, pkey);
+  EVP_DigestSignUpdate(ctx, data.data(), data.size());
+  size_t len = 0;
+  EVP_DigestSignFinal(ctx, nullptr, &len);
+  std::vector<unsigned char> sig(len);
+  EVP_DigestSignFinal(ctx, sig.data(), &len);
+  EVP_MD_CTX_free(ctx);
+
+  BIO* b64 = BIO_new(BIO_f_base64());
+  BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL);
+  BIO* mem = BIO_new(BIO_s_mem());
+  b64 = BIO_push(b64, mem);
+  BIO_write(b64, sig.data(), (int)len);
+  BIO_flush(b64);
+  BUF_MEM* bptr;
+  BIO_get_mem_ptr(b64, &bptr);
+  std::string out(bptr->data, bptr->length);
+  BIO_free_all(b64);
+  return out;
+}
+
+static common::FileAudit MakeAudit(const std::string& req_id, EVP_PKEY* pkey) {
+  common::FileAudit a;
+  a.set_req_id(req_id);
+  a.mutable_file_info()->set_file_id("f-" + req_id);
+  a.mutable_file_info()->set_file_name("file.txt");
+  a.mutable_user_info()->set_user_id("u1");
+  a.mutable_user_info()->set_user_name("alice");
+  a.set_access_type(common::WRITE);
+  a.set_timestamp(1700000000000);
+  a.set_signature(Sign(CanonicalAudit(a), pkey));
+  a.set_public_key(PublicPem(pkey));
+  return a;
+}
+
+// A peer that is one block ahead and serves it to whoever syncs
+class AheadPeer final : public blockchain::BlockChainService::Service {
+public:
+  explicit AheadPeer(blockchain::Block blk) : blk_(std::move(blk)) {}
+
+  grpc::Status SendHeartbeat(grpc::ServerContext*,
+                             const blockchain::HeartbeatRequest*,
+                             blockchain::HeartbeatResponse*) override {
+    return grpc::Status::OK;
+  }
+
+  grpc::Status GetBlock(grpc::ServerContext*,
+                        const blockchain::GetBlockRequest* req,
+                        blockchain::GetBlockResponse* resp) override {
+    if (req->id() != blk_.id()) {
+      resp->set_status("failure");
+      resp->set_error_message("no such block");
+      return grpc::Status::OK;
+    }
+    *resp->mutable_block() = blk_;
+    resp->set_status("success");
+    return grpc::Status::OK;
+  }
+
+private:
+  blockchain::Block blk_;
+};
+
+int main() {
+  // Synced blocks are written to "../blocks", relative to the cwd
+  const fs::path root = fs::absolute("test_heartbeat");
+  fs::remove_all(root);
+  fs::create_directories(root / "build");
+  fs::current_path(root / "build");
+
+  // 1) A follower that missed a commit prunes the block's audits from its
+  //    mempool once heartbeat sync brings the block in
+  {
+    EVP_PKEY* key = EVP_RSA_gen(2048);
+    blockchain::Block blk;
+    blk.set_id(0);
+    std::vector<Digest> leaves;
+    for (auto id : {"m1", "m2"}) {
+      auto& a = *blk.add_audits() = MakeAudit(id, key);
+      std::string payload = CanonicalAudit(a);
+      leaves.push_back(SHA256Digest(payload.data(), payload.size()));
+    }
+    blk.set_merkle_root(ComputeMerkleRoot(std::move(leaves),
+                                          MerkleMode::kHexCompat));
+    blk.set_hash("hash-0");
+
+    AheadPeer peer(blk);
+    int port = 0;
+    grpc::ServerBuilder b;
+    b.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(),
+                       &port);
+    b.RegisterService(&peer);
+    auto server = b.BuildAndStart();
+    std::string addr = "127.0.0.1:" + std::to_string(port);
+
+    // The whispered audits are pending, but the commit never arrived
+    auto mempool = std::make_shared<MempoolManager>("../mempool.dat");
+    mempool->Start();
+    std::string other_id = "pending";
+    for (auto& a : blk.audits()) assert(mempool->Append(a));
+    assert(mempool->Append(MakeAudit(other_id, key)));
+    assert(mempool->Size() == 3);
+
+    ChainManager chain("../chain.json");
+    ElectionState state;
+    auto table = std::make_shared<HeartbeatTable>(60);
+    table->update(addr, addr, 0, 0);
+    auto proofs = std::make_shared<AuditProofStore>("../blocks",
+                                                    MerkleMode::kHexCompat);
+    HeartbeatManager hb(
+      std::make_shared<PeerRegistry>(std::vector<std::string>{addr}),
+      "self", state, mempool, chain, table,
+      std::make_shared<VerifiedAuditCache>(
+        std::make_shared<SignatureVerifier>()),
+      proofs);
+    hb.start();
+
+    auto deadline = steady_clock::now() + seconds(10);
+    while (chain.getLastID() < 0 && steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(milliseconds(10));
+    }
+    hb.stop();
+    mempool->Stop();
+    server->Shutdown();
+
+    assert(chain.getLastID() == 0);
+    assert(proofs->Contains("m1") && proofs->Contains("m2"));
+    assert(!mempool->Contains("m1") && !mempool->Contains("m2"));
+    assert(mempool->Size() == 1 && mempool->Contains(other_id));
+    EVP_PKEY_free(key);
+  }
+  std::cout << "[Test] synced block pruned from mempool OK\n";
+
+  fs::current_path(root.parent_path());
+  fs::remove_all(root);
+  std::cout << "🎉 All HeartbeatManager tests passed\n";
+  return 0;
+}
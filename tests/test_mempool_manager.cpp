@@ -0,0 +1,507 @@
+// test_mempool_manager.cpp
+
+#include "mempool_manager.h"
+#include "canonical_audit.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <csignal>
+#include <sys/resource.h>
+
+static common::FileAudit MakeAudit(const std::string& req_id, int64_t ts) {
+  common::FileAudit a;
+  a.set_req_id(req_id);
+  a.mutable_file_info()->set_file_id("f-" + req_id);
+  a.mutable_file_info()->set_file_name("file.txt");
+  a.mutable_user_info()->set_user_id("u1");
+  a.mutable_user_info()->set_user_name("alice");
+  a.set_access_type(common::READ);
+  a.set_timestamp(ts);
+  return a;
+}
+
+// Merkle root of `audits` built from scratch
+static std::string ReferenceRoot(const std::vector<common::FileAudit>& audits,
+                                 MerkleMode mode, std::string* encoded) {
+  std::vector<Digest> leaves;
+  for (auto& a : audits) {
+    std::string payload = CanonicalAudit(a);
+    leaves.push_back(SHA256Digest(payload.data(), payload.size()));
+    if (encoded) encoded->append(payload);
+  }
+  return ComputeMerkleRoot(std::move(leaves), mode);
+}
+
+int main() {
+  const std::string testdir  = "test_mempool";
+  const std::string testpath = testdir + "/mempool.dat";
+
+  // Ensure clean slate
+  std::filesystem::remove_all(testdir);
+  std::filesystem::create_directories(testdir);
+
+  // 1) Empty start
+  {
+    MempoolManager mp(testpath);
+    assert(mp.Size() == 0);
+    assert(mp.Snapshot().empty());
+  }
+  std::cout << "[Test] Empty start OK\n";
+
+  // 2) Append, dedupe and ordering
+  {
+    MempoolManager mp(testpath);
+    assert(mp.Append(MakeAudit("b", 20)));
+    assert(mp.Append(MakeAudit("a", 20)));
+    assert(mp.Append(MakeAudit("c", 10)));
+    assert(!mp.Append(MakeAudit("a", 20)));   // duplicate req_id
+    assert(mp.Size() == 3);
+    assert(mp.Contains("a"));
+    auto snap = mp.Snapshot();
+    assert(snap.size() == 3);
+    assert(snap[0].req_id() == "c");
+    assert(snap[1].req_id() == "a");
+    assert(snap[2].req_id() == "b");
+  }
+  std::cout << "[Test] Append/ordering OK\n";
+
+  // 3) Replay on restart
+  {
+    MempoolManager mp(testpath);
+    assert(mp.Size() == 3);
+    mp.RemoveBatch({"a", "missing"});
+    assert(mp.Size() == 2);
+    assert(!mp.Contains("a"));
+  }
+  std::cout << "[Test] Replay OK\n";
+
+  // 4) Removal survives restart
+  {
+    MempoolManager mp(testpath);
+    assert(mp.Size() == 2);
+    assert(!mp.Contains("a"));
+    assert(mp.Contains("b") && mp.Contains("c"));
+  }
+  std::cout << "[Test] RemoveBatch persisted OK\n";
+
+  // 5) Segment rollover, tombstones and compaction
+  {
+    MempoolOptions opts;
+    opts.segment_bytes      = 512;   // a few records per segment
+    opts.compact_live_ratio = 0.5;
+    MempoolManager mp(testpath, opts);
+    for (int i = 0; i < 40; ++i) {
+      assert(mp.Append(MakeAudit("s" + std::to_string(i), 100 + i)));
+    }
+    assert(mp.SegmentCount() > 4);
+
+    std::vector<std::string> ids;
+    for (int i = 0; i < 30; ++i) ids.push_back("s" + std::to_string(i));
+    mp.RemoveBatch(ids);
+    size_t before = mp.SegmentCount();
+    assert(mp.Compact() > 0);
+    assert(mp.SegmentCount() < before);
+    assert(mp.Size() == 12);
+  }
+  {
+    MempoolManager mp(testpath);
+    assert(mp.Size() == 12);
+    assert(mp.Contains("b") && mp.Contains("c"));
+    assert(!mp.Contains("s0") && !mp.Contains("s29"));
+    assert(mp.Contains("s30") && mp.Contains("s39"));
+  }
+  std::cout << "[Test] Segments/compaction OK\n";
+
+  // 6) Switching to binary converts the JSON segments once
+  {
+    MempoolOptions opts;
+    opts.format = MempoolFormat::kBinary;
+    MempoolManager mp(testpath, opts);
+    assert(mp.Size() == 12);
+    assert(mp.Append(MakeAudit("bin1", 500)));
+    mp.RemoveBatch({"s30"});
+  }
+  {
+    MempoolOptions opts;
+    opts.format = MempoolFormat::kBinary;
+    MempoolManager mp(testpath, opts);
+    assert(mp.Size() == 12);
+    assert(mp.Contains("bin1") && !mp.Contains("s30"));
+  }
+  std::cout << "[Test] Binary format/conversion OK\n";
+
+  // 7) A torn tail record is dropped, earlier records survive
+  {
+    std::string seg;
+    for (auto& ent : std::filesystem::directory_iterator(testdir)) {
+      if (ent.path().string() > seg) seg = ent.path().string();
+    }
+    auto size = std::filesystem::file_size(seg);
+    std::filesystem::resize_file(seg, size - 3);   // chop the last record
+
+    MempoolOptions opts;
+    opts.format = MempoolFormat::kBinary;
+    MempoolManager mp(testpath, opts);
+    assert(mp.Contains("bin1"));
+    assert(mp.Contains("s30"));   // its tombstone was the torn record
+    assert(mp.Append(MakeAudit("after-tear", 600)));
+  }
+  {
+    MempoolOptions opts;
+    opts.format = MempoolFormat::kBinary;
+    MempoolManager mp(testpath, opts);
+    assert(mp.Contains("after-tear"));
+  }
+  std::cout << "[Test] Torn tail OK\n";
+
+  // 8) Concurrent Appends are group-committed and all survive restart
+  {
+    MempoolOptions opts;
+    opts.format = MempoolFormat::kBinary;
+    opts.group_commit_window_us = 200;
+    MempoolManager mp(testpath, opts);
+    size_t base = mp.Size();
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 8; ++t) {
+      writers.emplace_back([&mp, t]{
+        for (int i = 0; i < 100; ++i) {
+          auto id = "g" + std::to_string(t) + "-" + std::to_string(i);
+          assert(mp.Append(MakeAudit(id, 1000 + i)));
+        }
+      });
+    }
+    for (auto& w : writers) w.join();
+    assert(mp.Size() == base + 800);
+  }
+  {
+    MempoolOptions opts;
+    opts.format = MempoolFormat::kBinary;
+    MempoolManager mp(testpath, opts);
+    assert(mp.Contains("g0-0") && mp.Contains("g7-99"));
+  }
+  std::cout << "[Test] Concurrent group commit OK\n";
+
+  // 9) WaitForSize wakes on the threshold, on Wake() and on the deadline
+  {
+    MempoolManager mp(testpath);
+    size_t base = mp.Size();
+    auto far = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    std::thread producer([&mp]{
+      for (int i = 0; i < 3; ++i) mp.Append(MakeAudit("w" + std::to_string(i), 2000));
+    });
+    assert(mp.WaitForSize(base + 3, far));
+    producer.join();
+
+    std::thread waker([&mp]{ mp.Wake(); });
+    assert(!mp.WaitForSize(base + 100, far));
+    waker.join();
+
+    auto soon = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+    assert(!mp.WaitForSize(base + 100, soon));
+  }
+  std::cout << "[Test] WaitForSize OK\n";
+
+  // 10) Prefix cuts and proposed blocks reuse the cached Merkle leaves
+  for (MerkleMode mode : {MerkleMode::kHexCompat, MerkleMode::kBinary}) {
+    std::filesystem::remove_all(testdir);
+    std::filesystem::create_directories(testdir);
+    MempoolOptions opts;
+    opts.fsync       = false;
+    opts.merkle_mode = mode;
+    {
+      MempoolManager mp(testpath, opts);
+      // Mostly in order, with some late arrivals landing mid-queue
+      for (int i = 0; i < 300; ++i) {
+        int64_t ts = (i % 7 == 3) ? 3000 + i - 40 : 3000 + i;
+        assert(mp.Append(MakeAudit("m" + std::to_string(i), ts)));
+      }
+      mp.RemoveBatch({"m10", "m200"});
+
+      for (size_t limit : {size_t{1}, size_t{5}, size_t{40}, size_t{77}}) {
+        size_t n = 0;
+        auto cut = mp.CutPrefix([&](const common::FileAudit&) {
+          return n < limit ? (++n, true) : false;
+        });
+        // Long prefixes are trimmed to an aligned length
+        assert(cut.audits.size() <= limit && cut.audits.size() * 16 >= limit);
+        auto snap = mp.Snapshot();
+        std::vector<common::FileAudit> ref(snap.begin(),
+                                           snap.begin() + cut.audits.size());
+        std::string encoded;
+        assert(cut.merkle_root == ReferenceRoot(ref, mode, &encoded));
+        assert(cut.encoded == encoded);
+
+        // A follower validating the same block gets the same root
+        google::protobuf::RepeatedPtrField<common::FileAudit> block(
+          cut.audits.begin(), cut.audits.end());
+        std::vector<std::string> payloads;
+        assert(mp.BlockMerkleRoot(block, &payloads) == cut.merkle_root);
+        assert(payloads.size() == cut.audits.size());
+
+        std::vector<std::string> ids;
+        for (auto& a : cut.audits) ids.push_back(a.req_id());
+        mp.RemoveBatch(ids);
+      }
+
+      // Blocks that aren't the pending prefix, or differ from the pending
+      // copy, fall back to hashing what's not cached
+      auto snap = mp.Snapshot();
+      std::vector<common::FileAudit> mixed = {snap[3], snap[1],
+                                              MakeAudit("unknown", 1)};
+      mixed[1].set_signature("tampered");
+      google::protobuf::RepeatedPtrField<common::FileAudit> block(
+        mixed.begin(), mixed.end());
+      std::vector<std::string> payloads;
+      assert(mp.BlockMerkleRoot(block, &payloads) ==
+             ReferenceRoot(mixed, mode, nullptr));
+      assert(payloads[2] == CanonicalAudit(mixed[2]));
+    }
+    // Replay rebuilds the accumulator
+    MempoolManager mp(testpath, opts);
+    auto cut = mp.CutPrefix([](const common::FileAudit&) { return true; });
+    assert(cut.audits.size() == mp.Size());
+    assert(cut.merkle_root == ReferenceRoot(mp.Snapshot(), mode, nullptr));
+  }
+  std::cout << "[Test] Merkle prefix cuts OK\n";
+
+  // 11) Reserved prefixes leave the pending set until committed or released
+  {
+    std::filesystem::remove_all(testdir);
+    std::filesystem::create_directories(testdir);
+    MempoolOptions opts;
+    opts.fsync = false;
+    auto upTo = [](size_t limit) {
+      auto n = std::make_shared<size_t>(0);
+      return [n, limit](const common::FileAudit&) {
+        return *n < limit ? (++*n, true) : false;
+      };
+    };
+    {
+      MempoolManager mp(testpath, opts);
+      for (int i = 0; i < 100; ++i) {
+        assert(mp.Append(MakeAudit("r" + std::to_string(i), 5000 + i)));
+      }
+      auto first  = mp.ReservePrefix(upTo(32));
+      auto second = mp.ReservePrefix(upTo(32));
+      assert(first.audits.size() == 32 && second.audits.size() == 32);
+      assert(first.audits.front().req_id() == "r0");
+      assert(second.audits.front().req_id() == "r32");
+      assert(mp.Size() == 36 && mp.ReservedCount() == 64);
+      assert(mp.Contains("r0") && !mp.Append(MakeAudit("r0", 5000)));
+
+      // The next cut's root covers only what's left
+      auto rest = mp.CutPrefix([](const common::FileAudit&) { return true; });
+      assert(rest.merkle_root ==
+             ReferenceRoot(mp.Snapshot(), MerkleMode::kHexCompat, nullptr));
+
+      // Commit the first block, roll back the second
+      std::vector<std::string> ids;
+      for (auto& a : first.audits) ids.push_back(a.req_id());
+      mp.RemoveBatch(ids);
+      ids.clear();
+      for (auto& a : second.audits) ids.push_back(a.req_id());
+      mp.Release(ids);
+      assert(mp.Size() == 68 && mp.ReservedCount() == 0);
+      assert(!mp.Contains("r0") && mp.Contains("r32"));
+      auto again = mp.CutPrefix(upTo(32));
+      assert(again.merkle_root == second.merkle_root);
+
+      // Compaction keeps reserved audits in the log
+      mp.ReservePrefix(upTo(8));
+      mp.Compact();
+    }
+    MempoolManager mp(testpath, opts);
+    assert(mp.Size() == 68 && mp.Contains("r32") && !mp.Contains("r31"));
+  }
+  std::cout << "[Test] Reserve/Release OK\n";
+
+  // 12) Compact blocks are rebuilt from pending and reserved audits
+  {
+    std::filesystem::remove_all(testdir);
+    std::filesystem::create_directories(testdir);
+    MempoolOptions opts;
+    opts.fsync = false;
+    MempoolManager mp(testpath, opts);
+    for (int i = 0; i < 4; ++i) {
+      assert(mp.Append(MakeAudit("c" + std::to_string(i), 6000 + i)));
+    }
+    auto reserved = mp.ReservePrefix([](const common::FileAudit& a) {
+      return a.req_id() == "c0";
+    });
+    assert(reserved.audits.size() == 1);
+
+    google::protobuf::RepeatedPtrField<std::string> ids;
+    for (auto id : {"c2", "nope", "c0", "c3"}) *ids.Add() = id;
+    google::protobuf::RepeatedPtrField<common::FileAudit> out;
+    std::vector<int> missing;
+    mp.CopyAudits(ids, &out, &missing);
+    assert(out.size() == 4);
+    assert((missing == std::vector<int>{1}));
+    assert(out[0].req_id() == "c2" && out[2].req_id() == "c0");
+    assert(out[3].timestamp() == 6003);
+  }
+  std::cout << "[Test] CopyAudits OK\n";
+
+  // 13) Batched admission skips duplicates and shares one durability wait
+  {
+    std::filesystem::remove_all(testdir);
+    std::filesystem::create_directories(testdir);
+    {
+      MempoolManager mp(testpath);
+      assert(mp.Append(MakeAudit("b0", 7000)));
+      auto b1 = MakeAudit("b1", 7001), b2 = MakeAudit("b2", 7002);
+      auto dup = MakeAudit("b0", 7000);
+      assert(mp.AppendBatch({&b1, &dup, &b2, &b1}) == 2);
+      assert(mp.Size() == 3 && mp.Contains("b2"));
+      assert(mp.AppendBatch({}) == 0);
+    }
+    MempoolManager mp(testpath);
+    assert(mp.Size() == 3 && mp.Contains("b1"));
+  }
+  std::cout << "[Test] AppendBatch OK\n";
+
+  // 14) The req_id digest tracks pending and reserved ids; committed ids
+  //     aren't re-admitted
+  {
+    std::filesystem::remove_all(testdir);
+    std::filesystem::create_directories(testdir);
+    MempoolOptions opts;
+    opts.fsync = false;
+    MempoolManager a(testpath, opts);
+    MempoolManager b(testdir + "/other.dat", opts);
+    auto same = [&]{
+      auto x = a.IdDigest(), y = b.IdDigest();
+      assert(x.size() == MempoolManager::kIdBuckets);
+      for (size_t i = 0; i < x.size(); ++i) {
+        if (x[i].x != y[i].x || x[i].count != y[i].count) return false;
+      }
+      return true;
+    };
+    for (int i = 0; i < 50; ++i) {
+      assert(a.Append(MakeAudit("d" + std::to_string(i), 8000 + i)));
+    }
+    for (int i = 49; i >= 0; --i) {
+      assert(b.Append(MakeAudit("d" + std::to_string(i), 8000 + i)));
+    }
+    assert(same());
+
+    // Reserving doesn't change what a node holds
+    a.ReservePrefix([](const common::FileAudit& x) {
+      return x.timestamp() < 8010;
+    });
+    assert(same());
+
+    assert(b.Append(MakeAudit("extra", 9000)));
+    assert(!same());
+    uint32_t bucket = MempoolManager::IdHash("extra") % MempoolManager::kIdBuckets;
+    auto ids = b.IdsInBuckets({bucket});
+    assert(std::find(ids.begin(), ids.end(), "extra") != ids.end());
+    for (auto& id : ids) {
+      assert(MempoolManager::IdHash(id) % MempoolManager::kIdBuckets == bucket);
+    }
+
+    b.RemoveBatch({"extra", "d3", "never-held"});
+    a.RemoveBatch({"d3"});
+    assert(same());
+    assert(!b.Append(MakeAudit("extra", 9000)));
+    assert(!b.Append(MakeAudit("never-held", 9001)));
+  }
+  std::cout << "[Test] req_id digest OK\n";
+
+  // 15) A group commit that can't be written is not acknowledged
+  {
+    const std::string dir = testdir + "/failing";
+    std::filesystem::create_directories(dir);
+    bool failed = false;
+    {
+      MempoolManager mp(dir + "/mempool.dat");
+      // No segment file can be opened
+      std::filesystem::remove_all(dir);
+      assert(!mp.Append(MakeAudit("lost", 100), &failed) && failed);
+      auto l1 = MakeAudit("l1", 101), l2 = MakeAudit("l2", 102);
+      assert(mp.AppendBatch({&l1, &l2}, nullptr, &failed) == 0 && failed);
+      assert(mp.Size() == 0 && !mp.Contains("lost"));
+
+      // Writable again: the same audits are admitted, and a duplicate is
+      // refused without counting as a failure
+      std::filesystem::create_directories(dir);
+      assert(mp.Append(MakeAudit("lost", 100), &failed) && !failed);
+      assert(!mp.Append(MakeAudit("lost", 100), &failed) && !failed);
+
+      // A write error on the open segment (file size limit)
+      std::signal(SIGXFSZ, SIG_IGN);
+      rlimit saved;
+      getrlimit(RLIMIT_FSIZE, &saved);
+      rlimit capped = saved;
+      capped.rlim_cur = std::filesystem::file_size(dir + "/mempool.dat.000001")
+                        + 16;
+      setrlimit(RLIMIT_FSIZE, &capped);
+      assert(mp.AppendBatch({&l1, &l2}, nullptr, &failed) == 0 && failed);
+      setrlimit(RLIMIT_FSIZE, &saved);
+      assert(mp.Size() == 1 && !mp.Contains("l1"));
+
+      assert(mp.Append(l1, &failed) && !failed);
+      mp.Stop();
+      bool stopped = false;
+      assert(!mp.Append(l2, &stopped) && stopped);
+    }
+    // The torn write was cut off: replay sees exactly the acknowledged audits
+    MempoolManager replayed(dir + "/mempool.dat");
+    auto snap = replayed.Snapshot();
+    assert(snap.size() == 2);
+    assert(snap[0].req_id() == "lost" && snap[1].req_id() == "l1");
+  }
+  std::cout << "[Test] failed group commit OK\n";
+
+  // 16) An audit re-added once it has left the removed set survives the
+  //     compaction that carries its old tombstone forward
+  {
+    const std::string path = testdir + "/readd/mempool.dat";
+    std::filesystem::create_directories(testdir + "/readd");
+    MempoolOptions opts;
+    opts.segment_bytes      = 512;
+    opts.compact_live_ratio = 0.5;
+    {
+      MempoolManager mp(path, opts);
+      // "x" shares a segment that stays live; its tombstone lands in one
+      // that empties out
+      for (auto id : {"x", "k1", "k2", "k3", "k4"}) {
+        assert(mp.Append(MakeAudit(id, 100)));
+      }
+      std::vector<std::string> gone{"x"};
+      for (int i = 0; i < 6; ++i) {
+        std::string id = "f" + std::to_string(i);
+        assert(mp.Append(MakeAudit(id, 101)));
+        gone.push_back(id);
+      }
+      mp.RemoveBatch(gone);
+
+      // Forget "x", then add it again
+      std::vector<std::string> others;
+      for (int i = 0; i < 65536; ++i) others.push_back("o" + std::to_string(i));
+      mp.RemoveBatch(others);
+      assert(mp.Append(MakeAudit("x", 200)));
+      for (int i = 0; i < 8; ++i) {
+        assert(mp.Append(MakeAudit("g" + std::to_string(i), 102)));
+      }
+      assert(mp.Compact() > 0);
+      assert(mp.Contains("x"));
+    }
+    MempoolManager replayed(path, opts);
+    assert(replayed.Contains("x") && replayed.Size() == 13);
+    for (auto& a : replayed.Snapshot()) {
+      assert(a.req_id() != "x" || a.timestamp() == 200);
+    }
+  }
+  std::cout << "[Test] re-added audit survives compaction OK\n";
+
+  std::filesystem::remove_all(testdir);
+  std::cout << "🎉 All MempoolManager tests passed\n";
+  return 0;
+}
@@ -0,0 +1,228 @@
+// test_mempool_reconciler.cpp
+
+#include "mempool_reconciler.h"
+#include "canonical_audit.h"
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+static std::string PublicPem(EVP_PKEY* pkey) {
+  BIO* bio = BIO_new(BIO_s_mem());
+  PEM_write_bio_PUBKEY(bio, pkey);
+  BUF_MEM* mem;
+  BIO_get_mem_ptr(bio, &mem);
+  std::string pem(mem->data, mem->length);
+  BIO_free(bio);
+  return pem;
+}
+
+static void SignAudit(common::FileAudit& a, EVP_PKEY* pkey) {
+  std::string data = CanonicalAudit(a);
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, pkey);
+  EVP_DigestSignUpdate(ctx, data.data(), data.size());
+  size_t len = 0;
+  EVP_DigestSignFinal(ctx, nullptr, &len);
+  std::vector<unsigned char> sig(len);
+  EVP_DigestSignFinal(ctx, sig.data(), &len);
+  EVP_MD_CTX_free(ctx);
+
+  BIO* b64 = BIO_new(BIO_f_base64());
+  BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL);
+  BIO* mem = BIO_new(BIO_s_mem());
+  b64 = BIO_push(b64, mem);
+  BIO_write(b64, sig.data(), (int)len);
+  BIO_flush(b64);
+  BUF_MEM* bptr;
+  BIO_get_mem_ptr(b64, &bptr);
+  a.set_signature(std::string(bptr->data, bptr->length));
+  BIO_free_all(b64);
+  a.set_public_key(PublicPem(pkey));
+}
+
+static common::FileAudit MakeAudit(int i, EVP_PKEY* pkey) {
+  common::FileAudit a;
+  a.set_req_id("ae" + std::to_string(i));
+  a.mutable_file_info()->set_file_id("f" + std::to_string(i));
+  a.mutable_file_info()->set_file_name("file.txt");
+  a.mutable_user_info()->set_user_id("u1");
+  a.mutable_user_info()->set_user_name("alice");
+  a.set_access_type(common::READ);
+  a.set_timestamp(1700000000000 + i);
+  SignAudit(a, pkey);
+  return a;
+}
+
+// Serves the anti-entropy RPCs from a real mempool, like the node does
+class FakePeer final : public blockchain::BlockChainService::Service {
+public:
+  explicit FakePeer(std::shared_ptr<MempoolManager> mp) : mp_(std::move(mp)) {}
+
+  grpc::Status GetMempoolDigest(grpc::ServerContext*,
+                                const blockchain::MempoolDigestRequest*,
+                                blockchain::MempoolDigest* resp) override {
+    for (auto& b : mp_->IdDigest()) {
+      resp->add_bucket_xor(b.x);
+      resp->add_bucket_count(b.count);
+    }
+    return grpc::Status::OK;
+  }
+
+  grpc::Status GetBucketIds(grpc::ServerContext*,
+                            const blockchain::BucketIdsRequest* req,
+                            blockchain::BucketIds* resp) override {
+    std::vector<uint32_t> b(req->buckets().begin(), req->buckets().end());
+    for (auto& id : mp_->IdsInBuckets(b)) resp->add_req_ids(id);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status FetchAudits(grpc::ServerContext*,
+                           const blockchain::FetchAuditsRequest* req,
+                           blockchain::WhisperBatch* resp) override {
+    ++fetches;
+    std::vector<int> missing;
+    mp_->CopyAudits(req->req_ids(), resp->mutable_audits(), &missing);
+    return grpc::Status::OK;
+  }
+
+  int fetches = 0;
+
+private:
+  std::shared_ptr<MempoolManager> mp_;
+};
+
+static bool SameDigest(MempoolManager& a, MempoolManager& b) {
+  auto x = a.IdDigest(), y = b.IdDigest();
+  for (size_t i = 0; i < x.size(); ++i) {
+    if (x[i].x != y[i].x || x[i].count != y[i].count) return false;
+  }
+  return true;
+}
+
+int main() {
+  const std::string dir = "test_reconciler";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir + "/blocks");
+
+  EVP_PKEY* pkey = nullptr;
+  EVP_PKEY_CTX* kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+  EVP_PKEY_keygen_init(kctx);
+  EVP_PKEY_CTX_set_rsa_keygen_bits(kctx, 2048);
+  EVP_PKEY_keygen(kctx, &pkey);
+  EVP_PKEY_CTX_free(kctx);
+
+  MempoolOptions opts;
+  opts.fsync = false;
+  auto theirs = std::make_shared<MempoolManager>(dir + "/theirs.dat", opts);
+  auto ours   = std::make_shared<MempoolManager>(dir + "/ours.dat", opts);
+  auto proofs = std::make_shared<AuditProofStore>(dir + "/blocks",
+                                                  MerkleMode::kHexCompat);
+  auto cache  = std::make_shared<VerifiedAuditCache>(
+    std::make_shared<SignatureVerifier>());
+
+  FakePeer peer(theirs);
+  int port = 0;
+  grpc::ServerBuilder b;
+  b.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+  b.RegisterService(&peer);
+  auto server = b.BuildAndStart();
+  std::vector<std::string> addrs = {"127.0.0.1:" + std::to_string(port),
+                                    "127.0.0.1:1"};
+  auto peers = std::make_shared<PeerRegistry>(addrs);
+
+  std::vector<common::FileAudit> audits;
+  for (int i = 0; i < 300; ++i) audits.push_back(MakeAudit(i, pkey));
+  for (int i = 0; i < 300; ++i) assert(theirs->Append(audits[i]));
+  for (int i = 0; i < 100; ++i) assert(ours->Append(audits[i]));
+
+  // 1) The missing audits are pulled, in chunks, up to max_pull a round
+  {
+    ReconcileOptions ro;
+    ro.max_pull    = 150;
+    ro.fetch_batch = 64;
+    MempoolReconciler rc(peers, ours, cache, proofs, ro);
+    assert(rc.PullFrom(0) == 150);
+    assert(peer.fetches == 3);
+    assert(rc.PullFrom(0) == 50);
+    assert(ours->Size() == 300 && SameDigest(*ours, *theirs));
+
+    // Converged: one digest, nothing else
+    int fetches = peer.fetches;
+    assert(rc.PullFrom(0) == 0 && peer.fetches == fetches);
+    auto s = rc.GetStats();
+    assert(s.rounds == 3 && s.pulled == 200 && s.failed_rounds == 0);
+  }
+  std::cout << "[Test] pull missing audits OK\n";
+
+  // 2) Committed and badly signed audits are not pulled
+  {
+    std::vector<std::string> committed = {audits[0].req_id(),
+                                          audits[1].req_id()};
+    ours->RemoveBatch(committed);
+    blockchain::Block blk;
+    blk.set_id(0);
+    blk.set_hash("h0");
+    std::vector<Digest> leaves;
+    for (int i = 0; i < 2; ++i) {
+      *blk.add_audits() = audits[i];
+      std::string payload = CanonicalAudit(audits[i]);
+      leaves.push_back(SHA256Digest(payload.data(), payload.size()));
+    }
+    blk.set_merkle_root(ComputeMerkleRoot(std::move(leaves),
+                                          MerkleMode::kHexCompat));
+    assert(proofs->Record(blk));
+
+    auto forged = MakeAudit(1000, pkey);
+    forged.set_timestamp(1);   // no longer matches its signature
+    assert(theirs->Append(forged));
+
+    MempoolReconciler rc(peers, ours, cache, proofs);
+    assert(rc.PullFrom(0) == 0);
+    auto s = rc.GetStats();
+    assert(s.rejected == 1 && s.buckets_differed >= 1);
+    assert(!ours->Contains(audits[0].req_id()) && !ours->Contains("ae1000"));
+  }
+  std::cout << "[Test] committed/forged audits skipped OK\n";
+
+  // 3) An unreachable peer fails the round
+  {
+    ReconcileOptions ro;
+    ro.rpc_timeout = std::chrono::milliseconds(200);
+    MempoolReconciler rc(peers, ours, cache, proofs, ro);
+    assert(rc.PullFrom(1) == 0);
+    assert(rc.GetStats().failed_rounds == 1);
+  }
+  std::cout << "[Test] unreachable peer OK\n";
+
+  // 4) The background rounds converge on their own
+  {
+    auto extra = MakeAudit(2000, pkey);
+    assert(theirs->Append(extra));
+    ReconcileOptions ro;
+    ro.interval    = std::chrono::milliseconds(20);
+    ro.rpc_timeout = std::chrono::milliseconds(200);
+    MempoolReconciler rc(std::make_shared<PeerRegistry>(
+                           std::vector<std::string>{addrs[0]}),
+                         ours, cache, proofs, ro);
+    rc.start();
+    for (int i = 0; i < 250 && !ours->Contains("ae2000"); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    rc.stop();
+    assert(ours->Contains("ae2000"));
+  }
+  std::cout << "[Test] background rounds OK\n";
+
+  server->Shutdown();
+  theirs->Stop();
+  ours->Stop();
+  EVP_PKEY_free(pkey);
+  std::filesystem::remove_all(dir);
+  std::cout << "🎉 All MempoolReconciler tests passed\n";
+  return 0;
+}
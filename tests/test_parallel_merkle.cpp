@@ -0,0 +1,57 @@
+// test_parallel_merkle.cpp
+
+#include "parallel_merkle.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::vector<Digest> Leaves(size_t n) {
+  std::vector<Digest> leaves;
+  leaves.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    std::string payload = "leaf-" + std::to_string(i);
+    leaves.push_back(SHA256Digest(payload.data(), payload.size()));
+  }
+  return leaves;
+}
+
+int main() {
+  // Sizes around run boundaries (runs are 2^k >= 256 leaves), odd tails
+  // and single-leaf last runs
+  const std::vector<size_t> sizes = {
+    0, 1, 2, 3, 255, 256, 257, 511, 512, 513, 767, 1024, 1025,
+    2047, 2048, 2049, 4097, 6000, 8191, 16385, 40000, 100003};
+  const auto all = Leaves(sizes.back());
+
+  for (MerkleMode mode : {MerkleMode::kHexCompat, MerkleMode::kBinary}) {
+    for (size_t threads : {1, 2, 3, 7}) {
+      WorkerPool pool(threads);
+      for (size_t n : sizes) {
+        std::vector<Digest> leaves(all.begin(), all.begin() + n);
+        std::string serial = ComputeMerkleRoot(leaves, mode);
+        // Force the parallel path even for small trees
+        assert(ParallelMerkleRoot(leaves, mode, &pool, 1) == serial);
+        assert(ParallelMerkleRoot(leaves, mode, &pool) == serial);
+      }
+    }
+    std::vector<Digest> leaves(all.begin(), all.begin() + 5000);
+    assert(ParallelMerkleRoot(leaves, mode, nullptr) ==
+           ComputeMerkleRoot(leaves, mode));
+  }
+  std::cout << "[Test] parallel roots match serial OK\n";
+
+  // Hex-compatible mode still reproduces the hex-string reference
+  {
+    WorkerPool pool(3);
+    std::vector<Digest>      leaves(all.begin(), all.begin() + 3001);
+    std::vector<std::string> hexes;
+    for (auto& d : leaves) hexes.push_back(DigestToHex(d));
+    assert(ParallelMerkleRoot(leaves, MerkleMode::kHexCompat, &pool, 1) ==
+           ComputeMerkleRoot(hexes));
+  }
+  std::cout << "[Test] hex reference OK\n";
+
+  std::cout << "🎉 All ParallelMerkleRoot tests passed\n";
+  return 0;
+}
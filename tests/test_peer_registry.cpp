@@ -0,0 +1,138 @@
+// test_peer_registry.cpp
+
+#include "peer_registry.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std::chrono;
+
+// Answers heartbeats, optionally after a delay, and counts whispered bytes
+class FakePeer final : public blockchain::BlockChainService::Service {
+public:
+  milliseconds        delay{0};
+  std::atomic<size_t> bytes{0};
+
+  grpc::Status SendHeartbeat(grpc::ServerContext*,
+                             const blockchain::HeartbeatRequest*,
+                             blockchain::HeartbeatResponse*) override {
+    std::this_thread::sleep_for(delay);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status WhisperAuditBatch(grpc::ServerContext*,
+                                 const blockchain::WhisperBatch* req,
+                                 blockchain::WhisperBatchResponse* resp) override {
+    bytes += req->ByteSizeLong();
+    resp->set_status("success");
+    return grpc::Status::OK;
+  }
+};
+
+struct Node {
+  FakePeer                      peer;
+  std::unique_ptr<grpc::Server> server;
+  std::string                   addr;
+
+  explicit Node(const PeerRegistry& reg) {
+    int port = 0;
+    grpc::ServerBuilder b;
+    b.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(),
+                       &port);
+    reg.ConfigureServer(b);
+    b.RegisterService(&peer);
+    server = b.BuildAndStart();
+    addr = "127.0.0.1:" + std::to_string(port);
+  }
+  ~Node() { server->Shutdown(); }
+};
+
+static grpc::Status Ping(PeerRegistry& reg, size_t i) {
+  grpc::ClientContext ctx;
+  ctx.set_deadline(system_clock::now() + milliseconds(500));
+  blockchain::HeartbeatResponse resp;
+  auto t0 = steady_clock::now();
+  auto st = reg.Stub(i)->SendHeartbeat(&ctx, blockchain::HeartbeatRequest(),
+                                       &resp);
+  reg.Report(i, st, steady_clock::now() - t0);
+  return st;
+}
+
+int main() {
+  PeerRegistry server_cfg({});
+  Node fast(server_cfg), slow(server_cfg);
+  slow.peer.delay = milliseconds(30);
+
+  // 1) Calls go through the shared stubs and their RTT is tracked
+  {
+    PeerRegistry reg({slow.addr, fast.addr});
+    assert(reg.Size() == 2 && reg.Addr(1) == fast.addr);
+    assert(reg.Stubs().size() == 2 && reg.Stubs()[0].get() == reg.Stub(0));
+    for (int i = 0; i < 3; ++i) {
+      assert(Ping(reg, 0).ok() && Ping(reg, 1).ok());
+    }
+    assert(reg.Rtt(0) >= milliseconds(30) && reg.Rtt(1) < reg.Rtt(0));
+    auto order = reg.Ordered();
+    assert(order[0] == 1 && order[1] == 0);
+    auto stats = reg.GetStats();
+    assert(stats[0].addr == slow.addr && stats[0].calls == 3);
+    assert(stats[0].up && stats[0].failures == 0);
+  }
+  std::cout << "[Test] shared stubs and RTT OK\n";
+
+  // 2) Repeated transport failures mark a peer down; a success revives it
+  {
+    PeerOptions opts;
+    opts.down_after_failures = 2;
+    PeerRegistry reg({fast.addr, slow.addr}, opts);
+
+    grpc::Status unavailable(grpc::StatusCode::UNAVAILABLE, "");
+    reg.Report(0, unavailable, milliseconds(0));
+    assert(reg.IsUp(0));
+    reg.Report(0, grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED, ""),
+               milliseconds(0));
+    assert(!reg.IsUp(0) && reg.IsUp(1));
+    assert(reg.Ordered()[0] == 1);    // down peers go last despite RTT
+
+    // An application error still means the peer answered
+    reg.Report(0, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, ""),
+               milliseconds(1));
+    assert(reg.IsUp(0) && reg.Rtt(0) == milliseconds(1));
+    assert(reg.GetStats()[0].failures == 2);
+  }
+  std::cout << "[Test] down/up marking OK\n";
+
+  // 3) An unreachable peer is marked down by the calls that fail on it
+  {
+    PeerRegistry reg({"127.0.0.1:1", fast.addr});
+    assert(!Ping(reg, 0).ok() && !Ping(reg, 0).ok());
+    assert(!reg.IsUp(0) && reg.IsUp(1));
+  }
+  std::cout << "[Test] unreachable peer OK\n";
+
+  // 4) Messages past gRPC's 4 MiB default pass with a raised limit
+  {
+    PeerRegistry reg({fast.addr});
+    blockchain::WhisperBatch big;
+    big.add_audits()->set_req_id(std::string(6 * 1024 * 1024, 'x'));
+    grpc::ClientContext ctx;
+    blockchain::WhisperBatchResponse resp;
+    auto st = reg.Stub(0)->WhisperAuditBatch(&ctx, big, &resp);
+    assert(st.ok() && resp.status() == "success");
+    assert(fast.peer.bytes > 6u * 1024 * 1024);
+
+    PeerOptions small;
+    small.max_message_bytes = 1024 * 1024;
+    PeerRegistry capped({fast.addr}, small);
+    grpc::ClientContext ctx2;
+    st = capped.Stub(0)->WhisperAuditBatch(&ctx2, big, &resp);
+    assert(st.error_code() == grpc::StatusCode::RESOURCE_EXHAUSTED);
+  }
+  std::cout << "[Test] max message size OK\n";
+
+  std::cout << "🎉 All PeerRegistry tests passed\n";
+  return 0;
+}
@@ -0,0 +1,106 @@
+// test_rpc_executor.cpp
+
+#include "rpc_executor.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <thread>
+
+using namespace std::chrono;
+
+// Blocks tasks until opened
+struct Gate {
+  std::promise<void>       p;
+  std::shared_future<void> f{p.get_future().share()};
+  void open() { p.set_value(); }
+  void wait() const { f.wait(); }
+};
+
+int main() {
+  // 1) Tasks run on the executor's threads, several at once
+  {
+    RpcExecutor exec("test", 4, 0);
+    exec.start();
+    std::atomic<int> running{0}, peak{0}, done{0};
+    Gate gate;
+    for (int i = 0; i < 4; ++i) {
+      assert(exec.Submit([&] {
+        int now = ++running;
+        int prev = peak.load();
+        while (now > prev && !peak.compare_exchange_weak(prev, now)) {}
+        gate.wait();
+        --running;
+        ++done;
+      }));
+    }
+    auto deadline = steady_clock::now() + seconds(5);
+    while (peak < 4 && steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(milliseconds(1));
+    }
+    assert(peak == 4);
+    gate.open();
+    exec.stop();
+    assert(done == 4 && exec.GetStats().completed == 4);
+  }
+  std::cout << "[Test] concurrent tasks OK\n";
+
+  // 2) A full queue refuses calls instead of growing
+  {
+    RpcExecutor exec("test", 1, 3);
+    exec.start();
+    Gate gate;
+    std::promise<void> started;
+    exec.Submit([&] { started.set_value(); gate.wait(); });
+    started.get_future().wait();     // the one thread is busy
+
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 3; ++i) assert(exec.Submit([&] { ++ran; }));
+    assert(!exec.Submit([&] { ++ran; }));
+    auto st = exec.GetStats();
+    assert(st.queued == 3 && st.peak_queued == 3 && st.rejected == 1);
+
+    gate.open();
+    exec.stop();
+    assert(ran == 3 && exec.GetStats().completed == 4);
+    assert(!exec.Submit([] {}));     // stopped
+  }
+  std::cout << "[Test] queue limit OK\n";
+
+  // 3) A saturated executor does not hold up another one
+  {
+    RpcExecutor data("data", 2, 0), control("control", 1, 0);
+    data.start();
+    control.start();
+    Gate gate;
+    for (int i = 0; i < 50; ++i) data.Submit([&] { gate.wait(); });
+
+    std::promise<void> beat;
+    auto t0 = steady_clock::now();
+    control.Submit([&] { beat.set_value(); });
+    assert(beat.get_future().wait_for(seconds(5)) == std::future_status::ready);
+    assert(steady_clock::now() - t0 < seconds(1));
+    assert(data.GetStats().queued >= 48);   // still stuck behind the gate
+
+    gate.open();
+    data.stop();
+    control.stop();
+    assert(data.GetStats().completed == 50);
+  }
+  std::cout << "[Test] plane isolation OK\n";
+
+  // 4) Stopping an executor that never started still runs its tasks
+  {
+    RpcExecutor exec("test", 2, 0);
+    int ran = 0;
+    exec.Submit([&] { ++ran; });
+    exec.Submit([&] { ++ran; });
+    exec.stop();
+    assert(ran == 2);
+  }
+  std::cout << "[Test] stop drains queue OK\n";
+
+  std::cout << "🎉 All RpcExecutor tests passed\n";
+  return 0;
+}
@@ -0,0 +1,113 @@
+// test_signature_verifier.cpp
+
+#include "signature_verifier.h"
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct TestKey {
+  EVP_PKEY*   pkey;
+  std::string pub_pem;
+};
+
+static TestKey MakeKey() {
+  EVP_PKEY* pkey = EVP_RSA_gen(2048);
+  assert(pkey);
+  BIO* bio = BIO_new(BIO_s_mem());
+  PEM_write_bio_PUBKEY(bio, pkey);
+  BUF_MEM* mem;
+  BIO_get_mem_ptr(bio, &mem);
+  std::string pem(mem->data, mem->length);
+  BIO_free(bio);
+  return {pkey, pem};
+}
+
+static std::string Sign(const TestKey& k, const std::string& data) {
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, k.pkey);
+  EVP_DigestSignUpdate(ctx, data.data(), data.size());
+  size_t len = 0;
+  EVP_DigestSignFinal(ctx, nullptr, &len);
+  std::vector<unsigned char> sig(len);
+  EVP_DigestSignFinal(ctx, sig.data(), &len);
+  EVP_MD_CTX_free(ctx);
+
+  BIO* b64 = BIO_new(BIO_f_base64());
+  BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL);
+  BIO* mem = BIO_new(BIO_s_mem());
+  b64 = BIO_push(b64, mem);
+  BIO_write(b64, sig.data(), (int)len);
+  BIO_flush(b64);
+  BUF_MEM* bptr;
+  BIO_get_mem_ptr(b64, &bptr);
+  std::string out(bptr->data, bptr->length);
+  BIO_free_all(b64);
+  return out;
+}
+
+int main() {
+  TestKey k1 = MakeKey(), k2 = MakeKey(), k3 = MakeKey();
+  const std::string payload = R"({"req_id":"r1","timestamp":1})";
+
+  // 1) Valid and invalid signatures
+  SignatureVerifier v(2);
+  std::string s1 = Sign(k1, payload);
+  assert(v.Verify(payload, s1, k1.pub_pem));
+  assert(!v.Verify(payload + " ", s1, k1.pub_pem));
+  assert(!v.Verify(payload, s1, k2.pub_pem));
+  assert(!v.Verify(payload, "not base64!", k1.pub_pem));
+  assert(!v.Verify(payload, s1, "not a pem"));
+  std::cout << "[Test] Verify OK\n";
+
+  // 2) Repeat keys hit the cache
+  auto st = v.GetStats();
+  assert(st.misses == 3);   // k1, k2, bad PEM
+  assert(st.hits   == 2);
+  assert(st.size   == 2);
+  std::cout << "[Test] Cache hits OK\n";
+
+  // 3) Least recently used key is evicted
+  assert(v.Verify(payload, s1, k1.pub_pem));             // k1 most recent
+  assert(v.Verify(payload, Sign(k3, payload), k3.pub_pem));  // evicts k2
+  st = v.GetStats();
+  assert(st.evictions == 1 && st.size == 2);
+  uint64_t misses = st.misses;
+  assert(v.Verify(payload, s1, k1.pub_pem));
+  assert(v.GetStats().misses == misses);
+  assert(!v.Verify(payload, s1, k2.pub_pem));
+  assert(v.GetStats().misses == misses + 1);
+  std::cout << "[Test] LRU eviction OK\n";
+
+  // 4) Concurrent verification with shared keys
+  SignatureVerifier shared(8);
+  std::string s2 = Sign(k2, payload);
+  std::atomic<int> ok{0};
+  std::vector<std::thread> ts;
+  for (int t = 0; t < 8; ++t) {
+    ts.emplace_back([&, t] {
+      for (int i = 0; i < 50; ++i) {
+        bool even = (t + i) % 2 == 0;
+        if (shared.Verify(payload, even ? s1 : s2,
+                          even ? k1.pub_pem : k2.pub_pem)) ++ok;
+      }
+    });
+  }
+  for (auto& t : ts) t.join();
+  assert(ok == 400);
+  st = shared.GetStats();
+  assert(st.hits + st.misses == 400 && st.size == 2);
+  std::cout << "[Test] Concurrent verify OK\n";
+
+  EVP_PKEY_free(k1.pkey);
+  EVP_PKEY_free(k2.pkey);
+  EVP_PKEY_free(k3.pkey);
+  std::cout << "🎉 All SignatureVerifier tests passed\n";
+  return 0;
+}
@@ -0,0 +1,159 @@
+// test_verified_audit_cache.cpp
+
+#include "verified_audit_cache.h"
+#include "canonical_audit.h"
+#include "audit_envelope.h"
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+static std::string PublicPem(EVP_PKEY* pkey) {
+  BIO* bio = BIO_new(BIO_s_mem());
+  PEM_write_bio_PUBKEY(bio, pkey);
+  BUF_MEM* mem;
+  BIO_get_mem_ptr(bio, &mem);
+  std::string pem(mem->data, mem->length);
+  BIO_free(bio);
+  return pem;
+}
+
+static std::string Sign(const std::string& data, EVP_PKEY* pkey) {
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, pkey);
+  EVP_DigestSignUpdate(ctx, data.data(), data.size());
+  size_t len = 0;
+  EVP_DigestSignFinal(ctx, nullptr, &len);
+  std::vector<unsigned char> sig(len);
+  EVP_DigestSignFinal(ctx, sig.data(), &len);
+  EVP_MD_CTX_free(ctx);
+
+  BIO* b64 = BIO_new(BIO_f_base64());
+  BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL);
+  BIO* mem = BIO_new(BIO_s_mem());
+  b64 = BIO_push(b64, mem);
+  BIO_write(b64, sig.data(), (int)len);
+  BIO_flush(b64);
+  BUF_MEM* bptr;
+  BIO_get_mem_ptr(b64, &bptr);
+  std::string out(bptr->data, bptr->length);
+  BIO_free_all(b64);
+  return out;
+}
+
+static void SignAudit(common::FileAudit& a, EVP_PKEY* pkey) {
+  a.set_signature(Sign(CanonicalAudit(a), pkey));
+  a.set_public_key(PublicPem(pkey));
+}
+
+static common::FileAudit MakeAudit(const std::string& req_id, EVP_PKEY* pkey) {
+  common::FileAudit a;
+  a.set_req_id(req_id);
+  a.mutable_file_info()->set_file_id("f-" + req_id);
+  a.mutable_file_info()->set_file_name("file.txt");
+  a.mutable_user_info()->set_user_id("u1");
+  a.mutable_user_info()->set_user_name("alice");
+  a.set_access_type(common::READ);
+  a.set_timestamp(1700000000000);
+  SignAudit(a, pkey);
+  return a;
+}
+
+int main() {
+  EVP_PKEY* k1 = EVP_RSA_gen(2048);
+  EVP_PKEY* k2 = EVP_RSA_gen(2048);
+  auto verifier = std::make_shared<SignatureVerifier>();
+
+  // 1) First check verifies, repeats hit the cache
+  VerifiedAuditCache cache(verifier, 2);
+  auto a1 = MakeAudit("r1", k1);
+  assert(cache.Verify(a1));
+  assert(cache.Verify(a1, CanonicalAudit(a1)));
+  auto st = cache.GetStats();
+  assert(st.misses == 1 && st.hits == 1 && st.size == 1);
+  std::cout << "[Test] Cache hit OK\n";
+
+  // 2) Tampered content, signature or claimed key miss and fail
+  auto tampered = a1;
+  tampered.mutable_file_info()->set_file_name("other.txt");
+  assert(!cache.Verify(tampered));
+  auto rekeyed = a1;
+  rekeyed.set_public_key(PublicPem(k2));
+  assert(!cache.Verify(rekeyed));
+  auto resigned = a1;
+  resigned.set_signature(MakeAudit("r2", k1).signature());
+  assert(!cache.Verify(resigned));
+  st = cache.GetStats();
+  assert(st.failures == 3 && st.size == 1);
+  std::cout << "[Test] Tampering detected OK\n";
+
+  // 3) Bounded: oldest verified audit is evicted and re-verified
+  auto a2 = MakeAudit("r2", k2);
+  auto a3 = MakeAudit("r3", k1);
+  assert(cache.Verify(a2));
+  assert(cache.Verify(a3));
+  st = cache.GetStats();
+  assert(st.evictions == 1 && st.size == 2);
+  uint64_t misses = st.misses;
+  assert(cache.Verify(a1));
+  assert(cache.GetStats().misses == misses + 1);
+  std::cout << "[Test] LRU eviction OK\n";
+
+  // 4) Batch verification on a pool stops at an invalid audit
+  auto pool = std::make_shared<WorkerPool>(4);
+  VerifiedAuditCache pooled(verifier, 1024, pool);
+  google::protobuf::RepeatedPtrField<common::FileAudit> block;
+  for (int i = 0; i < 64; ++i) {
+    *block.Add() = MakeAudit("b" + std::to_string(i), i % 2 ? k1 : k2);
+  }
+  assert(pooled.VerifyBatch(block) == 64);
+  assert(pooled.GetStats().misses == 64);
+  assert(pooled.VerifyBatch(block) == 64);       // all cached now
+  assert(pooled.GetStats().hits == 64);
+  block.Mutable(40)->set_timestamp(1);
+  assert(pooled.VerifyBatch(block) == 40);
+  std::cout << "[Test] Parallel batch OK\n";
+
+  // 5) An envelope's audits cost one RSA verify between them
+  {
+    common::AuditEnvelope env;
+    for (int i = 0; i < 5; ++i) {
+      auto a = MakeAudit("e" + std::to_string(i), k1);
+      a.clear_signature();
+      a.clear_public_key();
+      *env.add_audits() = a;
+    }
+    std::string root = EnvelopeRoot(env.audits());
+    env.set_signature(Sign(root, k1));
+    env.set_public_key(PublicPem(k1));
+    google::protobuf::RepeatedPtrField<common::FileAudit> opened;
+    assert(OpenEnvelope(env, &opened) == root && opened.size() == 5);
+
+    VerifiedAuditCache ec(verifier, 1024);
+    assert(ec.VerifyBatch(opened) == 5);
+    assert(ec.GetStats().misses == 1);
+
+    // Changed content or index, or another signer's root signature, fail;
+    // only the last needs an RSA check
+    auto changed = opened[2];
+    changed.set_timestamp(1);
+    assert(!ec.Verify(changed));
+    auto moved = opened[2];
+    moved.set_envelope_index(3);
+    assert(!ec.Verify(moved));
+    auto forged = opened[0];
+    forged.set_signature(Sign(root, k2));
+    assert(!ec.Verify(forged));
+    st = ec.GetStats();
+    assert(st.misses == 2 && st.failures == 3);
+  }
+  std::cout << "[Test] Envelope verification OK\n";
+
+  EVP_PKEY_free(k1);
+  EVP_PKEY_free(k2);
+  std::cout << "🎉 All VerifiedAuditCache tests passed\n";
+  return 0;
+}
@@ -0,0 +1,51 @@
+// test_worker_pool.cpp
+
+#include "worker_pool.h"
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+  WorkerPool pool(4);
+  assert(pool.Size() == 4);
+
+  // 1) Every index runs exactly once
+  std::vector<std::atomic<int>> hits(10000);
+  pool.ParallelFor(hits.size(), [&](size_t i) { ++hits[i]; }, 7);
+  for (auto& h : hits) assert(h == 1);
+  assert(pool.ParallelAll(0, [](size_t) { return false; }) == 0);
+  std::cout << "[Test] ParallelFor OK\n";
+
+  // 2) A failure is reported and stops the remaining work
+  std::atomic<size_t> calls{0};
+  size_t bad = pool.ParallelAll(100000, [&](size_t i) {
+    ++calls;
+    return i != 100;
+  });
+  assert(bad == 100);
+  assert(calls < 100000);
+  std::cout << "[Test] Short-circuit OK\n";
+
+  // 3) Concurrent callers share the pool
+  std::vector<std::thread> callers;
+  std::atomic<int> ok{0};
+  for (int c = 0; c < 8; ++c) {
+    callers.emplace_back([&, c] {
+      std::atomic<size_t> sum{0};
+      size_t r = pool.ParallelAll(1000, [&](size_t i) {
+        sum += i;
+        return c % 2 == 0 || i != 999;
+      }, 3);
+      if (c % 2 == 0 && r == 1000 && sum == 999 * 1000 / 2) ++ok;
+      if (c % 2 == 1 && r == 999) ++ok;
+    });
+  }
+  for (auto& t : callers) t.join();
+  assert(ok == 8);
+  std::cout << "[Test] Concurrent jobs OK\n";
+
+  std::cout << "🎉 All WorkerPool tests passed\n";
+  return 0;
+}